@@ -0,0 +1,25 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+
+#include "libutil.h"
+
+typedef void bench_fn(void *ctx);
+
+/**
+ * Results are folded into this so the compiler can't discard benchmarked work.
+ */
+extern volatile size_t bench_sink;
+
+/**
+ * bench_run times `iters` calls of `fn` and prints the time per call and, if
+ * `bytes_per_iter` is nonzero, the throughput.
+ */
+void bench_run(const char *name, bench_fn *fn, void *ctx, size_t iters,
+               size_t bytes_per_iter);
+
+void run_str_benches(void);
+void run_hashmap_benches(void);
+
+#endif /* BENCH_H */
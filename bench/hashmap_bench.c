@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+typedef struct {
+  array_t *keys;
+  hashmap_t *map;
+  size_t next;
+} hashmap_bench_ctx;
+
+static void bench_array_find(void *ctx) {
+  hashmap_bench_ctx *c = ctx;
+  char *key = array_get(c->keys, c->next++ % array_size(c->keys));
+  bench_sink += array_find(c->keys, (comparator_t *)str_comparator, key);
+}
+
+static void bench_hashmap_get(void *ctx) {
+  hashmap_bench_ctx *c = ctx;
+  char *key = array_get(c->keys, c->next++ % array_size(c->keys));
+  bench_sink += (size_t)hashmap_get(c->map, key);
+}
+
+static void bench_hashmap_get_int(void *ctx) {
+  hashmap_bench_ctx *c = ctx;
+  size_t key = c->next++ % array_size(c->keys);
+  bench_sink += (size_t)hashmap_get(c->map, (void *)key);
+}
+
+static void bench_hashmap_set_delete(void *ctx) {
+  hashmap_bench_ctx *c = ctx;
+  char *key = array_get(c->keys, c->next++ % array_size(c->keys));
+  hashmap_delete(c->map, key);
+  bench_sink += hashmap_set(c->map, key, key);
+}
+
+static void bench_lookup(size_t n) {
+  hashmap_bench_ctx ctx = {
+      .keys = array_init(),
+      .map = hashmap_init(HASHMAP_KEY_STR, NULL),
+  };
+  hashmap_t *ints = hashmap_init(HASHMAP_KEY_INT, NULL);
+
+  for (size_t i = 0; i < n; i++) {
+    char *key = s_fmt("user-%zu", i * 7919);
+    array_push(ctx.keys, key);
+    hashmap_set(ctx.map, key, (void *)(i + 1));
+    hashmap_set(ints, (void *)i, (void *)(i + 1));
+  }
+
+  char name[64];
+  snprintf(name, sizeof(name), "array_find (%zu str keys)", n);
+  bench_run(name, bench_array_find, &ctx, n < 1000 ? 1000000 : 20000, 0);
+  snprintf(name, sizeof(name), "hashmap_get (%zu str keys)", n);
+  bench_run(name, bench_hashmap_get, &ctx, 1000000, 0);
+  snprintf(name, sizeof(name), "hashmap_set + delete (%zu str keys)", n);
+  bench_run(name, bench_hashmap_set_delete, &ctx, 1000000, 0);
+
+  hashmap_t *strs = ctx.map;
+  ctx.map = ints;
+  snprintf(name, sizeof(name), "hashmap_get (%zu int keys)", n);
+  bench_run(name, bench_hashmap_get_int, &ctx, 1000000, 0);
+
+  hashmap_free(strs);
+  hashmap_free(ints);
+  array_free(ctx.keys, free);
+}
+
+void run_hashmap_benches(void) {
+  bench_lookup(16);
+  bench_lookup(10000);
+}
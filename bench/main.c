@@ -0,0 +1,37 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "bench.h"
+
+volatile size_t bench_sink;
+
+static double bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void bench_run(const char *name, bench_fn *fn, void *ctx, size_t iters,
+               size_t bytes_per_iter) {
+  // One untimed call to warm caches
+  fn(ctx);
+
+  double start = bench_now();
+  for (size_t i = 0; i < iters; i++) {
+    fn(ctx);
+  }
+  double elapsed = bench_now() - start;
+
+  printf("%-40s %12.0f ns/op", name, elapsed / iters * 1e9);
+  if (bytes_per_iter > 0) {
+    printf(" %10.1f MB/s", bytes_per_iter * iters / elapsed / 1e6);
+  }
+  printf("\n");
+}
+
+int main(void) {
+  run_str_benches();
+  run_hashmap_benches();
+
+  return 0;
+}
@@ -0,0 +1,530 @@
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "bench.h"
+
+// Padding on each side of the trim benchmark's input
+#define TRIM_BENCH_PAD 4096
+#define SPLIT_BENCH_SZ (16 * 1024 * 1024)
+#define SEARCH_BENCH_SZ (16 * 1024 * 1024)
+
+typedef struct {
+  const char *input;
+  char *scratch;
+  size_t len;
+} trim_bench_ctx;
+
+typedef struct {
+  const char *haystack;
+  size_t len;
+  const char *target;
+  s_needle_t *needle;
+} search_bench_ctx;
+
+static bool is_ascii_space(char b) {
+  return b == ' ' || b == '\t' || b == '\n' || b == '\r';
+}
+
+// The original s_trim, which copies the string once per whitespace character
+// removed
+static char *naive_trim(const char *s) {
+  char *scp = s_copy(s);
+
+  while (strlen(scp) > 0 && is_ascii_space(scp[0])) {
+    char *nscp = s_substr(scp, 1, strlen(scp), true);
+    free(scp);
+    scp = nscp;
+  }
+
+  while (strlen(scp) > 0 && is_ascii_space(scp[strlen(scp) - 1])) {
+    char *nscp = s_substr(scp, 0, strlen(scp) - 1, false);
+    free(scp);
+    scp = nscp;
+  }
+
+  return scp;
+}
+
+static void bench_naive_trim(void *ctx) {
+  char *ret = naive_trim(((trim_bench_ctx *)ctx)->input);
+  bench_sink += strlen(ret);
+  free(ret);
+}
+
+static void bench_s_trim(void *ctx) {
+  char *ret = s_trim(((trim_bench_ctx *)ctx)->input);
+  bench_sink += strlen(ret);
+  free(ret);
+}
+
+static void bench_s_trim_inplace(void *ctx) {
+  trim_bench_ctx *c = ctx;
+
+  // Restoring the input is part of the cost, as it would be for a caller
+  memcpy(c->scratch, c->input, c->len + 1);
+  bench_sink += strlen(s_trim_inplace(c->scratch));
+}
+
+static void bench_sv_trim(void *ctx) {
+  bench_sink += sv_trim(sv_from(((trim_bench_ctx *)ctx)->input)).len;
+}
+
+static void bench_trim(void) {
+  buffer_t *buf = buffer_init(NULL);
+  for (size_t i = 0; i < TRIM_BENCH_PAD; i++) {
+    buffer_append_char(buf, i % 8 ? ' ' : '\t');
+  }
+  buffer_append(buf, "the quick brown fox jumps over the lazy dog");
+  for (size_t i = 0; i < TRIM_BENCH_PAD; i++) {
+    buffer_append_char(buf, i % 8 ? ' ' : '\n');
+  }
+
+  trim_bench_ctx ctx = {.input = buffer_state(buf),
+                        .scratch = malloc(buffer_size(buf) + 1),
+                        .len = buffer_size(buf)};
+
+  bench_run("s_trim (naive baseline)", bench_naive_trim, &ctx, 5, ctx.len);
+  bench_run("s_trim", bench_s_trim, &ctx, 10000, ctx.len);
+  bench_run("s_trim_inplace", bench_s_trim_inplace, &ctx, 10000, ctx.len);
+  bench_run("sv_trim", bench_sv_trim, &ctx, 10000, ctx.len);
+
+  free(ctx.scratch);
+  buffer_free(buf);
+}
+
+static void bench_s_split(void *ctx) {
+  array_t *tokens = s_split(ctx, ", ");
+  bench_sink += array_size(tokens);
+  array_free(tokens, free);
+}
+
+static void bench_s_split_table(void *ctx) {
+  strtab_t *tokens = s_split_table(ctx, ", ");
+  bench_sink += strtab_size(tokens);
+  strtab_free(tokens);
+}
+
+static void bench_s_par_split(void *ctx) {
+  strtab_t *tokens = s_par_split(ctx, ", ", 0);
+  bench_sink += strtab_size(tokens);
+  strtab_free(tokens);
+}
+
+static void bench_sv_tokenizer(void *ctx) {
+  sv_tokenizer_t tokenizer = sv_tokenizer_init(sv_from(ctx), sv_from(", "),
+                                               false);
+  sv_t token;
+  while (sv_tokenizer_next(&tokenizer, &token)) {
+    bench_sink += token.len;
+  }
+}
+
+static void bench_split(void) {
+  buffer_t *buf = buffer_init(NULL);
+  while (buffer_size(buf) < SPLIT_BENCH_SZ) {
+    buffer_append(buf, "alpha, beta, gamma, delta, epsilon, ");
+  }
+
+  bench_run("s_split", bench_s_split, buffer_state(buf), 3, buffer_size(buf));
+  bench_run("s_split_table", bench_s_split_table, buffer_state(buf), 3,
+            buffer_size(buf));
+  bench_run("s_par_split", bench_s_par_split, buffer_state(buf), 3,
+            buffer_size(buf));
+  bench_run("sv_tokenizer", bench_sv_tokenizer, buffer_state(buf), 3,
+            buffer_size(buf));
+
+  buffer_free(buf);
+}
+
+static void bench_strstr(void *ctx) {
+  search_bench_ctx *c = ctx;
+  bench_sink += strstr(c->haystack, c->target) != NULL;
+}
+
+static void bench_s_indexof_n(void *ctx) {
+  search_bench_ctx *c = ctx;
+  bench_sink += s_indexof_n(c->haystack, c->len, c->target, strlen(c->target));
+}
+
+static void bench_s_needle_find(void *ctx) {
+  search_bench_ctx *c = ctx;
+  bench_sink += s_needle_find(c->needle, c->haystack, c->len);
+}
+
+// The approach s_indexof_case replaces
+static void bench_upper_indexof(void *ctx) {
+  search_bench_ctx *c = ctx;
+  char *haystack = s_upper(c->haystack);
+  char *target = s_upper(c->target);
+  bench_sink += s_indexof(haystack, target);
+  free(haystack);
+  free(target);
+}
+
+static void bench_s_indexof_case_n(void *ctx) {
+  search_bench_ctx *c = ctx;
+  bench_sink +=
+      s_indexof_case_n(c->haystack, c->len, c->target, strlen(c->target));
+}
+
+static void bench_search(void) {
+  buffer_t *buf = buffer_init(NULL);
+  while (buffer_size(buf) < SEARCH_BENCH_SZ) {
+    buffer_append(buf, "level=info request_id=4242 path=/api/v1/items ms=12\n");
+  }
+
+  // Neither target occurs, so every search scans the whole input
+  const char *targets[] = {
+      "request_id=4243",
+      "level=info request_id=4242 path=/api/v1/items ms=13",
+  };
+
+  for (size_t i = 0; i < sizeof(targets) / sizeof(targets[0]); i++) {
+    search_bench_ctx ctx = {
+        .haystack = buffer_state(buf),
+        .len = buffer_size(buf),
+        .target = targets[i],
+        .needle = s_needle_init(targets[i], strlen(targets[i])),
+    };
+
+    printf("target length %zu\n", strlen(targets[i]));
+    bench_run("strstr", bench_strstr, &ctx, 5, ctx.len);
+    bench_run("s_indexof_n", bench_s_indexof_n, &ctx, 5, ctx.len);
+    bench_run("s_needle_find", bench_s_needle_find, &ctx, 5, ctx.len);
+    bench_run("s_upper + s_indexof", bench_upper_indexof, &ctx, 5, ctx.len);
+    bench_run("s_indexof_case_n", bench_s_indexof_case_n, &ctx, 5, ctx.len);
+
+    s_needle_free(ctx.needle);
+  }
+
+  buffer_free(buf);
+}
+
+typedef struct {
+  const char *text;
+  size_t len;
+  array_t *patterns;
+  matcher_t *matcher;
+} matcher_bench_ctx;
+
+static void bench_indexof_each(void *ctx) {
+  matcher_bench_ctx *c = ctx;
+  for (size_t i = 0; i < array_size(c->patterns); i++) {
+    const char *p = array_get(c->patterns, i);
+    bench_sink += s_indexof_n(c->text, c->len, p, strlen(p)) >= 0;
+  }
+}
+
+static void bench_matcher_scan(void *ctx) {
+  matcher_bench_ctx *c = ctx;
+  bench_sink += matcher_scan(c->matcher, c->text, c->len, NULL, NULL);
+}
+
+static void bench_matcher(void) {
+  buffer_t *buf = buffer_init(NULL);
+  while (buffer_size(buf) < SEARCH_BENCH_SZ) {
+    buffer_append(buf, "level=info request_id=4242 path=/api/v1/items ms=12\n");
+  }
+
+  const size_t set_sizes[] = {16, 256};
+  for (size_t i = 0; i < sizeof(set_sizes) / sizeof(set_sizes[0]); i++) {
+    matcher_bench_ctx ctx = {
+        .text = buffer_state(buf),
+        .len = buffer_size(buf),
+        .patterns = array_init(),
+    };
+
+    for (size_t j = 0; j < set_sizes[i]; j++) {
+      array_push(ctx.patterns, s_fmt("keyword%zu=", j));
+    }
+    ctx.matcher = matcher_init(ctx.patterns);
+
+    printf("%zu patterns\n", set_sizes[i]);
+    bench_run("s_indexof_n per pattern", bench_indexof_each, &ctx, 1, ctx.len);
+    bench_run("matcher_scan", bench_matcher_scan, &ctx, 1, ctx.len);
+
+    matcher_free(ctx.matcher);
+    array_free(ctx.patterns, free);
+  }
+
+  buffer_free(buf);
+}
+
+static const char *header_names[][2] = {
+    {"Content-Type", "content-type"},
+    {"Accept-Encoding", "accept-encoding"},
+    {"X-Forwarded-For", "x-forwarded-proto"},
+    {"Access-Control-Allow-Credentials", "access-control-allow-credentials"},
+};
+
+#define N_HEADER_NAMES (sizeof(header_names) / sizeof(header_names[0]))
+
+static void bench_strcasecmp(void *ctx) {
+  (void)ctx;
+  for (size_t i = 0; i < N_HEADER_NAMES; i++) {
+    bench_sink += strcasecmp(header_names[i][0], header_names[i][1]) == 0;
+  }
+}
+
+static void bench_s_casecmp(void *ctx) {
+  (void)ctx;
+  for (size_t i = 0; i < N_HEADER_NAMES; i++) {
+    bench_sink += s_casecmp(header_names[i][0], header_names[i][1]);
+  }
+}
+
+static void bench_toupper_loop(void *ctx) {
+  trim_bench_ctx *c = ctx;
+  for (size_t i = 0; i < c->len; i++) {
+    c->scratch[i] = toupper((unsigned char)c->input[i]);
+  }
+  bench_sink += c->scratch[0];
+}
+
+static void bench_s_upper_into(void *ctx) {
+  trim_bench_ctx *c = ctx;
+  s_upper_into(c->scratch, c->input, c->len);
+  bench_sink += c->scratch[0];
+}
+
+static void bench_case(void) {
+  bench_run("strcasecmp (4 header names)", bench_strcasecmp, NULL, 1000000, 0);
+  bench_run("s_casecmp (4 header names)", bench_s_casecmp, NULL, 1000000, 0);
+
+  buffer_t *buf = buffer_init(NULL);
+  while (buffer_size(buf) < SEARCH_BENCH_SZ) {
+    buffer_append(buf, "level=info request_id=4242 path=/api/v1/items ms=12\n");
+  }
+
+  trim_bench_ctx ctx = {
+      .input = buffer_state(buf),
+      .scratch = malloc(buffer_size(buf)),
+      .len = buffer_size(buf),
+  };
+
+  bench_run("toupper loop", bench_toupper_loop, &ctx, 5, ctx.len);
+  bench_run("s_upper_into", bench_s_upper_into, &ctx, 5, ctx.len);
+
+  free(ctx.scratch);
+  buffer_free(buf);
+}
+
+// A small vocabulary of record keys, each repeated many times over
+static const char *intern_bench_keys[] = {
+    "timestamp", "level", "request_id", "path",
+    "method",    "status", "ms",        "host",
+};
+
+#define INTERN_BENCH_KEYS (sizeof(intern_bench_keys) / sizeof(char *))
+
+static void bench_s_copy_keys(void *ctx) {
+  (void)ctx;
+  for (size_t i = 0; i < INTERN_BENCH_KEYS; i++) {
+    char *key = s_copy(intern_bench_keys[i]);
+    bench_sink += s_equals(key, "status");
+    free(key);
+  }
+}
+
+static void bench_interner_keys(void *ctx) {
+  interner_t *in = ctx;
+  const char *status = interner_intern(in, "status");
+  for (size_t i = 0; i < INTERN_BENCH_KEYS; i++) {
+    bench_sink += interner_intern(in, intern_bench_keys[i]) == status;
+  }
+}
+
+static void bench_intern(void) {
+  interner_t *in = interner_init();
+
+  bench_run("s_copy + s_equals (8 keys)", bench_s_copy_keys, NULL, 1000000, 0);
+  bench_run("interner_intern + == (8 keys)", bench_interner_keys, in, 1000000,
+            0);
+
+  interner_free(in);
+}
+
+// Replacing one match at a time, as callers had to before s_replace_all
+static void bench_replace_naive(void *ctx) {
+  trim_bench_ctx *c = ctx;
+  char *s = s_copy(c->input);
+  ssize_t idx;
+
+  while ((idx = s_indexof(s, "=")) >= 0) {
+    char *head = s_substr(s, 0, idx, false);
+    char *next = s_fmt("%s: %s", head, s + idx + 1);
+    free(head);
+    free(s);
+    s = next;
+  }
+
+  bench_sink += strlen(s);
+  free(s);
+}
+
+static void bench_s_replace_all(void *ctx) {
+  trim_bench_ctx *c = ctx;
+  char *s = s_replace_all(c->input, "=", ": ");
+  bench_sink += s[0];
+  free(s);
+}
+
+static void bench_s_replacer(void *ctx) {
+  s_replacer_t *r = ctx;
+  char *s = s_replacer_replace(r, "<td class=\"name\">Tom & Jerry's</td>");
+  bench_sink += s[0];
+  free(s);
+}
+
+typedef struct {
+  s_replacer_t *r;
+  const char *input;
+} replacer_bench_ctx;
+
+static void bench_s_replacer_nested(void *ctx) {
+  replacer_bench_ctx *c = ctx;
+  char *s = s_replacer_replace(c->r, c->input);
+  bench_sink += s[0];
+  free(s);
+}
+
+static void bench_replace(void) {
+  buffer_t *buf = buffer_init(NULL);
+  for (int i = 0; i < 20; i++) {
+    buffer_append(buf, "level=info path=/api/v1/items ms=12 ");
+  }
+
+  trim_bench_ctx ctx = {.input = buffer_state(buf), .len = buffer_size(buf)};
+  bench_run("indexof + substr + fmt (60 hits)", bench_replace_naive, &ctx,
+            10000, ctx.len);
+  bench_run("s_replace_all (60 hits)", bench_s_replace_all, &ctx, 100000,
+            ctx.len);
+
+  array_t *pairs = array_collect("&", "&amp;", "<", "&lt;", ">", "&gt;", "\"",
+                                 "&quot;", "'", "&#39;");
+  s_replacer_t *r = s_replacer_init(pairs);
+  bench_run("s_replacer_replace (HTML escape)", bench_s_replacer, r, 1000000,
+            0);
+
+  s_replacer_free(r);
+  array_free(pairs, NULL);
+
+  // Every position starts several overlapping matches
+  char run[4097];
+  memset(run, 'a', 4096);
+  run[4096] = '\0';
+
+  pairs = array_collect("aaaa", "4", "aaa", "3", "aa", "2", "a", "1");
+  replacer_bench_ctx nested = {.r = s_replacer_init(pairs), .input = run};
+  bench_run("s_replacer_replace (nested patterns)", bench_s_replacer_nested,
+            &nested, 20000, 4096);
+
+  s_replacer_free(nested.r);
+  array_free(pairs, NULL);
+  buffer_free(buf);
+}
+
+static void bench_concat_loop(void *ctx) {
+  array_t *pieces = ctx;
+  char *s = s_copy("");
+
+  foreach (pieces, i) {
+    char *next = s_concat_n(3, s, i > 0 ? "," : "", array_get(pieces, i));
+    free(s);
+    s = next;
+  }
+
+  bench_sink += s[0];
+  free(s);
+}
+
+static void bench_s_join(void *ctx) {
+  char *s = s_join(ctx, ",");
+  bench_sink += s[0];
+  free(s);
+}
+
+static void bench_join(void) {
+  array_t *pieces = array_init();
+  for (int i = 0; i < 200; i++) {
+    array_push(pieces, "request_id=4242");
+  }
+
+  bench_run("s_concat_n loop (200 pieces)", bench_concat_loop, pieces, 10000,
+            0);
+  bench_run("s_join (200 pieces)", bench_s_join, pieces, 100000, 0);
+
+  array_free(pieces, NULL);
+}
+
+static void bench_s_fmt(void *ctx) {
+  (void)ctx;
+  char *key = s_fmt("user:%d:%s", 4242, "session");
+  bench_sink += key[0];
+  free(key);
+}
+
+static void bench_s_fmt_into(void *ctx) {
+  (void)ctx;
+  char buf[64];
+  char *key = s_fmt_into(buf, sizeof(buf), "user:%d:%s", 4242, "session");
+  bench_sink += key[0];
+  if (key != buf) {
+    free(key);
+  }
+}
+
+static void bench_fmt(void) {
+  bench_run("s_fmt (short key)", bench_s_fmt, NULL, 1000000, 0);
+  bench_run("s_fmt_into (short key)", bench_s_fmt_into, NULL, 1000000, 0);
+}
+
+static void bench_s_utf8_valid(void *ctx) {
+  trim_bench_ctx *c = ctx;
+  bench_sink += s_utf8_valid(c->input, c->len);
+}
+
+static void bench_s_utf8_len(void *ctx) {
+  trim_bench_ctx *c = ctx;
+  bench_sink += s_utf8_len(c->input, c->len);
+}
+
+static void bench_utf8(void) {
+  const char *lines[] = {
+      "{\"level\":\"info\",\"path\":\"/api/v1/items\",\"ms\":12}\n",
+      "{\"name\":\"Bj\xc3\xb6rk\",\"city\":\"M\xc3\xbcnchen\","
+      "\"price\":\"\xe2\x82\xac" "5\",\"mood\":\"\xf0\x9f\x98\x80\"}\n",
+  };
+  const char *names[][2] = {
+      {"s_utf8_valid (ASCII)", "s_utf8_len (ASCII)"},
+      {"s_utf8_valid (mixed)", "s_utf8_len (mixed)"},
+  };
+
+  for (size_t i = 0; i < 2; i++) {
+    buffer_t *buf = buffer_init(NULL);
+    while (buffer_size(buf) < SEARCH_BENCH_SZ) {
+      buffer_append(buf, lines[i]);
+    }
+
+    trim_bench_ctx ctx = {.input = buffer_state(buf), .len = buffer_size(buf)};
+    bench_run(names[i][0], bench_s_utf8_valid, &ctx, 20, ctx.len);
+    bench_run(names[i][1], bench_s_utf8_len, &ctx, 20, ctx.len);
+
+    buffer_free(buf);
+  }
+}
+
+void run_str_benches(void) {
+  bench_trim();
+  bench_split();
+  bench_search();
+  bench_matcher();
+  bench_case();
+  bench_intern();
+  bench_replace();
+  bench_join();
+  bench_fmt();
+  bench_utf8();
+}
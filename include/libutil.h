@@ -7,8 +7,22 @@ extern "C" {
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+
+/**
+ * Marks a function as taking a printf-style format string as its
+ * `fmt_index`th parameter, followed by its arguments from the `args_index`th,
+ * so the compiler checks each call's arguments against its format string.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define LIB_UTIL_FMT(fmt_index, args_index) \
+  __attribute__((format(printf, fmt_index, args_index)))
+#else
+#define LIB_UTIL_FMT(fmt_index, args_index)
+#endif
 
 #ifndef LIB_UTIL_ARRAY_CAPACITY_INCR
 #define LIB_UTIL_ARRAY_CAPACITY_INCR 4
@@ -187,11 +201,26 @@ bool array_insert(array_t *array, size_t index, void *el, free_fn *free_old_el);
  */
 void array_free(array_t *array, free_fn *free_fnptr);
 
+/**
+ * Size of the storage embedded in every buffer_t. Contents shorter than this
+ * (leaving room for the NUL terminator) are kept inline and never touch the
+ * heap; longer contents are transparently moved to a heap allocation.
+ */
+#ifndef LIB_UTIL_BUFFER_SSO_CAP
+#define LIB_UTIL_BUFFER_SSO_CAP 24
+#endif
+
 typedef struct {
-  char *state;
+  char *state;  // NULL, sso, or a heap allocation of cap bytes
   size_t len;
+  size_t cap;
+  char sso[LIB_UTIL_BUFFER_SSO_CAP];
 } __buffer_t;
 
+/**
+ * buffer_t* represents a growable, NUL-terminated byte string. Because state
+ * may point into the buffer itself, a buffer_t must not be copied by value.
+ */
 typedef __buffer_t *buffer_t;
 
 /**
@@ -211,6 +240,17 @@ char *buffer_state(buffer_t *buf);
  */
 buffer_t *buffer_init(const char *init);
 
+/**
+ * buffer_reserve ensures the buffer can hold `n` more bytes without
+ * reallocating.
+ */
+bool buffer_reserve(buffer_t *buf, size_t n);
+
+/**
+ * buffer_clear empties the buffer while keeping its allocated capacity.
+ */
+void buffer_clear(buffer_t *buf);
+
 /**
  * buffer_append appends a string `s` to a given buffer `buf`, reallocating the
  * required memory as needed.
@@ -229,6 +269,13 @@ bool buffer_append_char(buffer_t *buf, const char c);
  */
 bool buffer_append_with(buffer_t *buf, const char *s, size_t len);
 
+/**
+ * buffer_appendf appends a formatted string to the buffer. Uses printf syntax.
+ * Output that fits in the buffer's spare capacity is formatted directly into
+ * it, so this only allocates when the buffer must grow.
+ */
+bool buffer_appendf(buffer_t *buf, const char *fmt, ...) LIB_UTIL_FMT(2, 3);
+
 /**
  * buffer_concat concatenates two buffers and returns them as a new buffer. Does
  * not modify the given buffers.
@@ -254,12 +301,322 @@ bool buffer_slice(buffer_t *self, size_t start, size_t end_inclusive,
  */
 void buffer_free(buffer_t *buf);
 
+/**
+ * buffer_append_u8 appends a single byte to the buffer.
+ */
+bool buffer_append_u8(buffer_t *buf, uint8_t v);
+
+/**
+ * buffer_append_u16le appends `v` as 2 little-endian bytes.
+ */
+bool buffer_append_u16le(buffer_t *buf, uint16_t v);
+
+/**
+ * buffer_append_u32le appends `v` as 4 little-endian bytes.
+ */
+bool buffer_append_u32le(buffer_t *buf, uint32_t v);
+
+/**
+ * buffer_append_u64le appends `v` as 8 little-endian bytes.
+ */
+bool buffer_append_u64le(buffer_t *buf, uint64_t v);
+
+/**
+ * buffer_append_varint appends `v` as an unsigned LEB128 varint, using 1 to 10
+ * bytes depending on its magnitude.
+ */
+bool buffer_append_varint(buffer_t *buf, uint64_t v);
+
+/**
+ * buffer_append_zigzag appends `v` zigzag-encoded as a varint, so that values
+ * of small magnitude are small regardless of sign.
+ */
+bool buffer_append_zigzag(buffer_t *buf, int64_t v);
+
+/**
+ * buffer_append_prefixed appends `len` bytes of `data` preceded by their
+ * length as a varint.
+ */
+bool buffer_append_prefixed(buffer_t *buf, const char *data, size_t len);
+
+/**
+ * buffer_reader_t is a bounds-checked cursor over a read-only view of bytes,
+ * for decoding data written with the buffer_append_u* family. A failed read
+ * leaves the cursor where it was.
+ */
+typedef struct {
+  const unsigned char *data;
+  size_t len;
+  size_t pos;
+} buffer_reader_t;
+
+/**
+ * buffer_reader_init returns a reader over `len` bytes of `data`. The data
+ * must outlive the reader.
+ */
+buffer_reader_t buffer_reader_init(const char *data, size_t len);
+
+/**
+ * buffer_reader_from returns a reader over the current contents of `buf`. The
+ * buffer must not be modified while the reader is in use.
+ */
+buffer_reader_t buffer_reader_from(buffer_t *buf);
+
+/**
+ * buffer_reader_remaining returns the number of bytes left to read.
+ */
+size_t buffer_reader_remaining(buffer_reader_t *reader);
+
+/**
+ * buffer_read_u8 reads a single byte. Returns false if none remain.
+ */
+bool buffer_read_u8(buffer_reader_t *reader, uint8_t *v);
+
+/**
+ * buffer_read_u16le reads 2 little-endian bytes. Returns false if fewer
+ * remain.
+ */
+bool buffer_read_u16le(buffer_reader_t *reader, uint16_t *v);
+
+/**
+ * buffer_read_u32le reads 4 little-endian bytes. Returns false if fewer
+ * remain.
+ */
+bool buffer_read_u32le(buffer_reader_t *reader, uint32_t *v);
+
+/**
+ * buffer_read_u64le reads 8 little-endian bytes. Returns false if fewer
+ * remain.
+ */
+bool buffer_read_u64le(buffer_reader_t *reader, uint64_t *v);
+
+/**
+ * buffer_read_varint reads an unsigned LEB128 varint. Returns false if the
+ * varint is truncated or does not fit in 64 bits.
+ */
+bool buffer_read_varint(buffer_reader_t *reader, uint64_t *v);
+
+/**
+ * buffer_read_zigzag reads a zigzag-encoded varint.
+ */
+bool buffer_read_zigzag(buffer_reader_t *reader, int64_t *v);
+
+/**
+ * buffer_read_prefixed reads a varint length followed by that many bytes. No
+ * copy is made: `data` is set to point into the reader's underlying bytes.
+ */
+bool buffer_read_prefixed(buffer_reader_t *reader, const char **data,
+                          size_t *len);
+
+/**
+ * buffer_append_base64 appends `len` bytes of `data` encoded as padded base64
+ * (RFC 4648, standard alphabet).
+ */
+bool buffer_append_base64(buffer_t *buf, const char *data, size_t len);
+
+/**
+ * buffer_append_base64_decoded decodes `len` characters of base64 from `s` and
+ * appends the resulting bytes. Trailing padding is optional. Returns false,
+ * leaving the buffer unchanged, if the input is not valid base64.
+ */
+bool buffer_append_base64_decoded(buffer_t *buf, const char *s, size_t len);
+
+/**
+ * buffer_append_hex appends `len` bytes of `data` encoded as lowercase hex.
+ */
+bool buffer_append_hex(buffer_t *buf, const char *data, size_t len);
+
+/**
+ * buffer_append_hex_decoded decodes `len` hex digits of either case from `s`
+ * and appends the resulting bytes. Returns false, leaving the buffer
+ * unchanged, if the input has odd length or contains a non-hex character.
+ */
+bool buffer_append_hex_decoded(buffer_t *buf, const char *s, size_t len);
+
+/**
+ * Default cap, in bytes, on the memory a buffer_pool_t holds on to. Buffers
+ * returned to a pool that would exceed this are freed instead.
+ */
+#ifndef LIB_UTIL_BUFFER_POOL_MAX_RETAINED
+#define LIB_UTIL_BUFFER_POOL_MAX_RETAINED (64 * 1024 * 1024)
+#endif
+
+/**
+ * Number of buffers each thread may cache in front of a buffer_pool_t's shared
+ * free lists when the pool's thread cache is enabled.
+ */
+#ifndef LIB_UTIL_BUFFER_POOL_TCACHE_SZ
+#define LIB_UTIL_BUFFER_POOL_TCACHE_SZ 8
+#endif
+
+/**
+ * Maximum number of size classes a buffer_pool_t may be configured with.
+ */
+#define LIB_UTIL_BUFFER_POOL_MAX_CLASSES 16
+
+/**
+ * buffer_pool_t* recycles already-grown buffer_t's so that hot paths can reuse
+ * their allocations rather than calling buffer_init and buffer_free for each
+ * unit of work. A pool is safe to share between threads.
+ */
+typedef struct __buffer_pool buffer_pool_t;
+
+/**
+ * buffer_pool_init initializes and returns a new buffer_pool_t*.
+ *
+ * @param class_sizes Ascending minimum capacities of each size class, or NULL
+ * for the defaults (256 bytes to 1 MB). Returned buffers are filed under the
+ * largest class their capacity satisfies.
+ * @param num_classes The number of entries in `class_sizes`. At most
+ * LIB_UTIL_BUFFER_POOL_MAX_CLASSES.
+ * @param max_retained The maximum number of bytes the pool may retain, or 0 for
+ * LIB_UTIL_BUFFER_POOL_MAX_RETAINED.
+ * @param thread_cache Whether each thread should keep a small lock-free cache
+ * of buffers in front of the shared free lists.
+ * @return buffer_pool_t* or NULL if the configuration was invalid
+ *
+ * Caller is responsible for `free`-ing the returned pointer via
+ * buffer_pool_free.
+ */
+buffer_pool_t *buffer_pool_init(const size_t *class_sizes, size_t num_classes,
+                                size_t max_retained, bool thread_cache);
+
+/**
+ * buffer_pool_default returns the process-wide pool, which uses the default
+ * configuration with the thread cache enabled. It is never freed.
+ */
+buffer_pool_t *buffer_pool_default(void);
+
+/**
+ * buffer_pool_get returns an empty buffer with room for at least `size_hint`
+ * bytes, reusing a previously returned buffer when one is available. Passing a
+ * NULL pool uses buffer_pool_default.
+ *
+ * The returned buffer should be handed back with buffer_pool_put, though
+ * buffer_free is also safe.
+ */
+buffer_t *buffer_pool_get(buffer_pool_t *pool, size_t size_hint);
+
+/**
+ * buffer_pool_put returns `buf` to the pool for reuse. Buffers too small to be
+ * worth pooling, or that would push the pool over its retention cap, are
+ * freed. Passing a NULL pool uses buffer_pool_default.
+ */
+void buffer_pool_put(buffer_pool_t *pool, buffer_t *buf);
+
+/**
+ * buffer_pool_retained returns the number of bytes of buffer capacity the pool
+ * is currently holding on to, including thread caches.
+ */
+size_t buffer_pool_retained(buffer_pool_t *pool);
+
+/**
+ * buffer_pool_free deallocates the pool and every buffer it retains. Any other
+ * threads that used the pool's thread cache must have exited first.
+ */
+void buffer_pool_free(buffer_pool_t *pool);
+
+/**
+ * shared_buffer_t* is an immutable, reference-counted byte string that can be
+ * handed to many threads at once. Sharing is a matter of bumping an atomic
+ * reference count; a holder that wants to modify its copy gets a private one
+ * only if others still hold references (copy-on-write).
+ */
+typedef struct __shared_buffer shared_buffer_t;
+
+/**
+ * shared_buffer_init initializes and returns a new shared_buffer_t* holding a
+ * copy of `len` bytes of `data`, with a reference count of 1.
+ *
+ * Caller is responsible for releasing the returned pointer via
+ * shared_buffer_release.
+ */
+shared_buffer_t *shared_buffer_init(const char *data, size_t len);
+
+/**
+ * shared_buffer_from_buffer returns a new shared_buffer_t* holding a copy of
+ * the contents of `buf`.
+ *
+ * Caller is responsible for releasing the returned pointer via
+ * shared_buffer_release.
+ */
+shared_buffer_t *shared_buffer_from_buffer(buffer_t *buf);
+
+/**
+ * shared_buffer_retain takes an additional reference to `sb` and returns it.
+ * Safe to call from any thread that already holds a reference.
+ */
+shared_buffer_t *shared_buffer_retain(shared_buffer_t *sb);
+
+/**
+ * shared_buffer_release drops a reference to `sb`, deallocating it once the
+ * last reference is gone.
+ */
+void shared_buffer_release(shared_buffer_t *sb);
+
+/**
+ * shared_buffer_size returns the length of the shared buffer.
+ */
+size_t shared_buffer_size(shared_buffer_t *sb);
+
+/**
+ * shared_buffer_state returns the shared buffer's NUL-terminated contents,
+ * which must not be modified.
+ */
+const char *shared_buffer_state(shared_buffer_t *sb);
+
+/**
+ * shared_buffer_refcount returns the number of references currently held.
+ * Other threads may change it at any time; use it for diagnostics only.
+ */
+size_t shared_buffer_refcount(shared_buffer_t *sb);
+
+/**
+ * shared_buffer_mut returns a writable pointer to the contents of `*sb`. If any
+ * other references are held, `*sb` is first replaced with a private copy and
+ * the caller's reference to the original is released.
+ *
+ * Returns NULL if the copy could not be allocated, in which case `*sb` is left
+ * as-is.
+ */
+char *shared_buffer_mut(shared_buffer_t **sb);
+
+/**
+ * shared_buffer_append appends `len` bytes of `s` to `*sb`, copying the
+ * contents first if they are shared. `*sb` may be replaced.
+ */
+bool shared_buffer_append(shared_buffer_t **sb, const char *s, size_t len);
+
+/**
+ * Size of the stack scratch s_fmt formats into first. Outputs that fit are
+ * formatted once and copied into an allocation of their exact size; longer
+ * ones are formatted again into the heap.
+ */
+#ifndef LIB_UTIL_FMT_SCRATCH_SZ
+#define LIB_UTIL_FMT_SCRATCH_SZ 256
+#endif
+
 /**
  * Returns a formatted string. Uses printf syntax.
  *
  * Caller is responsible for `free`-ing the returned pointer.
  */
-char *s_fmt(char *fmt, ...);
+char *s_fmt(char *fmt, ...) LIB_UTIL_FMT(1, 2);
+
+/**
+ * s_fmt_into formats a string into `buf`, which holds `cap` bytes, and returns
+ * `buf`. Only if the output doesn't fit is it formatted into a new allocation
+ * instead, which is returned. Returns NULL on error.
+ *
+ *   char key[64];
+ *   char *s = s_fmt_into(key, sizeof(key), "user:%d:%s", id, field);
+ *   ...
+ *   if (s != key) free(s);
+ *
+ * Caller is responsible for `free`-ing the returned pointer if it isn't `buf`.
+ */
+char *s_fmt_into(char *buf, size_t cap, const char *fmt, ...)
+    LIB_UTIL_FMT(3, 4);
 
 /**
  * s_truncate truncates the given string `s` by `n` characters.
@@ -282,6 +639,25 @@ char *s_concat(const char *s1, const char *s2);
  */
 char *s_concat_arr(char **arr, const char *delimiter);
 
+/**
+ * s_concat_n concatenates the `n` strings passed after it, in order, measuring
+ * each once and allocating once. NULL strings are skipped.
+ *
+ *   char *path = s_concat_n(3, dir, "/", name);
+ *
+ * Caller is responsible for `free`-ing the returned pointer.
+ */
+char *s_concat_n(size_t n, ...);
+
+/**
+ * s_join joins an array_t* of strings with the given delimiter, which may be
+ * NULL for none. NULL elements are joined as empty strings, and an empty array
+ * yields an empty string. The output is sized exactly and allocated once.
+ *
+ * Caller is responsible for `free`-ing the returned pointer.
+ */
+char *s_join(array_t *arr, const char *delimiter);
+
 /**
  * s_copy returns a copy of given string `str`. Compare to strdup.
  *
@@ -297,110 +673,1179 @@ char *s_copy(const char *s);
 ssize_t s_indexof(const char *str, const char *target);
 
 /**
- * s_substr finds and returns the substring between
- * indices `start` and `end` for a given string `str`.
- * The start index is always inclusive.
- * The third argument `inclusive` is a boolean flag indicating whether the
- * substring match should be end-inclusive.
- *
- * Caller is responsible for `free`-ing the returned pointer.
+ * s_indexof_n returns the index of the first occurrence of the `target_len`
+ * bytes at `target` within the `len` bytes at `s`, or -1 if there is none.
+ * Either may contain NUL bytes. An empty `target` is found at index 0.
  */
-char *s_substr(const char *s, size_t start, ssize_t end, bool inclusive);
+ssize_t s_indexof_n(const char *s, size_t len, const char *target,
+                    size_t target_len);
 
 /**
- * s_casecmp performs a safe case-insensitive string comparison between
- * two strings and returns a bool indicating whether they are equal.
+ * s_indexof_case returns the index of the first occurrence of `target` in `s`
+ * ignoring ASCII case, or -1 if there is none.
  */
-bool s_casecmp(const char *s1, const char *s2);
+ssize_t s_indexof_case(const char *s, const char *target);
+
+/**
+ * s_indexof_case_n behaves like s_indexof_n but ignores ASCII case.
+ */
+ssize_t s_indexof_case_n(const char *s, size_t len, const char *target,
+                         size_t target_len);
 
 /**
- * s_upper converts the given string `s` to uppercase.
+ * s_indexof_all returns an array_t* of the index of every non-overlapping
+ * occurrence of `target` in `s`, in order. Each element is a size_t cast to
+ * `void *`; read it back with `(size_t)array_get(array, i)`. An empty
+ * `target` has no occurrences.
  *
- * Caller is responsible for `free`-ing the returned pointer.
+ * Caller is responsible for `free`-ing the returned pointer via
+ * `array_free(array, NULL)`.
  */
-char *s_upper(const char *s);
+array_t *s_indexof_all(const char *s, const char *target);
 
 /**
- * s_equals returns a bool indicating whether strings s1 and s2 are completely
- * equal (case-sensitive).
+ * s_count returns the number of non-overlapping occurrences of `target` in
+ * `s`. An empty `target` has no occurrences.
  */
-bool s_equals(const char *s1, const char *s2);
+size_t s_count(const char *s, const char *target);
 
 /**
- * s_nullish tests whether a given string `s` is NULL or empty i.e. "".
+ * s_utf8_valid returns a bool indicating whether the `len` bytes at `s` are
+ * well-formed UTF-8: no overlong encodings, surrogates, code points above
+ * U+10FFFF or truncated sequences. Uses the SIMD algorithm of Keiser and
+ * Lemire where the CPU supports it.
  */
-bool s_nullish(const char *s);
+bool s_utf8_valid(const char *s, size_t len);
+
+/**
+ * s_utf8_len returns the number of code points in the `len` bytes of UTF-8 at
+ * `s`, i.e. the number of bytes that aren't continuation bytes. The count is
+ * only meaningful for valid UTF-8.
+ */
+size_t s_utf8_len(const char *s, size_t len);
+
+/**
+ * s_utf8_boundary returns the largest index no greater than `n` that doesn't
+ * fall inside a multibyte sequence of the `len` bytes of UTF-8 at `s`, so that
+ * cutting there splits no code point. Returns `len` if `n` is beyond it.
+ */
+size_t s_utf8_boundary(const char *s, size_t len, size_t n);
 
 /**
- * s_trim returns a copy of the string `s` with all whitespace removed.
+ * s_utf8_truncate returns a copy of at most the first `n` bytes of the UTF-8
+ * string `s`, cut short as needed so as not to split a multibyte sequence.
+ * Unlike s_truncate and s_substr, the result is valid UTF-8 if `s` is.
  *
  * Caller is responsible for `free`-ing the returned pointer.
  */
-char *s_trim(const char *s);
+char *s_utf8_truncate(const char *s, size_t n);
 
 /**
- * s_split splits a string on all instances of a delimiter.
- * Returns an array_t* of matches, if any, or NULL if erroneous.
+ * s_replace returns a copy of `s` with the first occurrence of `from` replaced
+ * by `to`. An empty `from` matches nothing.
  *
  * Caller is responsible for `free`-ing the returned pointer.
  */
-array_t *s_split(const char *s, const char *delim);
+char *s_replace(const char *s, const char *from, const char *to);
 
 /**
- * Chunk size for io_read_all. This is the number of bytes by which io_read_all
- * increments its reads. OK to be larger than total bytes.
+ * s_replace_all returns a copy of `s` with every non-overlapping occurrence of
+ * `from`, scanning left to right, replaced by `to`. The matches are found in
+ * one pass, and the result written with a single allocation of its exact size.
+ * An empty `from` matches nothing.
+ *
+ * Caller is responsible for `free`-ing the returned pointer.
  */
-#ifndef IO_IO_READ_ALL_CHUNK_SZ
-#define IO_IO_READ_ALL_CHUNK_SZ 262144
-#endif
+char *s_replace_all(const char *s, const char *from, const char *to);
 
 /**
- * Chunk size for io_write_all. This is the number of bytes by which
- * io_write_all increments its writes. OK to be larger than total bytes but use
- * judiciously.
+ * buffer_append_replaced appends the `len` bytes at `s` to the buffer with
+ * every occurrence of `from` replaced by `to`, as s_replace_all does. The
+ * buffer is grown at most once.
  */
-#ifndef IO_IO_WRITE_ALL_CHUNK_SZ
-#define IO_IO_WRITE_ALL_CHUNK_SZ 1024
-#endif
-
-typedef enum {
-  IO_READ_ALL_OK = 0,          // Success
-  IO_READ_ALL_ERR = -1,        // Stream err
-  IO_READ_ALL_INVALID = -2,    // Bad input
-  IO_READ_ALL_TOO_LARGE = -3,  // Input too large
-  IO_READ_ALL_NOMEM = -4       // Out of memory
-} io_read_all_result;
+bool buffer_append_replaced(buffer_t *buf, const char *s, size_t len,
+                            const char *from, const char *to);
 
-typedef enum {
-  IO_WRITE_ALL_OK = 0,           // Success
-  IO_WRITE_ALL_ERR = -1,         // General error
-  IO_WRITE_ALL_INVALID = -2,     // Bad data or file descriptor
-  IO_WRITE_ALL_INCOMPLETE = -3,  // Failed to complete write
-} io_write_all_result;
+/**
+ * s_needle_t* is a substring search pattern, preprocessed once so it can be
+ * searched for repeatedly. Short needles are found with a SIMD filter on
+ * their first and last bytes; long ones with the Two-Way algorithm, which is
+ * linear in the worst case.
+ */
+typedef struct __s_needle s_needle_t;
 
 /**
- * Reads all data from the given file descriptor `fd`.
+ * s_needle_init returns a new s_needle_t* for a copy of the `len` bytes at
+ * `target`.
  *
- * @param fd An opened file descriptor.
- * @param data_ptr A pointer where the read data will be stored. Note, you can
- * safely malloc(0) - this will be realloc'd based on the data size after
- * reading.
- * @param n_read_ptr A pointer where the number of bytes read will be stored.
- * @return io_read_all_result
+ * Caller is responsible for `free`-ing the returned pointer via
+ * s_needle_free.
  */
-io_read_all_result io_read_all(FILE *fd, char **data_ptr, size_t *n_read_ptr);
+s_needle_t *s_needle_init(const char *target, size_t len);
 
 /**
- * Writes all data to the given file descriptor `fd`.
- *
- * @param fd An opened file descriptor.
- * @param data A pointer to the data to be written in full.
- * @param n_write_ptr A pointer where the number of bytes written will be
- * stored.
- * @return io_write_all_result
+ * s_needle_find returns the index of the needle's first occurrence within the
+ * `len` bytes at `s`, or -1 if there is none.
  */
-io_write_all_result io_write_all(FILE *fd, const char *data,
-                                 size_t *n_write_ptr);
+ssize_t s_needle_find(s_needle_t *needle, const char *s, size_t len);
+
+/**
+ * s_needle_len returns the length of the needle's pattern, in bytes.
+ */
+size_t s_needle_len(s_needle_t *needle);
+
+/**
+ * s_needle_free deallocates the needle.
+ */
+void s_needle_free(s_needle_t *needle);
+
+/**
+ * matcher_t* is a compiled set of patterns that can all be searched for in a
+ * single pass over a text. Small sets are scanned with the SIMD Teddy
+ * algorithm where the CPU supports it; otherwise, an Aho-Corasick automaton
+ * is used.
+ */
+typedef struct __matcher matcher_t;
+
+/**
+ * matcher_fn is invoked by matcher_scan for each match with the index of the
+ * pattern that matched and the match's starting index in the text. Returning
+ * false stops the scan.
+ */
+typedef bool matcher_fn(size_t pattern, size_t start, void *ctx);
+
+/**
+ * matcher_init compiles a matcher_t* from an array_t* of strings. Pattern
+ * indices are the strings' indices in the array, which is not retained.
+ * Returns NULL if the array is empty or holds a NULL or empty string.
+ *
+ * Caller is responsible for `free`-ing the returned pointer via matcher_free.
+ */
+matcher_t *matcher_init(array_t *patterns);
+
+/**
+ * matcher_size returns the number of patterns in the matcher.
+ */
+size_t matcher_size(matcher_t *m);
+
+/**
+ * matcher_scan finds every occurrence of every pattern in the `len` bytes at
+ * `s`, including overlapping ones, invoking `fn` for each unless it is NULL.
+ * Matches are reported in order of either their starts or their ends, so no
+ * match starts more than the longest pattern's length before the end of one
+ * reported earlier.
+ *
+ * @return The number of matches reported
+ */
+size_t matcher_scan(matcher_t *m, const char *s, size_t len, matcher_fn *fn,
+                    void *ctx);
+
+/**
+ * matcher_matches returns true if any pattern occurs in the `len` bytes at
+ * `s`, stopping at the first match found.
+ */
+bool matcher_matches(matcher_t *m, const char *s, size_t len);
+
+/**
+ * matcher_free deallocates the matcher.
+ */
+void matcher_free(matcher_t *m);
+
+/**
+ * s_replacer_t* replaces several patterns at once, such as the entries of an
+ * escaping table. At each index, scanning left to right, the first pair whose
+ * pattern matches there is replaced, and matching resumes after it, so
+ * replacements never overlap or apply to each other's output.
+ */
+typedef struct __s_replacer s_replacer_t;
+
+/**
+ * s_replacer_init returns a new s_replacer_t* for an array_t* of strings
+ * holding pairs of a pattern and its replacement, e.g.
+ *
+ *   array_t *pairs = array_collect("&", "&amp;", "<", "&lt;", ">", "&gt;");
+ *
+ * Returns NULL for an odd number of strings, or if a pattern is empty or any
+ * string is NULL. The array is not retained.
+ *
+ * Caller is responsible for `free`-ing the returned pointer via
+ * s_replacer_free.
+ */
+s_replacer_t *s_replacer_init(array_t *pairs);
+
+/**
+ * s_replacer_replace returns a copy of `s` with every pattern replaced.
+ *
+ * Caller is responsible for `free`-ing the returned pointer.
+ */
+char *s_replacer_replace(s_replacer_t *r, const char *s);
+
+/**
+ * s_replacer_append appends the `len` bytes at `s` to the buffer with every
+ * pattern replaced. The buffer is grown at most once.
+ */
+bool s_replacer_append(s_replacer_t *r, buffer_t *buf, const char *s,
+                       size_t len);
+
+/**
+ * s_replacer_free deallocates the replacer.
+ */
+void s_replacer_free(s_replacer_t *r);
+
+/**
+ * s_substr finds and returns the substring between
+ * indices `start` and `end` for a given string `str`.
+ * The start index is always inclusive.
+ * The third argument `inclusive` is a boolean flag indicating whether the
+ * substring match should be end-inclusive.
+ *
+ * Caller is responsible for `free`-ing the returned pointer.
+ */
+char *s_substr(const char *s, size_t start, ssize_t end, bool inclusive);
+
+/**
+ * s_casecmp performs a safe case-insensitive string comparison between
+ * two strings and returns a bool indicating whether they are equal.
+ */
+bool s_casecmp(const char *s1, const char *s2);
+
+/**
+ * s_casecmp_n returns a bool indicating whether the `len1` bytes at `s1` and
+ * the `len2` bytes at `s2` are equal, ignoring ASCII case. Strings of
+ * different lengths are never equal. NUL bytes are compared like any other.
+ */
+bool s_casecmp_n(const char *s1, size_t len1, const char *s2, size_t len2);
+
+/**
+ * s_casecompare_n compares the `len1` bytes at `s1` with the `len2` bytes at
+ * `s2` ignoring ASCII case, as strncasecmp does in the C locale. Returns a
+ * negative number, zero or a positive number if `s1` sorts before, with or
+ * after `s2`. A string sorts before any longer string it is a prefix of.
+ */
+int s_casecompare_n(const char *s1, size_t len1, const char *s2, size_t len2);
+
+/**
+ * s_upper converts the given string `s` to uppercase. Only ASCII letters are
+ * converted, regardless of locale.
+ *
+ * Caller is responsible for `free`-ing the returned pointer.
+ */
+char *s_upper(const char *s);
+
+/**
+ * s_lower converts the given string `s` to lowercase. Only ASCII letters are
+ * converted, regardless of locale.
+ *
+ * Caller is responsible for `free`-ing the returned pointer.
+ */
+char *s_lower(const char *s);
+
+/**
+ * s_upper_inplace converts `s` to uppercase in place, returning `s`.
+ */
+char *s_upper_inplace(char *s);
+
+/**
+ * s_lower_inplace converts `s` to lowercase in place, returning `s`.
+ */
+char *s_lower_inplace(char *s);
+
+/**
+ * s_upper_into writes the `len` bytes at `src`, converted to uppercase, to
+ * `dst`, which must hold `len` bytes and may be `src` itself. No NUL
+ * terminator is written.
+ */
+void s_upper_into(char *dst, const char *src, size_t len);
+
+/**
+ * s_lower_into writes the `len` bytes at `src`, converted to lowercase, to
+ * `dst`, which must hold `len` bytes and may be `src` itself. No NUL
+ * terminator is written.
+ */
+void s_lower_into(char *dst, const char *src, size_t len);
+
+/**
+ * s_equals returns a bool indicating whether strings s1 and s2 are completely
+ * equal (case-sensitive).
+ */
+bool s_equals(const char *s1, const char *s2);
+
+/**
+ * s_nullish tests whether a given string `s` is NULL or empty i.e. "".
+ */
+bool s_nullish(const char *s);
+
+/**
+ * s_trim returns a copy of the string `s` with leading and trailing whitespace
+ * removed. See sv_trim for a variant that does not allocate.
+ *
+ * Caller is responsible for `free`-ing the returned pointer.
+ */
+char *s_trim(const char *s);
+
+/**
+ * s_trim_inplace removes leading and trailing whitespace from the string `s`
+ * by shifting its contents down, and returns `s`.
+ */
+char *s_trim_inplace(char *s);
+
+/**
+ * s_split splits a string on all instances of a delimiter, which is matched
+ * as a whole string. Empty tokens are skipped. Returns an array_t* of
+ * matches, which is empty if the delimiter does not occur, or NULL if
+ * erroneous. See sv_tokenizer_t for a variant that does not allocate.
+ *
+ * Caller is responsible for `free`-ing the returned pointer.
+ */
+array_t *s_split(const char *s, const char *delim);
+
+/**
+ * sv_t is a non-owning view of `len` bytes starting at `ptr`. The bytes need
+ * not be NUL-terminated and must outlive the view. No sv_ function allocates
+ * except sv_to_owned.
+ */
+typedef struct {
+  const char *ptr;
+  size_t len;
+} sv_t;
+
+/**
+ * SV_FMT and SV_ARG print a view with printf-family functions e.g.
+ * `printf("<" SV_FMT ">", SV_ARG(sv))`.
+ */
+#define SV_FMT "%.*s"
+#define SV_ARG(sv) (int)(sv).len, (sv).ptr
+
+/**
+ * sv_from returns a view of the string `s`, or an empty view if `s` is NULL.
+ */
+sv_t sv_from(const char *s);
+
+/**
+ * sv_from_n returns a view of `len` bytes starting at `s`.
+ */
+sv_t sv_from_n(const char *s, size_t len);
+
+/**
+ * sv_from_buffer returns a view of the contents of `buf`. It is invalidated by
+ * any change to the buffer.
+ */
+sv_t sv_from_buffer(buffer_t *buf);
+
+/**
+ * sv_trim returns the view `sv` without leading and trailing whitespace.
+ */
+sv_t sv_trim(sv_t sv);
+
+/**
+ * sv_trim_left returns the view `sv` without leading whitespace.
+ */
+sv_t sv_trim_left(sv_t sv);
+
+/**
+ * sv_trim_right returns the view `sv` without trailing whitespace.
+ */
+sv_t sv_trim_right(sv_t sv);
+
+/**
+ * sv_substr returns the view of `sv` from index `start` up to but excluding
+ * `end`. Out-of-range indices are clamped to the view.
+ */
+sv_t sv_substr(sv_t sv, size_t start, size_t end);
+
+/**
+ * sv_indexof returns the index of the first occurrence of `target` in `sv`,
+ * or -1 if there is none. An empty `target` is found at index 0.
+ */
+ssize_t sv_indexof(sv_t sv, sv_t target);
+
+/**
+ * sv_indexof_case behaves like sv_indexof but ignores ASCII case.
+ */
+ssize_t sv_indexof_case(sv_t sv, sv_t target);
+
+/**
+ * sv_split_next stores in `token` the part of `input` before the first
+ * occurrence of `delim`, and advances `input` past the delimiter. Returns
+ * false once every token has been returned. Empty tokens are kept, so "a,,b"
+ * split on "," yields "a", "" and "b".
+ *
+ *   sv_t input = sv_from("a,b,c"), token;
+ *   while (sv_split_next(&input, sv_from(","), &token)) { ... }
+ */
+bool sv_split_next(sv_t *input, sv_t delim, sv_t *token);
+
+/**
+ * sv_tokenizer_t iterates over the tokens of a view separated by an exact,
+ * possibly multi-character, delimiter. All of its state lives in the struct,
+ * so any number of tokenizers may run at once on any threads. Tokens are views
+ * into the input; nothing is copied.
+ */
+typedef struct {
+  sv_t rest;
+  sv_t delim;
+  bool keep_empty;
+} sv_tokenizer_t;
+
+/**
+ * sv_tokenizer_init returns a tokenizer over `input`. If `keep_empty` is
+ * false, empty tokens (from adjacent delimiters or at either end) are skipped.
+ *
+ *   sv_tokenizer_t tok = sv_tokenizer_init(input, sv_from("\r\n"), false);
+ *   sv_t token;
+ *   while (sv_tokenizer_next(&tok, &token)) { ... }
+ */
+sv_tokenizer_t sv_tokenizer_init(sv_t input, sv_t delim, bool keep_empty);
+
+/**
+ * sv_tokenizer_next stores the next token in `token`, returning false when
+ * there are no more.
+ */
+bool sv_tokenizer_next(sv_tokenizer_t *tokenizer, sv_t *token);
+
+/**
+ * sv_equals returns a bool indicating whether views s1 and s2 hold the same
+ * bytes.
+ */
+bool sv_equals(sv_t s1, sv_t s2);
+
+/**
+ * sv_casecmp returns a bool indicating whether views s1 and s2 are equal,
+ * ignoring ASCII case.
+ */
+bool sv_casecmp(sv_t s1, sv_t s2);
+
+/**
+ * sv_to_owned returns a NUL-terminated copy of the view `sv`.
+ *
+ * Caller is responsible for `free`-ing the returned pointer.
+ */
+char *sv_to_owned(sv_t sv);
+
+/**
+ * s_join_views joins `n` string views with the given delimiter, which may be
+ * NULL for none. The views' bytes are copied without being scanned, and the
+ * output is allocated once.
+ *
+ * Caller is responsible for `free`-ing the returned pointer.
+ */
+char *s_join_views(const sv_t *views, size_t n, const char *delimiter);
+
+/**
+ * strtab_t* is an append-only table of strings. All string bytes live in one
+ * contiguous blob and their offsets in one array, so building a table makes a
+ * handful of allocations however many strings it holds, and freeing it takes
+ * constant time. Each string is NUL-terminated and may contain NUL bytes.
+ */
+typedef struct __strtab strtab_t;
+
+/**
+ * strtab_init initializes and returns a new, empty strtab_t*.
+ *
+ * Caller is responsible for `free`-ing the returned pointer via strtab_free.
+ */
+strtab_t *strtab_init(void);
+
+/**
+ * strtab_reserve ensures the table can take `n_strings` more strings totalling
+ * `n_bytes` bytes without reallocating.
+ */
+bool strtab_reserve(strtab_t *tab, size_t n_strings, size_t n_bytes);
+
+/**
+ * strtab_push appends a copy of `len` bytes of `s` to the table.
+ */
+bool strtab_push(strtab_t *tab, const char *s, size_t len);
+
+/**
+ * strtab_append appends a copy of every string in `other` to the table, in
+ * order. `other` is left unchanged.
+ */
+bool strtab_append(strtab_t *tab, strtab_t *other);
+
+/**
+ * strtab_size returns the number of strings in the table.
+ */
+size_t strtab_size(strtab_t *tab);
+
+/**
+ * strtab_get returns the string at the given index, or NULL if the index is
+ * out-of-bounds. The pointer is invalidated by any further push.
+ */
+const char *strtab_get(strtab_t *tab, size_t index);
+
+/**
+ * strtab_get_sv returns a view of the string at the given index, or an empty
+ * view if the index is out-of-bounds. The view is invalidated by any further
+ * push.
+ */
+sv_t strtab_get_sv(strtab_t *tab, size_t index);
+
+/**
+ * strtab_to_array returns an array_t* of the table's strings. The elements
+ * point into the table and must not be freed individually; they remain valid
+ * until the table is modified or freed.
+ *
+ * Caller is responsible for `free`-ing the returned pointer via
+ * `array_free(array, NULL)`.
+ */
+array_t *strtab_to_array(strtab_t *tab);
+
+/**
+ * strtab_free deallocates the table and every string in it.
+ */
+void strtab_free(strtab_t *tab);
+
+/**
+ * sv_split_table splits `input` on `delim` like sv_tokenizer_t, collecting the
+ * tokens into a strtab_t*.
+ *
+ * Caller is responsible for `free`-ing the returned pointer via strtab_free.
+ */
+strtab_t *sv_split_table(sv_t input, sv_t delim, bool keep_empty);
+
+/**
+ * s_split_table behaves like s_split but returns its tokens in a strtab_t*.
+ *
+ * Caller is responsible for `free`-ing the returned pointer via strtab_free.
+ */
+strtab_t *s_split_table(const char *s, const char *delim);
+
+/**
+ * Minimum number of input bytes each sv_par_split worker thread is given.
+ * Inputs smaller than two chunks are split on the calling thread.
+ */
+#ifndef LIB_UTIL_PAR_SPLIT_MIN_CHUNK
+#define LIB_UTIL_PAR_SPLIT_MIN_CHUNK (1024 * 1024)
+#endif
+
+/**
+ * sv_par_split behaves like sv_split_table but splits large inputs on up to
+ * `n_threads` threads. The input is cut at delimiter boundaries into one chunk
+ * per thread, each chunk is tokenized independently and the results are
+ * stitched together in order, so the tokens are exactly those sv_split_table
+ * would return. Pass 0 for `n_threads` to use one thread per online CPU.
+ *
+ * Delimiters whose occurrences may overlap one another (e.g. "aa") can't be
+ * cut at safely, so inputs split on them are always tokenized sequentially.
+ *
+ * Caller is responsible for `free`-ing the returned pointer via strtab_free.
+ */
+strtab_t *sv_par_split(sv_t input, sv_t delim, bool keep_empty,
+                       size_t n_threads);
+
+/**
+ * s_par_split behaves like s_split_table but splits large inputs in parallel,
+ * as sv_par_split does.
+ *
+ * Caller is responsible for `free`-ing the returned pointer via strtab_free.
+ */
+strtab_t *s_par_split(const char *s, const char *delim, size_t n_threads);
+
+/**
+ * Number of independently locked shards in an interner_t.
+ */
+#ifndef LIB_UTIL_INTERNER_SHARDS
+#define LIB_UTIL_INTERNER_SHARDS 16
+#endif
+
+/**
+ * Size, in bytes, of the arena chunks an interner_t copies strings into.
+ */
+#ifndef LIB_UTIL_INTERNER_CHUNK_SZ
+#define LIB_UTIL_INTERNER_CHUNK_SZ 65536
+#endif
+
+/**
+ * interner_t* maps equal strings to one canonical copy, so that strings
+ * interned by the same interner are equal exactly when their pointers are.
+ * Copies are packed into arena chunks that live as long as the interner.
+ *
+ * An interner may be used from any number of threads at once. Looking up an
+ * already-interned string takes no lock, and new strings are added to one of
+ * LIB_UTIL_INTERNER_SHARDS independently locked shards.
+ */
+typedef struct __interner interner_t;
+
+/**
+ * interner_init initializes and returns a new, empty interner_t*.
+ *
+ * Caller is responsible for `free`-ing the returned pointer via
+ * interner_free.
+ */
+interner_t *interner_init(void);
+
+/**
+ * interner_intern returns the canonical copy of `s`, copying it into the
+ * interner if it isn't there already. The copy must not be modified or freed,
+ * and is valid until the interner is freed.
+ */
+const char *interner_intern(interner_t *in, const char *s);
+
+/**
+ * interner_intern_n behaves like interner_intern for the `len` bytes at `s`,
+ * which may contain NUL bytes. The canonical copy is NUL-terminated.
+ */
+const char *interner_intern_n(interner_t *in, const char *s, size_t len);
+
+/**
+ * interner_lookup_n returns the canonical copy of the `len` bytes at `s`, or
+ * NULL if they haven't been interned. Never modifies the interner.
+ */
+const char *interner_lookup_n(interner_t *in, const char *s, size_t len);
+
+/**
+ * interner_size returns the number of distinct strings in the interner.
+ */
+size_t interner_size(interner_t *in);
+
+/**
+ * interner_free deallocates the interner and every canonical copy in it.
+ */
+void interner_free(interner_t *in);
+
+/**
+ * Chunk size for io_read_all. This is the number of bytes by which io_read_all
+ * increments its reads. OK to be larger than total bytes.
+ */
+#ifndef IO_IO_READ_ALL_CHUNK_SZ
+#define IO_IO_READ_ALL_CHUNK_SZ 262144
+#endif
+
+/**
+ * Chunk size for io_write_all. This is the number of bytes by which
+ * io_write_all increments its writes. OK to be larger than total bytes but use
+ * judiciously.
+ */
+#ifndef IO_IO_WRITE_ALL_CHUNK_SZ
+#define IO_IO_WRITE_ALL_CHUNK_SZ 1024
+#endif
+
+typedef enum {
+  IO_READ_ALL_OK = 0,          // Success
+  IO_READ_ALL_ERR = -1,        // Stream err
+  IO_READ_ALL_INVALID = -2,    // Bad input
+  IO_READ_ALL_TOO_LARGE = -3,  // Input too large
+  IO_READ_ALL_NOMEM = -4       // Out of memory
+} io_read_all_result;
+
+typedef enum {
+  IO_WRITE_ALL_OK = 0,           // Success
+  IO_WRITE_ALL_ERR = -1,         // General error
+  IO_WRITE_ALL_INVALID = -2,     // Bad data or file descriptor
+  IO_WRITE_ALL_INCOMPLETE = -3,  // Failed to complete write
+} io_write_all_result;
+
+/**
+ * Reads all data from the given file descriptor `fd`.
+ *
+ * @param fd An opened file descriptor.
+ * @param data_ptr A pointer where the read data will be stored. Note, you can
+ * safely malloc(0) - this will be realloc'd based on the data size after
+ * reading.
+ * @param n_read_ptr A pointer where the number of bytes read will be stored.
+ * @return io_read_all_result
+ */
+io_read_all_result io_read_all(FILE *fd, char **data_ptr, size_t *n_read_ptr);
+
+/**
+ * Writes all data to the given file descriptor `fd`.
+ *
+ * @param fd An opened file descriptor.
+ * @param data A pointer to the data to be written in full.
+ * @param n_write_ptr A pointer where the number of bytes written will be
+ * stored.
+ * @return io_write_all_result
+ */
+io_write_all_result io_write_all(FILE *fd, const char *data,
+                                 size_t *n_write_ptr);
+
+/**
+ * Writes all of the given vectors to the file descriptor `fd` using writev,
+ * resuming after partial writes and retrying on EINTR. The `iov` array is
+ * advanced in-place as data is written, so it should be considered consumed
+ * once this function returns.
+ *
+ * @param fd An open file descriptor.
+ * @param iov The vectors to write, in order.
+ * @param iovcnt The number of vectors in `iov`. May exceed IOV_MAX.
+ * @param n_write_ptr An optional pointer where the number of bytes written will
+ * be stored.
+ * @return io_write_all_result
+ */
+io_write_all_result io_writev_all(int fd, struct iovec *iov, int iovcnt,
+                                  size_t *n_write_ptr);
+
+/**
+ * buffer_write_fd writes the full contents of `buf` to the file descriptor
+ * `fd`, resuming after partial writes and retrying on EINTR. Unlike
+ * io_write_all, the buffer's known length is used as-is and no stdio buffering
+ * is involved.
+ *
+ * @param buf The buffer to write.
+ * @param fd An open file descriptor.
+ * @return io_write_all_result
+ */
+io_write_all_result buffer_write_fd(buffer_t *buf, int fd);
+
+/**
+ * buffers_writev writes the contents of `n` buffers to the file descriptor
+ * `fd`, in order, with as few writev calls as possible. No intermediate copy of
+ * the buffers is made.
+ *
+ * @param fd An open file descriptor.
+ * @param bufs The buffers to write.
+ * @param n The number of buffers in `bufs`.
+ * @return io_write_all_result
+ */
+io_write_all_result buffers_writev(int fd, buffer_t **bufs, size_t n);
+
+/**
+ * Default size of each chunk in a rope_t. Chunks are allocated once and never
+ * reallocated, so bytes appended to a rope never move.
+ */
+#ifndef LIB_UTIL_ROPE_CHUNK_SZ
+#define LIB_UTIL_ROPE_CHUNK_SZ 65536
+#endif
+
+typedef struct __rope_chunk {
+  struct __rope_chunk *next;
+  size_t len;
+  size_t cap;
+  char data[];
+} __rope_chunk_t;
+
+typedef struct {
+  __rope_chunk_t *head;
+  __rope_chunk_t *tail;
+  size_t len;
+  size_t num_chunks;
+  size_t chunk_sz;
+} __rope_t;
+
+/**
+ * rope_t* represents an append-only byte sequence stored as a list of fixed
+ * size chunks. Unlike buffer_t, growing a rope never copies what it already
+ * holds, which keeps peak memory close to the payload size for very large
+ * outputs.
+ */
+typedef __rope_t *rope_t;
+
+/**
+ * rope_chunk_fn is invoked by rope_foreach_chunk with each chunk's data and
+ * length. Returning false stops the iteration.
+ */
+typedef bool rope_chunk_fn(const char *data, size_t len, void *ctx);
+
+/**
+ * rope_init initializes and returns a new rope_t* whose chunks are `chunk_sz`
+ * bytes. Pass 0 to use LIB_UTIL_ROPE_CHUNK_SZ.
+ *
+ * Caller is responsible for `free`-ing the returned pointer via rope_free.
+ */
+rope_t *rope_init(size_t chunk_sz);
+
+/**
+ * rope_size returns the total number of bytes held by the rope.
+ */
+size_t rope_size(rope_t *rope);
+
+/**
+ * rope_num_chunks returns the number of chunks the rope has allocated.
+ */
+size_t rope_num_chunks(rope_t *rope);
+
+/**
+ * rope_append appends a string `s` to the given rope.
+ */
+bool rope_append(rope_t *rope, const char *s);
+
+/**
+ * rope_append_with appends `len` bytes of `s` to the given rope. `s` need not
+ * be NUL-terminated.
+ */
+bool rope_append_with(rope_t *rope, const char *s, size_t len);
+
+/**
+ * rope_append_char appends a char to the given rope.
+ */
+bool rope_append_char(rope_t *rope, const char c);
+
+/**
+ * rope_append_buffer appends the contents of `buf` to the given rope.
+ */
+bool rope_append_buffer(rope_t *rope, buffer_t *buf);
+
+/**
+ * rope_foreach_chunk invokes `callback` with each non-empty chunk of the rope,
+ * in order, until the callback returns false.
+ */
+void rope_foreach_chunk(rope_t *rope, rope_chunk_fn *callback, void *ctx);
+
+/**
+ * rope_flatten copies the rope's contents into a single NUL-terminated string.
+ *
+ * Caller is responsible for `free`-ing the returned pointer.
+ */
+char *rope_flatten(rope_t *rope);
+
+/**
+ * rope_write_fd writes the rope's contents to the file descriptor `fd` with
+ * writev, without first copying the chunks into contiguous memory.
+ *
+ * @param rope The rope to write.
+ * @param fd An open file descriptor.
+ * @param n_write_ptr An optional pointer where the number of bytes written will
+ * be stored.
+ * @return io_write_all_result
+ */
+io_write_all_result rope_write_fd(rope_t *rope, int fd, size_t *n_write_ptr);
+
+/**
+ * rope_write_file flushes `fp` and then writes the rope's contents to its
+ * underlying file descriptor. See rope_write_fd.
+ */
+io_write_all_result rope_write_file(rope_t *rope, FILE *fp,
+                                    size_t *n_write_ptr);
+
+/**
+ * rope_free deallocates the rope and all of its chunks.
+ */
+void rope_free(rope_t *rope);
+
+/**
+ * ring_t* is a lock-free, single-producer/single-consumer byte ring buffer.
+ * Exactly one thread may call the producer functions (ring_reserve,
+ * ring_commit, ring_write, ring_fill_fd) and exactly one thread the consumer
+ * functions (ring_peek, ring_consume, ring_read) at a time.
+ *
+ * When created mirrored, the ring's storage is mapped twice back-to-back in
+ * virtual memory, so spans handed out by ring_reserve and ring_peek cover all
+ * available bytes and never wrap.
+ */
+typedef struct __ring ring_t;
+
+/**
+ * ring_init initializes and returns a new ring_t* holding at least `capacity`
+ * bytes. The capacity is rounded up to a power of two (and, if mirrored, to a
+ * multiple of the page size).
+ *
+ * @param capacity The minimum capacity in bytes, at most SIZE_MAX / 2 + 1.
+ * @param mirrored Whether to use a mirrored mapping. If the platform doesn't
+ * support it, the ring silently falls back to ordinary memory; see
+ * ring_is_mirrored.
+ * @return ring_t* or NULL on failure
+ *
+ * Caller is responsible for `free`-ing the returned pointer via ring_free.
+ */
+ring_t *ring_init(size_t capacity, bool mirrored);
+
+/**
+ * ring_capacity returns the total number of bytes the ring can hold.
+ */
+size_t ring_capacity(ring_t *ring);
+
+/**
+ * ring_is_mirrored returns whether the ring's storage is mirrored.
+ */
+bool ring_is_mirrored(ring_t *ring);
+
+/**
+ * ring_size returns the number of bytes currently readable. From the producer
+ * this is an upper bound and from the consumer a lower bound.
+ */
+size_t ring_size(ring_t *ring);
+
+/**
+ * ring_reserve returns a pointer to a contiguous writable span of the ring and
+ * stores its length in `len`, or returns NULL if the ring is full. Bytes
+ * written to the span become visible to the consumer after ring_commit.
+ *
+ * Producer only.
+ */
+char *ring_reserve(ring_t *ring, size_t *len);
+
+/**
+ * ring_commit publishes `n` bytes written to the span from ring_reserve.
+ *
+ * Producer only.
+ */
+void ring_commit(ring_t *ring, size_t n);
+
+/**
+ * ring_write copies up to `len` bytes of `data` into the ring and returns the
+ * number of bytes copied, which is less than `len` if the ring fills.
+ *
+ * Producer only.
+ */
+size_t ring_write(ring_t *ring, const char *data, size_t len);
+
+/**
+ * ring_fill_fd performs a single read(2) from `fd` directly into the ring's
+ * free space, retrying on EINTR.
+ *
+ * Producer only.
+ *
+ * @return The number of bytes read, 0 on end of file, or -1 on error with errno
+ * set. If the ring is full, returns -1 with errno set to ENOBUFS.
+ */
+ssize_t ring_fill_fd(ring_t *ring, int fd);
+
+/**
+ * ring_peek returns a pointer to a contiguous readable span of the ring and
+ * stores its length in `len`, or returns NULL if the ring is empty. The bytes
+ * stay in the ring until ring_consume.
+ *
+ * Consumer only.
+ */
+const char *ring_peek(ring_t *ring, size_t *len);
+
+/**
+ * ring_consume releases `n` bytes from the front of the ring back to the
+ * producer.
+ *
+ * Consumer only.
+ */
+void ring_consume(ring_t *ring, size_t n);
+
+/**
+ * ring_read copies up to `len` bytes out of the ring into `dest` and returns
+ * the number of bytes copied.
+ *
+ * Consumer only.
+ */
+size_t ring_read(ring_t *ring, char *dest, size_t len);
+
+/**
+ * ring_free deallocates the ring. Neither the producer nor the consumer may be
+ * using it.
+ */
+void ring_free(ring_t *ring);
+
+/**
+ * u_crc32c returns the CRC-32C (Castagnoli) checksum of `len` bytes of `data`.
+ * Uses the SSE4.2 crc32 instruction where available.
+ */
+uint32_t u_crc32c(const char *data, size_t len);
+
+/**
+ * u_crc32c_update extends a checksum previously returned by u_crc32c or
+ * u_crc32c_update with `len` more bytes of `data`. Checksumming input in
+ * pieces yields the same result as checksumming it all at once; start from 0.
+ */
+uint32_t u_crc32c_update(uint32_t crc, const char *data, size_t len);
+
+/**
+ * u_hash64 returns a fast, non-cryptographic 64-bit hash of `len` bytes of
+ * `data`, derived from wyhash. Not suitable where an attacker can choose the
+ * input, unless `seed` is kept secret.
+ */
+uint64_t u_hash64(const char *data, size_t len, uint64_t seed);
+
+/**
+ * u_hash_str returns u_hash64 of the string `s` with a seed of 0.
+ */
+uint64_t u_hash_str(const char *s);
+
+/**
+ * u_hash_buffer returns u_hash64 of the contents of `buf` with a seed of 0.
+ */
+uint64_t u_hash_buffer(buffer_t *buf);
+
+/**
+ * u_hash_state_t holds an incremental u_hash64 computation. Its fields are
+ * private.
+ */
+typedef struct {
+  uint64_t seed;
+  uint64_t see1;
+  uint64_t see2;
+  uint64_t total;
+  size_t pending;
+  unsigned char buf[80];
+} u_hash_state_t;
+
+/**
+ * u_hash_init begins an incremental hash with the given seed.
+ */
+void u_hash_init(u_hash_state_t *state, uint64_t seed);
+
+/**
+ * u_hash_update feeds `len` bytes of `data` into the hash.
+ */
+void u_hash_update(u_hash_state_t *state, const char *data, size_t len);
+
+/**
+ * u_hash_digest returns the hash of all input so far, equal to u_hash64 over
+ * the concatenated input. The state may continue to be updated afterwards.
+ */
+uint64_t u_hash_digest(u_hash_state_t *state);
+
+typedef enum {
+  HASHMAP_KEY_STR,  // NUL-terminated strings, compared by content
+  HASHMAP_KEY_INT,  // Integers cast to void *, compared by value
+  HASHMAP_KEY_PTR   // Pointers, compared by address
+} hashmap_key_mode;
+
+/**
+ * hashmap_t* is an open-addressing hash map in the style of Abseil's Swiss
+ * tables. Slots are probed 16 at a time by comparing a byte of metadata per
+ * slot, with SSE2 where available, so lookups rarely compare more than one
+ * key. Deleted entries leave tombstones, which are cleared out when the map is
+ * next rehashed.
+ *
+ * String keys are copied into the map. Integer and pointer keys are stored
+ * as-is; to use an integer key, cast it to void * as with array_t elements.
+ */
+typedef struct __hashmap hashmap_t;
+
+/**
+ * hashmap_init initializes and returns a new, empty hashmap_t* whose keys are
+ * of the given kind. If `free_value` is not NULL, it is called on each value
+ * that is replaced, deleted, or still in the map when it is freed.
+ *
+ * Caller is responsible for `free`-ing the returned pointer via hashmap_free.
+ */
+hashmap_t *hashmap_init(hashmap_key_mode mode, free_fn *free_value);
+
+/**
+ * hashmap_reserve makes room for at least `n` entries, so that inserting up to
+ * that many won't rehash. Returns false if out of memory, or if `n` is too
+ * large for a table to hold.
+ */
+bool hashmap_reserve(hashmap_t *map, size_t n);
+
+/**
+ * hashmap_set maps `key` to `value`, replacing any value the key already had.
+ * Returns false if out of memory, or for a NULL string key.
+ */
+bool hashmap_set(hashmap_t *map, const void *key, void *value);
+
+/**
+ * hashmap_get returns the value mapped to `key`, or NULL if there is none.
+ */
+void *hashmap_get(hashmap_t *map, const void *key);
+
+/**
+ * hashmap_has returns a bool indicating whether the map contains `key`, which
+ * distinguishes a key mapped to NULL from a missing one.
+ */
+bool hashmap_has(hashmap_t *map, const void *key);
+
+/**
+ * hashmap_delete removes `key` and its value from the map. Returns false if
+ * the key wasn't there.
+ */
+bool hashmap_delete(hashmap_t *map, const void *key);
+
+/**
+ * hashmap_size returns the number of entries in the map.
+ */
+size_t hashmap_size(hashmap_t *map);
+
+/**
+ * hashmap_next advances the iterator `iter`, which must start at 0, to the
+ * map's next entry and stores its key and value in `key` and `value` (either
+ * may be NULL). Returns false once every entry has been visited. Entries are
+ * visited in no particular order, and setting or deleting keys invalidates
+ * the iterator.
+ *
+ *   size_t iter = 0;
+ *   const void *key;
+ *   void *value;
+ *   while (hashmap_next(map, &iter, &key, &value)) { ... }
+ */
+bool hashmap_next(hashmap_t *map, size_t *iter, const void **key,
+                  void **value);
+
+/**
+ * hashmap_free deallocates the map, its string keys and, given a `free_value`
+ * callback, its values.
+ */
+void hashmap_free(hashmap_t *map);
+
+/**
+ * Largest uncompressed block in frames written by the lz_ functions. Must be
+ * one of the LZ4 frame format's block sizes: 64KB, 256KB, 1MB or 4MB.
+ */
+#ifndef LIB_UTIL_LZ_BLOCK_MAX_SZ
+#define LIB_UTIL_LZ_BLOCK_MAX_SZ 65536
+#endif
+
+typedef enum {
+  LZ_OK = 0,                // Success
+  LZ_ERR_INVALID = -1,      // Bad input
+  LZ_ERR_CORRUPT = -2,      // Malformed or truncated compressed data
+  LZ_ERR_UNSUPPORTED = -3,  // Frame uses a dictionary
+  LZ_ERR_IO = -4,           // Stream err
+  LZ_ERR_NOMEM = -5         // Out of memory
+} lz_result;
+
+/**
+ * lz_compress_bound returns the most space compressing `len` bytes with
+ * lz_compress_block can take.
+ */
+size_t lz_compress_bound(size_t len);
+
+/**
+ * lz_compress_block compresses `len` bytes of `src` into a single raw LZ4
+ * block, with no framing, and returns the compressed size. `dest` must hold at
+ * least lz_compress_bound(len) bytes.
+ */
+size_t lz_compress_block(const char *src, size_t len, char *dest);
+
+/**
+ * lz_decompress_block decompresses a raw LZ4 block of `len` bytes into `dest`,
+ * which holds `cap` bytes. The input is fully validated: malformed data or
+ * output that would exceed `cap` yields LZ_ERR_CORRUPT rather than an
+ * out-of-bounds access.
+ *
+ * @param src The compressed block.
+ * @param len The length of the compressed block.
+ * @param dest Where to write the decompressed bytes.
+ * @param cap The capacity of `dest`.
+ * @param n_out Where the number of decompressed bytes will be stored.
+ * @return lz_result
+ */
+lz_result lz_decompress_block(const char *src, size_t len, char *dest,
+                              size_t cap, size_t *n_out);
+
+/**
+ * buffer_append_compressed compresses `len` bytes of `data` and appends them
+ * to `buf` as an LZ4 frame, which the lz4 command-line tool can read.
+ */
+bool buffer_append_compressed(buffer_t *buf, const char *data, size_t len);
+
+/**
+ * buffer_append_decompressed decompresses one or more concatenated LZ4 frames
+ * in `data` and appends the original bytes to `buf`. Checksums present in the
+ * frames are verified. On failure, the buffer is left unchanged.
+ *
+ * @return lz_result
+ */
+lz_result buffer_append_decompressed(buffer_t *buf, const char *data,
+                                     size_t len);
+
+/**
+ * lz_compress_file reads `src` to the end and writes it to `dest` as an LZ4
+ * frame, holding only a block at a time in memory.
+ *
+ * @param src A readable stream.
+ * @param dest A writable stream.
+ * @return lz_result
+ */
+lz_result lz_compress_file(FILE *src, FILE *dest);
+
+/**
+ * lz_decompress_file reads LZ4 frames from `src` to the end, writing the
+ * decompressed bytes to `dest` as each block is decoded. On failure, `dest`
+ * may have received part of the output.
+ *
+ * @param src A readable stream.
+ * @param dest A writable stream.
+ * @return lz_result
+ */
+lz_result lz_decompress_file(FILE *src, FILE *dest);
 
 /**
  * Checks if the file is a pointer to a relative directory reference i.e. is it
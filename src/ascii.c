@@ -0,0 +1,255 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libutil.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ASCII_X86 1
+#include <immintrin.h>
+#endif
+
+static unsigned char ascii_lower(unsigned char c) {
+  return (unsigned char)(c - 'A') < 26 ? c | 0x20 : c;
+}
+
+static unsigned char ascii_upper(unsigned char c) {
+  return (unsigned char)(c - 'a') < 26 ? c & ~0x20 : c;
+}
+
+#ifdef ASCII_X86
+
+// Letters to flip are found with one signed compare: adding 0x80 - 'a' (or
+// 'A') moves that range of 26 to the very bottom of the signed byte range, so
+// exactly those bytes compare less than -128 + 26. Unlike toupper and tolower,
+// this ignores the locale
+
+__attribute__((target("sse2"))) static size_t case_convert_sse2(
+    char *dst, const char *src, size_t len, bool upper) {
+  const __m128i shift = _mm_set1_epi8((char)(0x80 - (upper ? 'a' : 'A')));
+  const __m128i limit = _mm_set1_epi8((char)(0x80 + 26));
+  const __m128i flip = _mm_set1_epi8(0x20);
+  size_t i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+    __m128i letters = _mm_cmpgt_epi8(limit, _mm_add_epi8(v, shift));
+    _mm_storeu_si128((__m128i *)(dst + i),
+                     _mm_xor_si128(v, _mm_and_si128(letters, flip)));
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2"))) static size_t case_convert_avx2(
+    char *dst, const char *src, size_t len, bool upper) {
+  const __m256i shift = _mm256_set1_epi8((char)(0x80 - (upper ? 'a' : 'A')));
+  const __m256i limit = _mm256_set1_epi8((char)(0x80 + 26));
+  const __m256i flip = _mm256_set1_epi8(0x20);
+  size_t i = 0;
+
+  for (; i + 32 <= len; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+    __m256i letters = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(v, shift));
+    _mm256_storeu_si256((__m256i *)(dst + i),
+                        _mm256_xor_si256(v, _mm256_and_si256(letters, flip)));
+  }
+
+  return i;
+}
+
+__attribute__((target("sse2"))) static __m128i fold_sse2(__m128i v) {
+  const __m128i shift = _mm_set1_epi8((char)(0x80 - 'A'));
+  const __m128i limit = _mm_set1_epi8((char)(0x80 + 26));
+  __m128i letters = _mm_cmpgt_epi8(limit, _mm_add_epi8(v, shift));
+  return _mm_or_si128(v, _mm_and_si128(letters, _mm_set1_epi8(0x20)));
+}
+
+__attribute__((target("avx2"))) static __m256i fold_avx2(__m256i v) {
+  const __m256i shift = _mm256_set1_epi8((char)(0x80 - 'A'));
+  const __m256i limit = _mm256_set1_epi8((char)(0x80 + 26));
+  __m256i letters = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(v, shift));
+  return _mm256_or_si256(v, _mm256_and_si256(letters, _mm256_set1_epi8(0x20)));
+}
+
+__attribute__((target("sse2"))) static size_t mismatch_sse2(const char *s1,
+                                                             const char *s2,
+                                                             size_t len) {
+  size_t i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    __m128i a = fold_sse2(_mm_loadu_si128((const __m128i *)(s1 + i)));
+    __m128i b = fold_sse2(_mm_loadu_si128((const __m128i *)(s2 + i)));
+    unsigned mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) & 0xffff;
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2"))) static size_t mismatch_avx2(const char *s1,
+                                                             const char *s2,
+                                                             size_t len) {
+  size_t i = 0;
+
+  for (; i + 32 <= len; i += 32) {
+    __m256i a = fold_avx2(_mm256_loadu_si256((const __m256i *)(s1 + i)));
+    __m256i b = fold_avx2(_mm256_loadu_si256((const __m256i *)(s2 + i)));
+    uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+
+  return i;
+}
+
+#endif
+
+// SWAR versions of the vector kernels for the last few bytes, which for short
+// strings like header names are all of them. Masking off each byte's top bit
+// first keeps the additions from carrying into the next byte, and bytes that
+// had it set aren't ASCII, so aren't letters
+#define ASCII_ONES 0x0101010101010101ULL
+
+static uint64_t swar_letters(uint64_t x, unsigned char first) {
+  uint64_t low7 = x & (0x7f * ASCII_ONES);
+  uint64_t ge_first = low7 + (0x80 - first) * ASCII_ONES;
+  uint64_t gt_last = low7 + (0x7f - (first + 25)) * ASCII_ONES;
+  return (ge_first ^ gt_last) & ~x & (0x80 * ASCII_ONES);
+}
+
+static uint64_t swar_lower(uint64_t x) { return x | swar_letters(x, 'A') >> 2; }
+
+static uint64_t swar_upper(uint64_t x) {
+  return x & ~(swar_letters(x, 'a') >> 2);
+}
+
+// Runs the widest kernel the CPU supports over whole blocks, then SSE2 over
+// any 16-byte block left. Calling the SSE2 kernel from inside the AVX2 one
+// instead would run legacy SSE instructions while the upper halves of the
+// ymm registers are dirty, which costs hundreds of cycles per call on some
+// CPUs; by the time the AVX2 kernel has returned, they've been cleared
+static void case_convert(char *dst, const char *src, size_t len, bool upper) {
+  size_t i = 0;
+
+#ifdef ASCII_X86
+  if (len >= 16) {
+    if (__builtin_cpu_supports("avx2")) {
+      i = case_convert_avx2(dst, src, len, upper);
+    }
+    if (__builtin_cpu_supports("sse2")) {
+      i += case_convert_sse2(dst + i, src + i, len - i, upper);
+    }
+  }
+#endif
+
+  for (; i + 8 <= len; i += 8) {
+    uint64_t x;
+    memcpy(&x, src + i, 8);
+    x = upper ? swar_upper(x) : swar_lower(x);
+    memcpy(dst + i, &x, 8);
+  }
+
+  for (; i < len; i++) {
+    unsigned char c = src[i];
+    dst[i] = upper ? ascii_upper(c) : ascii_lower(c);
+  }
+}
+
+// Returns the index of the first byte at which the strings differ ignoring
+// ASCII case, or `len` if there is none
+static size_t case_mismatch(const char *s1, const char *s2, size_t len) {
+  size_t i = 0;
+
+#ifdef ASCII_X86
+  if (len >= 16) {
+    if (__builtin_cpu_supports("avx2")) {
+      i = mismatch_avx2(s1, s2, len);
+    }
+    if (i + 16 <= len && __builtin_cpu_supports("sse2")) {
+      i += mismatch_sse2(s1 + i, s2 + i, len - i);
+    }
+  }
+#endif
+
+  // Stops at the word holding the mismatch, which the loop below pins down
+  for (; i + 8 <= len; i += 8) {
+    uint64_t a, b;
+    memcpy(&a, s1 + i, 8);
+    memcpy(&b, s2 + i, 8);
+    if (swar_lower(a) != swar_lower(b)) {
+      break;
+    }
+  }
+
+  while (i < len && ascii_lower(s1[i]) == ascii_lower(s2[i])) {
+    i++;
+  }
+
+  return i;
+}
+
+void s_upper_into(char *dst, const char *src, size_t len) {
+  case_convert(dst, src, len, true);
+}
+
+void s_lower_into(char *dst, const char *src, size_t len) {
+  case_convert(dst, src, len, false);
+}
+
+static char *case_copy(const char *s, bool upper) {
+  if (s == NULL) {
+    return NULL;
+  }
+
+  size_t len = strlen(s);
+  char *ret = malloc(len + 1);
+  if (!ret) {
+    return NULL;
+  }
+
+  case_convert(ret, s, len, upper);
+  ret[len] = '\0';
+
+  return ret;
+}
+
+char *s_upper(const char *s) { return case_copy(s, true); }
+
+char *s_lower(const char *s) { return case_copy(s, false); }
+
+char *s_upper_inplace(char *s) {
+  if (s != NULL) {
+    case_convert(s, s, strlen(s), true);
+  }
+
+  return s;
+}
+
+char *s_lower_inplace(char *s) {
+  if (s != NULL) {
+    case_convert(s, s, strlen(s), false);
+  }
+
+  return s;
+}
+
+bool s_casecmp_n(const char *s1, size_t len1, const char *s2, size_t len2) {
+  return len1 == len2 && case_mismatch(s1, s2, len1) == len1;
+}
+
+int s_casecompare_n(const char *s1, size_t len1, const char *s2,
+                    size_t len2) {
+  size_t len = len1 < len2 ? len1 : len2;
+  size_t i = case_mismatch(s1, s2, len);
+
+  if (i < len) {
+    return ascii_lower(s1[i]) - ascii_lower(s2[i]);
+  }
+
+  // One is a prefix of the other, so the shorter sorts first
+  return (len1 > len2) - (len1 < len2);
+}
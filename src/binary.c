@@ -0,0 +1,205 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "libutil.h"
+
+// A 64-bit value needs at most ceil(64 / 7) LEB128 bytes
+#define VARINT_MAX_BYTES 10
+
+static uint64_t zigzag_encode(int64_t v) {
+  return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t zigzag_decode(uint64_t v) {
+  return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static size_t varint_encode(uint64_t v, unsigned char *dest) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    dest[n++] = (unsigned char)(v | 0x80);
+    v >>= 7;
+  }
+  dest[n++] = (unsigned char)v;
+
+  return n;
+}
+
+static bool buffer_append_le(buffer_t *buf, uint64_t v, size_t width) {
+  unsigned char tmp[8];
+  for (size_t i = 0; i < width; i++) {
+    tmp[i] = (unsigned char)(v >> (i * 8));
+  }
+
+  return buffer_append_with(buf, (const char *)tmp, width);
+}
+
+bool buffer_append_u8(buffer_t *buf, uint8_t v) {
+  return buffer_append_le(buf, v, 1);
+}
+
+bool buffer_append_u16le(buffer_t *buf, uint16_t v) {
+  return buffer_append_le(buf, v, 2);
+}
+
+bool buffer_append_u32le(buffer_t *buf, uint32_t v) {
+  return buffer_append_le(buf, v, 4);
+}
+
+bool buffer_append_u64le(buffer_t *buf, uint64_t v) {
+  return buffer_append_le(buf, v, 8);
+}
+
+bool buffer_append_varint(buffer_t *buf, uint64_t v) {
+  unsigned char tmp[VARINT_MAX_BYTES];
+  size_t n = varint_encode(v, tmp);
+
+  return buffer_append_with(buf, (const char *)tmp, n);
+}
+
+bool buffer_append_zigzag(buffer_t *buf, int64_t v) {
+  return buffer_append_varint(buf, zigzag_encode(v));
+}
+
+bool buffer_append_prefixed(buffer_t *buf, const char *data, size_t len) {
+  if (!data && len > 0) {
+    return false;
+  }
+
+  size_t before = buffer_size(buf);
+  if (!buffer_reserve(buf, VARINT_MAX_BYTES + len) ||
+      !buffer_append_varint(buf, len)) {
+    return false;
+  }
+
+  if (len > 0 && !buffer_append_with(buf, data, len)) {
+    // Don't leave a dangling length prefix behind
+    ((__buffer_t *)buf)->len = before;
+    buffer_state(buf)[before] = '\0';
+    return false;
+  }
+
+  return true;
+}
+
+buffer_reader_t buffer_reader_init(const char *data, size_t len) {
+  buffer_reader_t reader = {
+      .data = (const unsigned char *)data, .len = len, .pos = 0};
+  return reader;
+}
+
+buffer_reader_t buffer_reader_from(buffer_t *buf) {
+  return buffer_reader_init(buffer_state(buf), buffer_size(buf));
+}
+
+size_t buffer_reader_remaining(buffer_reader_t *reader) {
+  return reader->len - reader->pos;
+}
+
+static bool buffer_read_le(buffer_reader_t *reader, uint64_t *v,
+                           size_t width) {
+  if (buffer_reader_remaining(reader) < width) {
+    return false;
+  }
+
+  const unsigned char *p = &reader->data[reader->pos];
+  uint64_t ret = 0;
+  for (size_t i = 0; i < width; i++) {
+    ret |= (uint64_t)p[i] << (i * 8);
+  }
+
+  reader->pos += width;
+  *v = ret;
+
+  return true;
+}
+
+bool buffer_read_u8(buffer_reader_t *reader, uint8_t *v) {
+  uint64_t tmp;
+  if (!buffer_read_le(reader, &tmp, 1)) {
+    return false;
+  }
+
+  *v = (uint8_t)tmp;
+  return true;
+}
+
+bool buffer_read_u16le(buffer_reader_t *reader, uint16_t *v) {
+  uint64_t tmp;
+  if (!buffer_read_le(reader, &tmp, 2)) {
+    return false;
+  }
+
+  *v = (uint16_t)tmp;
+  return true;
+}
+
+bool buffer_read_u32le(buffer_reader_t *reader, uint32_t *v) {
+  uint64_t tmp;
+  if (!buffer_read_le(reader, &tmp, 4)) {
+    return false;
+  }
+
+  *v = (uint32_t)tmp;
+  return true;
+}
+
+bool buffer_read_u64le(buffer_reader_t *reader, uint64_t *v) {
+  return buffer_read_le(reader, v, 8);
+}
+
+bool buffer_read_varint(buffer_reader_t *reader, uint64_t *v) {
+  const unsigned char *p = &reader->data[reader->pos];
+  size_t remaining = buffer_reader_remaining(reader);
+  uint64_t ret = 0;
+
+  for (size_t i = 0; i < remaining && i < VARINT_MAX_BYTES; i++) {
+    uint64_t byte = p[i];
+
+    // The tenth byte only has room for the top bit of a 64-bit value
+    if (i == VARINT_MAX_BYTES - 1 && byte > 1) {
+      return false;
+    }
+
+    ret |= (byte & 0x7f) << (i * 7);
+
+    if (!(byte & 0x80)) {
+      reader->pos += i + 1;
+      *v = ret;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool buffer_read_zigzag(buffer_reader_t *reader, int64_t *v) {
+  uint64_t tmp;
+  if (!buffer_read_varint(reader, &tmp)) {
+    return false;
+  }
+
+  *v = zigzag_decode(tmp);
+  return true;
+}
+
+bool buffer_read_prefixed(buffer_reader_t *reader, const char **data,
+                          size_t *len) {
+  size_t start = reader->pos;
+  uint64_t n;
+
+  if (!buffer_read_varint(reader, &n)) {
+    return false;
+  }
+
+  if (n > buffer_reader_remaining(reader)) {
+    reader->pos = start;
+    return false;
+  }
+
+  *data = (const char *)&reader->data[reader->pos];
+  *len = n;
+  reader->pos += n;
+
+  return true;
+}
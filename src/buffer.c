@@ -1,13 +1,64 @@
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/uio.h>
 
 #include "libutil.h"
 
+// Number of buffers handed to a single io_writev_all call
+#define BUFFER_IOV_BATCH 64
+
 size_t buffer_size(buffer_t *self) { return ((__buffer_t *)self)->len; }
 
 char *buffer_state(buffer_t *self) { return ((__buffer_t *)self)->state; }
 
+static bool buffer_is_inline(__buffer_t *buf) { return buf->state == buf->sso; }
+
+// Ensures there is room for `n` more bytes plus the NUL terminator, moving
+// the contents out of the inline storage once they no longer fit there
+static bool buffer_grow(__buffer_t *buf, size_t n) {
+  if (n > SIZE_MAX - buf->len - 1) {
+    return false;
+  }
+
+  size_t needed = buf->len + n + 1;
+  if (needed <= buf->cap) {
+    return true;
+  }
+
+  if (buf->state == NULL && needed <= LIB_UTIL_BUFFER_SSO_CAP) {
+    buf->state = buf->sso;
+    buf->cap = LIB_UTIL_BUFFER_SSO_CAP;
+    return true;
+  }
+
+  size_t next_cap = buf->cap * 2;
+  if (next_cap < needed) {
+    next_cap = needed;
+  }
+
+  char *next;
+  if (buffer_is_inline(buf)) {
+    next = malloc(next_cap);
+    if (!next) {
+      return false;
+    }
+
+    memcpy(next, buf->sso, buf->len + 1);
+  } else {
+    next = realloc(buf->state, next_cap);
+    if (!next) {
+      return false;
+    }
+  }
+
+  buf->state = next;
+  buf->cap = next_cap;
+
+  return true;
+}
+
 buffer_t *buffer_init(const char *init) {
   __buffer_t *buf = malloc(sizeof(__buffer_t));
   if (!buf) {
@@ -17,6 +68,7 @@ buffer_t *buffer_init(const char *init) {
 
   buf->state = NULL;
   buf->len = 0;
+  buf->cap = 0;
 
   if (init != NULL) {
     buffer_append((buffer_t *)buf, init);
@@ -25,49 +77,77 @@ buffer_t *buffer_init(const char *init) {
   return (buffer_t *)buf;
 }
 
+bool buffer_reserve(buffer_t *self, size_t n) {
+  return buffer_grow((__buffer_t *)self, n);
+}
+
+void buffer_clear(buffer_t *self) {
+  __buffer_t *unwrapped = (__buffer_t *)self;
+
+  unwrapped->len = 0;
+  if (unwrapped->state) {
+    unwrapped->state[0] = '\0';
+  }
+}
+
 bool buffer_append(buffer_t *self, const char *s) {
   if (!s) {
     return false;
   }
 
+  return buffer_append_with(self, s, strlen(s));
+}
+
+bool buffer_append_char(buffer_t *self, const char c) {
+  return buffer_append_with(self, &c, 1);
+}
+
+bool buffer_appendf(buffer_t *self, const char *fmt, ...) {
   __buffer_t *unwrapped = (__buffer_t *)self;
-  size_t len = strlen(s);
+  va_list args, args_cp;
 
-  // get mem sizeof current str + sizeof append str
-  char *next = realloc(unwrapped->state, unwrapped->len + len + 1);
-  if (!next) {
-    free(next);
+  // Format straight into the spare capacity, and only if that's too small,
+  // grow the buffer and format again
+  if (!buffer_grow(unwrapped, 0)) {
     return false;
   }
 
-  memcpy(&next[unwrapped->len], s, len);
-  next[unwrapped->len + len] = '\0';
-  unwrapped->state = next;
-  unwrapped->len += len;
+  va_start(args, fmt);
+  va_copy(args_cp, args);
+  int n = vsnprintf(unwrapped->state + unwrapped->len,
+                    unwrapped->cap - unwrapped->len, fmt, args);
+  va_end(args);
+
+  if (n >= 0 && (size_t)n >= unwrapped->cap - unwrapped->len) {
+    if (buffer_grow(unwrapped, n)) {
+      vsnprintf(unwrapped->state + unwrapped->len, n + 1, fmt, args_cp);
+    } else {
+      n = -1;
+    }
+  }
+  va_end(args_cp);
 
-  return true;
-}
+  if (n < 0) {
+    // vsnprintf may have written a partial output over the terminator
+    unwrapped->state[unwrapped->len] = '\0';
+    return false;
+  }
 
-bool buffer_append_char(buffer_t *self, const char c) {
-  char tmp[2];
-  tmp[0] = c;
-  tmp[1] = '\0';
+  unwrapped->len += n;
 
-  return buffer_append(self, tmp);
+  return true;
 }
 
 bool buffer_append_with(buffer_t *self, const char *s, size_t len) {
   __buffer_t *unwrapped = (__buffer_t *)self;
 
-  char *next = realloc(unwrapped->state, unwrapped->len + len + 1);
-  if (!next) {
+  if (!buffer_grow(unwrapped, len)) {
     return false;
   }
 
-  memcpy(&next[unwrapped->len], s, len);
-  next[unwrapped->len + len] = '\0';
-  unwrapped->state = next;
+  memcpy(&unwrapped->state[unwrapped->len], s, len);
   unwrapped->len += len;
+  unwrapped->state[unwrapped->len] = '\0';
 
   return true;
 }
@@ -87,15 +167,47 @@ buffer_t *buffer_concat(buffer_t *buf_a, buffer_t *buf_b) {
   return buf;
 }
 
+io_write_all_result buffer_write_fd(buffer_t *self, int fd) {
+  __buffer_t *unwrapped = (__buffer_t *)self;
+  struct iovec iov = {.iov_base = unwrapped->state, .iov_len = unwrapped->len};
+
+  return io_writev_all(fd, &iov, 1, NULL);
+}
+
+io_write_all_result buffers_writev(int fd, buffer_t **bufs, size_t n) {
+  struct iovec iov[BUFFER_IOV_BATCH];
+
+  if (fd < 0 || (bufs == NULL && n > 0)) {
+    return IO_WRITE_ALL_INVALID;
+  }
+
+  size_t i = 0;
+  while (i < n) {
+    int iovcnt = 0;
+    for (; i < n && iovcnt < BUFFER_IOV_BATCH; i++, iovcnt++) {
+      __buffer_t *unwrapped = (__buffer_t *)bufs[i];
+      iov[iovcnt].iov_base = unwrapped->state;
+      iov[iovcnt].iov_len = unwrapped->len;
+    }
+
+    io_write_all_result ret = io_writev_all(fd, iov, iovcnt, NULL);
+    if (ret != IO_WRITE_ALL_OK) {
+      return ret;
+    }
+  }
+
+  return IO_WRITE_ALL_OK;
+}
+
 void buffer_free(buffer_t *self) {
   __buffer_t *unwrapped = (__buffer_t *)self;
 
-  // Because buffer_t's state member is initialized lazily, we need only dealloc
-  // if it was actually allocated to begin with
-  if (unwrapped->len) {
+  // Because buffer_t's state member is initialized lazily and short contents
+  // live inline, we need only dealloc if it was actually allocated
+  if (!buffer_is_inline(unwrapped)) {
     free(unwrapped->state);
-    unwrapped->state = NULL;
   }
+  unwrapped->state = NULL;
 
   free(unwrapped);
 }
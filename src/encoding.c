@@ -0,0 +1,624 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "libutil.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ENCODING_X86 1
+#include <immintrin.h>
+#endif
+
+// Slack reserved past the decoded output so vector kernels may store whole
+// registers even though only part of the last one is meaningful
+#define ENCODING_STORE_SLACK 32
+
+static const char base64_alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static const char hex_alphabet[] = "0123456789abcdef";
+
+static const int8_t base64_values[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,  //
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,  //
+    -1, 0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14,  //
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,  //
+    -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,  //
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,  //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+};
+
+static int hex_value(unsigned char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+
+  c |= 0x20;
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+
+  return -1;
+}
+
+// Vector kernels process as many whole blocks as they can and return the
+// number of input bytes consumed; the scalar code finishes the rest. Decoders
+// also stop at the first block containing anything unexpected, leaving the
+// scalar code to either handle it (padding) or report it
+typedef size_t encode_kernel(const unsigned char *src, size_t len, char *dest);
+typedef size_t decode_kernel(const char *src, size_t len, unsigned char *dest);
+
+#ifdef ENCODING_X86
+
+// Base64 kernels after Wojciech Muła and Daniel Lemire, "Faster Base64
+// Encoding and Decoding Using AVX2 Instructions"
+
+__attribute__((target("ssse3"))) static __m128i base64_enc_reshuffle_ssse3(
+    __m128i in) {
+  in = _mm_shuffle_epi8(
+      in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+  const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+  const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+  const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+  const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+
+  return _mm_or_si128(t1, t3);
+}
+
+__attribute__((target("ssse3"))) static __m128i base64_enc_translate_ssse3(
+    __m128i in) {
+  const __m128i lut = _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4,
+                                    -4, -19, -16, 0, 0);
+
+  __m128i indices = _mm_subs_epu8(in, _mm_set1_epi8(51));
+  const __m128i mask = _mm_cmpgt_epi8(in, _mm_set1_epi8(25));
+  indices = _mm_sub_epi8(indices, mask);
+
+  return _mm_add_epi8(in, _mm_shuffle_epi8(lut, indices));
+}
+
+__attribute__((target("ssse3"))) static size_t base64_encode_ssse3(
+    const unsigned char *src, size_t len, char *dest) {
+  size_t consumed = 0;
+
+  // Each 16-byte load only uses 12 bytes
+  while (len - consumed >= 16) {
+    __m128i in = _mm_loadu_si128((const __m128i *)(src + consumed));
+    in = base64_enc_translate_ssse3(base64_enc_reshuffle_ssse3(in));
+    _mm_storeu_si128((__m128i *)dest, in);
+
+    consumed += 12;
+    dest += 16;
+  }
+
+  return consumed;
+}
+
+__attribute__((target("avx2"))) static size_t base64_encode_avx2(
+    const unsigned char *src, size_t len, char *dest) {
+  const __m256i shuffle =
+      _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10, 1, 0,
+                       2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+  const __m256i lut =
+      _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19,
+                       -16, 0, 0, 65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4,
+                       -4, -19, -16, 0, 0);
+  size_t consumed = 0;
+
+  // Two overlapping 16-byte loads feed 12 bytes into each lane
+  while (len - consumed >= 28) {
+    __m256i in = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(
+            _mm_loadu_si128((const __m128i *)(src + consumed))),
+        _mm_loadu_si128((const __m128i *)(src + consumed + 12)), 1);
+
+    in = _mm256_shuffle_epi8(in, shuffle);
+
+    const __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+    const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+    const __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+    const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+    in = _mm256_or_si256(t1, t3);
+
+    __m256i indices = _mm256_subs_epu8(in, _mm256_set1_epi8(51));
+    const __m256i mask = _mm256_cmpgt_epi8(in, _mm256_set1_epi8(25));
+    indices = _mm256_sub_epi8(indices, mask);
+    in = _mm256_add_epi8(in, _mm256_shuffle_epi8(lut, indices));
+
+    _mm256_storeu_si256((__m256i *)dest, in);
+
+    consumed += 24;
+    dest += 32;
+  }
+
+  return consumed;
+}
+
+__attribute__((target("ssse3"))) static size_t base64_decode_ssse3(
+    const char *src, size_t len, unsigned char *dest) {
+  const __m128i lut_lo =
+      _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                    0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+  const __m128i lut_hi =
+      _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10,
+                    0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m128i lut_roll =
+      _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i mask_2f = _mm_set1_epi8(0x2f);
+  size_t consumed = 0;
+
+  while (len - consumed >= 16) {
+    __m128i in = _mm_loadu_si128((const __m128i *)(src + consumed));
+
+    const __m128i hi_nibbles =
+        _mm_and_si128(_mm_srli_epi32(in, 4), mask_2f);
+    const __m128i lo_nibbles = _mm_and_si128(in, mask_2f);
+    const __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+    const __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi),
+                                         _mm_setzero_si128())) != 0xffff) {
+      break;
+    }
+
+    const __m128i eq_2f = _mm_cmpeq_epi8(in, mask_2f);
+    const __m128i roll =
+        _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles));
+    in = _mm_add_epi8(in, roll);
+
+    // Pack four 6-bit values into three bytes within each 32-bit lane
+    const __m128i merged =
+        _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+    __m128i out = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+    out = _mm_shuffle_epi8(out, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14,
+                                              13, 12, -1, -1, -1, -1));
+    _mm_storeu_si128((__m128i *)dest, out);
+
+    consumed += 16;
+    dest += 12;
+  }
+
+  return consumed;
+}
+
+__attribute__((target("avx2"))) static size_t base64_decode_avx2(
+    const char *src, size_t len, unsigned char *dest) {
+  const __m256i lut_lo = _mm256_setr_epi8(
+      0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a,
+      0x1b, 0x1b, 0x1b, 0x1a, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+      0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+  const __m256i lut_hi = _mm256_setr_epi8(
+      0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m256i lut_roll = _mm256_setr_epi8(
+      0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16, 19, 4,
+      -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i pack = _mm256_setr_epi8(
+      2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4,
+      10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+  size_t consumed = 0;
+
+  while (len - consumed >= 32) {
+    __m256i in = _mm256_loadu_si256((const __m256i *)(src + consumed));
+
+    const __m256i hi_nibbles =
+        _mm256_and_si256(_mm256_srli_epi32(in, 4), mask_2f);
+    const __m256i lo_nibbles = _mm256_and_si256(in, mask_2f);
+    const __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+    const __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+
+    if (!_mm256_testz_si256(lo, hi)) {
+      break;
+    }
+
+    const __m256i eq_2f = _mm256_cmpeq_epi8(in, mask_2f);
+    const __m256i roll =
+        _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+    in = _mm256_add_epi8(in, roll);
+
+    const __m256i merged =
+        _mm256_maddubs_epi16(in, _mm256_set1_epi32(0x01400140));
+    __m256i out = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+    out = _mm256_shuffle_epi8(out, pack);
+    // Close the 4-byte gap between the lanes' 12-byte results
+    out = _mm256_permutevar8x32_epi32(
+        out, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+    _mm256_storeu_si256((__m256i *)dest, out);
+
+    consumed += 32;
+    dest += 24;
+  }
+
+  return consumed;
+}
+
+__attribute__((target("ssse3"))) static size_t hex_encode_ssse3(
+    const unsigned char *src, size_t len, char *dest) {
+  const __m128i lut = _mm_loadu_si128((const __m128i *)hex_alphabet);
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+  size_t consumed = 0;
+
+  while (len - consumed >= 16) {
+    __m128i in = _mm_loadu_si128((const __m128i *)(src + consumed));
+
+    __m128i hi = _mm_shuffle_epi8(
+        lut, _mm_and_si128(_mm_srli_epi16(in, 4), nibble));
+    __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(in, nibble));
+
+    _mm_storeu_si128((__m128i *)dest, _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128((__m128i *)(dest + 16), _mm_unpackhi_epi8(hi, lo));
+
+    consumed += 16;
+    dest += 32;
+  }
+
+  return consumed;
+}
+
+__attribute__((target("avx2"))) static size_t hex_encode_avx2(
+    const unsigned char *src, size_t len, char *dest) {
+  const __m256i lut = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128((const __m128i *)hex_alphabet));
+  const __m256i nibble = _mm256_set1_epi8(0x0f);
+  size_t consumed = 0;
+
+  while (len - consumed >= 32) {
+    __m256i in = _mm256_loadu_si256((const __m256i *)(src + consumed));
+
+    __m256i hi = _mm256_shuffle_epi8(
+        lut, _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble));
+    __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(in, nibble));
+
+    // The unpacks interleave within each lane, so put the lanes back in order
+    __m256i first = _mm256_unpacklo_epi8(hi, lo);
+    __m256i second = _mm256_unpackhi_epi8(hi, lo);
+    _mm256_storeu_si256((__m256i *)dest,
+                        _mm256_permute2x128_si256(first, second, 0x20));
+    _mm256_storeu_si256((__m256i *)(dest + 32),
+                        _mm256_permute2x128_si256(first, second, 0x31));
+
+    consumed += 32;
+    dest += 64;
+  }
+
+  return consumed;
+}
+
+__attribute__((target("ssse3"))) static size_t hex_decode_ssse3(
+    const char *src, size_t len, unsigned char *dest) {
+  size_t consumed = 0;
+
+  while (len - consumed >= 16) {
+    __m128i in = _mm_loadu_si128((const __m128i *)(src + consumed));
+    __m128i lower = _mm_or_si128(in, _mm_set1_epi8(0x20));
+
+    __m128i is_digit =
+        _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('0' - 1)),
+                      _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), in));
+    __m128i is_alpha =
+        _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                      _mm_cmpgt_epi8(_mm_set1_epi8('f' + 1), lower));
+
+    if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) != 0xffff) {
+      break;
+    }
+
+    __m128i values = _mm_or_si128(
+        _mm_and_si128(is_digit, _mm_sub_epi8(in, _mm_set1_epi8('0'))),
+        _mm_and_si128(is_alpha,
+                      _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+
+    // high nibble * 16 + low nibble for each pair
+    __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi16(0x0110));
+    _mm_storel_epi64((__m128i *)dest, _mm_packus_epi16(pairs, pairs));
+
+    consumed += 16;
+    dest += 8;
+  }
+
+  return consumed;
+}
+
+__attribute__((target("avx2"))) static size_t hex_decode_avx2(
+    const char *src, size_t len, unsigned char *dest) {
+  size_t consumed = 0;
+
+  while (len - consumed >= 32) {
+    __m256i in = _mm256_loadu_si256((const __m256i *)(src + consumed));
+    __m256i lower = _mm256_or_si256(in, _mm256_set1_epi8(0x20));
+
+    __m256i is_digit =
+        _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('0' - 1)),
+                         _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), in));
+    __m256i is_alpha =
+        _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                         _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower));
+
+    if ((uint32_t)_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_alpha)) !=
+        0xffffffff) {
+      break;
+    }
+
+    __m256i values = _mm256_or_si256(
+        _mm256_and_si256(is_digit, _mm256_sub_epi8(in, _mm256_set1_epi8('0'))),
+        _mm256_and_si256(is_alpha,
+                         _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10))));
+
+    __m256i pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi16(0x0110));
+    __m256i packed = _mm256_permute4x64_epi64(
+        _mm256_packus_epi16(pairs, pairs), _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128((__m128i *)dest, _mm256_castsi256_si128(packed));
+
+    consumed += 32;
+    dest += 16;
+  }
+
+  return consumed;
+}
+
+#endif
+
+static encode_kernel *base64_encode_kernel(void) {
+#ifdef ENCODING_X86
+  if (__builtin_cpu_supports("avx2")) {
+    return base64_encode_avx2;
+  }
+  if (__builtin_cpu_supports("ssse3")) {
+    return base64_encode_ssse3;
+  }
+#endif
+  return NULL;
+}
+
+static decode_kernel *base64_decode_kernel(void) {
+#ifdef ENCODING_X86
+  if (__builtin_cpu_supports("avx2")) {
+    return base64_decode_avx2;
+  }
+  if (__builtin_cpu_supports("ssse3")) {
+    return base64_decode_ssse3;
+  }
+#endif
+  return NULL;
+}
+
+static encode_kernel *hex_encode_kernel(void) {
+#ifdef ENCODING_X86
+  if (__builtin_cpu_supports("avx2")) {
+    return hex_encode_avx2;
+  }
+  if (__builtin_cpu_supports("ssse3")) {
+    return hex_encode_ssse3;
+  }
+#endif
+  return NULL;
+}
+
+static decode_kernel *hex_decode_kernel(void) {
+#ifdef ENCODING_X86
+  if (__builtin_cpu_supports("avx2")) {
+    return hex_decode_avx2;
+  }
+  if (__builtin_cpu_supports("ssse3")) {
+    return hex_decode_ssse3;
+  }
+#endif
+  return NULL;
+}
+
+// Returns a pointer to the buffer's spare capacity, which must hold `n` bytes
+static char *buffer_spare(buffer_t *buf, size_t n) {
+  if (!buffer_reserve(buf, n)) {
+    return NULL;
+  }
+
+  return buffer_state(buf) + buffer_size(buf);
+}
+
+// Records `n` bytes written into the buffer's spare capacity
+static void buffer_advance(buffer_t *buf, size_t n) {
+  __buffer_t *unwrapped = (__buffer_t *)buf;
+
+  unwrapped->len += n;
+  unwrapped->state[unwrapped->len] = '\0';
+}
+
+// Restores the terminator a failed decode may have overwritten, leaving the
+// buffer as it was
+static bool buffer_discard_spare(buffer_t *buf) {
+  buffer_state(buf)[buffer_size(buf)] = '\0';
+  return false;
+}
+
+bool buffer_append_base64(buffer_t *buf, const char *data, size_t len) {
+  if (!data && len > 0) {
+    return false;
+  }
+
+  if (len / 3 >= SIZE_MAX / 4) {
+    return false;
+  }
+
+  size_t out_len = (len + 2) / 3 * 4;
+
+  char *dest = buffer_spare(buf, out_len);
+  if (!dest) {
+    return false;
+  }
+
+  const unsigned char *src = (const unsigned char *)data;
+  size_t i = 0;
+  char *out = dest;
+
+  encode_kernel *kernel = base64_encode_kernel();
+  if (kernel) {
+    i = kernel(src, len, out);
+    out += i / 3 * 4;
+  }
+
+  for (; len - i >= 3; i += 3) {
+    uint32_t triple = (uint32_t)src[i] << 16 | (uint32_t)src[i + 1] << 8 |
+                      (uint32_t)src[i + 2];
+    *out++ = base64_alphabet[(triple >> 18) & 0x3f];
+    *out++ = base64_alphabet[(triple >> 12) & 0x3f];
+    *out++ = base64_alphabet[(triple >> 6) & 0x3f];
+    *out++ = base64_alphabet[triple & 0x3f];
+  }
+
+  if (len - i > 0) {
+    uint32_t triple = (uint32_t)src[i] << 16;
+    if (len - i == 2) {
+      triple |= (uint32_t)src[i + 1] << 8;
+    }
+
+    *out++ = base64_alphabet[(triple >> 18) & 0x3f];
+    *out++ = base64_alphabet[(triple >> 12) & 0x3f];
+    *out++ = len - i == 2 ? base64_alphabet[(triple >> 6) & 0x3f] : '=';
+    *out++ = '=';
+  }
+
+  buffer_advance(buf, out - dest);
+
+  return true;
+}
+
+bool buffer_append_base64_decoded(buffer_t *buf, const char *s, size_t len) {
+  if (!s && len > 0) {
+    return false;
+  }
+
+  // Padding is optional, but if present must complete the final quad
+  if (len % 4 == 0 && len > 0 && s[len - 1] == '=') {
+    len -= s[len - 2] == '=' ? 2 : 1;
+  }
+
+  if (len % 4 == 1) {
+    return false;
+  }
+
+  size_t out_len = len / 4 * 3 + (len % 4 ? len % 4 - 1 : 0);
+  unsigned char *dest =
+      (unsigned char *)buffer_spare(buf, out_len + ENCODING_STORE_SLACK);
+  if (!dest) {
+    return false;
+  }
+
+  unsigned char *out = dest;
+  size_t i = 0;
+
+  decode_kernel *kernel = base64_decode_kernel();
+  if (kernel) {
+    i = kernel(s, len, out);
+    out += i / 4 * 3;
+  }
+
+  for (; len - i >= 4; i += 4) {
+    int a = base64_values[(unsigned char)s[i]];
+    int b = base64_values[(unsigned char)s[i + 1]];
+    int c = base64_values[(unsigned char)s[i + 2]];
+    int d = base64_values[(unsigned char)s[i + 3]];
+    if ((a | b | c | d) < 0) {
+      return buffer_discard_spare(buf);
+    }
+
+    uint32_t triple = (uint32_t)a << 18 | (uint32_t)b << 12 |
+                      (uint32_t)c << 6 | (uint32_t)d;
+    *out++ = (unsigned char)(triple >> 16);
+    *out++ = (unsigned char)(triple >> 8);
+    *out++ = (unsigned char)triple;
+  }
+
+  if (len - i > 0) {
+    int a = base64_values[(unsigned char)s[i]];
+    int b = base64_values[(unsigned char)s[i + 1]];
+    int c = len - i == 3 ? base64_values[(unsigned char)s[i + 2]] : 0;
+    if ((a | b | c) < 0) {
+      return buffer_discard_spare(buf);
+    }
+
+    uint32_t triple = (uint32_t)a << 18 | (uint32_t)b << 12 | (uint32_t)c << 6;
+    *out++ = (unsigned char)(triple >> 16);
+    if (len - i == 3) {
+      *out++ = (unsigned char)(triple >> 8);
+    }
+  }
+
+  buffer_advance(buf, out - dest);
+
+  return true;
+}
+
+bool buffer_append_hex(buffer_t *buf, const char *data, size_t len) {
+  if (!data && len > 0) {
+    return false;
+  }
+
+  if (len * 2 < len) {
+    return false;
+  }
+
+  char *dest = buffer_spare(buf, len * 2);
+  if (!dest) {
+    return false;
+  }
+
+  const unsigned char *src = (const unsigned char *)data;
+  size_t i = 0;
+
+  encode_kernel *kernel = hex_encode_kernel();
+  if (kernel) {
+    i = kernel(src, len, dest);
+  }
+
+  for (; i < len; i++) {
+    dest[i * 2] = hex_alphabet[src[i] >> 4];
+    dest[i * 2 + 1] = hex_alphabet[src[i] & 0x0f];
+  }
+
+  buffer_advance(buf, len * 2);
+
+  return true;
+}
+
+bool buffer_append_hex_decoded(buffer_t *buf, const char *s, size_t len) {
+  if ((!s && len > 0) || len % 2 != 0) {
+    return false;
+  }
+
+  unsigned char *dest = (unsigned char *)buffer_spare(buf, len / 2);
+  if (!dest) {
+    return false;
+  }
+
+  size_t i = 0;
+
+  decode_kernel *kernel = hex_decode_kernel();
+  if (kernel) {
+    i = kernel(s, len, dest);
+  }
+
+  for (; i < len; i += 2) {
+    int hi = hex_value(s[i]);
+    int lo = hex_value(s[i + 1]);
+    if ((hi | lo) < 0) {
+      return buffer_discard_spare(buf);
+    }
+
+    dest[i / 2] = (unsigned char)(hi << 4 | lo);
+  }
+
+  buffer_advance(buf, len / 2);
+
+  return true;
+}
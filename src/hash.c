@@ -0,0 +1,262 @@
+#include <pthread.h>
+#include <string.h>
+
+#include "libutil.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HASH_X86 1
+#include <immintrin.h>
+#endif
+
+// Castagnoli polynomial, bit-reflected
+#define CRC32C_POLY 0x82f63b78
+
+// Bytes consumed per round of the bulk hash loop
+#define HASH_BLOCK_SZ 48
+
+static const uint64_t hash_secret[4] = {
+    0x2d358dccaa6c78a5ULL,
+    0x8bb84b93962eacc9ULL,
+    0x4b33a62ed433d4a3ULL,
+    0x4d5a2da51de1aa47ULL,
+};
+
+static uint32_t crc32c_table[8][256];
+static pthread_once_t crc32c_table_once = PTHREAD_ONCE_INIT;
+
+static uint64_t read_u64(const unsigned char *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap64(v);
+#endif
+  return v;
+}
+
+static uint64_t read_u32(const unsigned char *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap32(v);
+#endif
+  return v;
+}
+
+static void crc32c_table_build(void) {
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int k = 0; k < 8; k++) {
+      crc = crc & 1 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+    }
+    crc32c_table[0][i] = crc;
+  }
+
+  // Each further table advances a byte's contribution by another 8 bits
+  for (int t = 1; t < 8; t++) {
+    for (int i = 0; i < 256; i++) {
+      uint32_t prev = crc32c_table[t - 1][i];
+      crc32c_table[t][i] = (prev >> 8) ^ crc32c_table[0][prev & 0xff];
+    }
+  }
+}
+
+static uint32_t crc32c_sw(uint32_t crc, const unsigned char *p, size_t len) {
+  pthread_once(&crc32c_table_once, crc32c_table_build);
+
+  while (len >= 8) {
+    uint64_t v = read_u64(p) ^ crc;
+    crc = crc32c_table[7][v & 0xff] ^ crc32c_table[6][(v >> 8) & 0xff] ^
+          crc32c_table[5][(v >> 16) & 0xff] ^
+          crc32c_table[4][(v >> 24) & 0xff] ^
+          crc32c_table[3][(v >> 32) & 0xff] ^
+          crc32c_table[2][(v >> 40) & 0xff] ^
+          crc32c_table[1][(v >> 48) & 0xff] ^ crc32c_table[0][v >> 56];
+    p += 8;
+    len -= 8;
+  }
+
+  while (len--) {
+    crc = (crc >> 8) ^ crc32c_table[0][(crc ^ *p++) & 0xff];
+  }
+
+  return crc;
+}
+
+#ifdef HASH_X86
+__attribute__((target("sse4.2"))) static uint32_t crc32c_hw(
+    uint32_t crc, const unsigned char *p, size_t len) {
+#ifdef __x86_64__
+  uint64_t crc64 = crc;
+  while (len >= 8) {
+    crc64 = _mm_crc32_u64(crc64, read_u64(p));
+    p += 8;
+    len -= 8;
+  }
+  crc = (uint32_t)crc64;
+#endif
+
+  while (len >= 4) {
+    crc = _mm_crc32_u32(crc, (uint32_t)read_u32(p));
+    p += 4;
+    len -= 4;
+  }
+
+  while (len--) {
+    crc = _mm_crc32_u8(crc, *p++);
+  }
+
+  return crc;
+}
+#endif
+
+uint32_t u_crc32c_update(uint32_t crc, const char *data, size_t len) {
+  const unsigned char *p = (const unsigned char *)data;
+
+  crc = ~crc;
+#ifdef HASH_X86
+  if (__builtin_cpu_supports("sse4.2")) {
+    return ~crc32c_hw(crc, p, len);
+  }
+#endif
+  return ~crc32c_sw(crc, p, len);
+}
+
+uint32_t u_crc32c(const char *data, size_t len) {
+  return u_crc32c_update(0, data, len);
+}
+
+// Multiplies two 64-bit values, leaving the low half of the 128-bit product
+// in `a` and the high half in `b`
+static void hash_mum(uint64_t *a, uint64_t *b) {
+#ifdef __SIZEOF_INT128__
+  __extension__ typedef unsigned __int128 uint128;
+  uint128 r = (uint128)*a * *b;
+  *a = (uint64_t)r;
+  *b = (uint64_t)(r >> 64);
+#else
+  uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32), c = t < rl;
+  uint64_t lo = t + (rm1 << 32);
+  c += lo < t;
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static uint64_t hash_mix(uint64_t a, uint64_t b) {
+  hash_mum(&a, &b);
+  return a ^ b;
+}
+
+static uint64_t hash_seed(uint64_t seed) {
+  return seed ^ hash_mix(seed ^ hash_secret[0], hash_secret[1]);
+}
+
+static void hash_block(const unsigned char *p, uint64_t *seed, uint64_t *see1,
+                       uint64_t *see2) {
+  *seed = hash_mix(read_u64(p) ^ hash_secret[1], read_u64(p + 8) ^ *seed);
+  *see1 = hash_mix(read_u64(p + 16) ^ hash_secret[2], read_u64(p + 24) ^ *see1);
+  *see2 = hash_mix(read_u64(p + 32) ^ hash_secret[3], read_u64(p + 40) ^ *see2);
+}
+
+// Hashes the final (at most 48) bytes at `p`. When `total` exceeds 16, the 16
+// bytes before `p` must be readable and hold the preceding input
+static uint64_t hash_finish(const unsigned char *p, size_t i, size_t total,
+                            uint64_t seed) {
+  uint64_t a, b;
+
+  if (total <= 16) {
+    if (i >= 4) {
+      a = read_u32(p) << 32 | read_u32(p + ((i >> 3) << 2));
+      b = read_u32(p + i - 4) << 32 | read_u32(p + i - 4 - ((i >> 3) << 2));
+    } else if (i > 0) {
+      a = (uint64_t)p[0] << 16 | (uint64_t)p[i >> 1] << 8 | p[i - 1];
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    while (i > 16) {
+      seed = hash_mix(read_u64(p) ^ hash_secret[1], read_u64(p + 8) ^ seed);
+      p += 16;
+      i -= 16;
+    }
+
+    a = read_u64(p + i - 16);
+    b = read_u64(p + i - 8);
+  }
+
+  a ^= hash_secret[1];
+  b ^= seed;
+  hash_mum(&a, &b);
+
+  return hash_mix(a ^ hash_secret[0] ^ total, b ^ hash_secret[1]);
+}
+
+uint64_t u_hash64(const char *data, size_t len, uint64_t seed) {
+  const unsigned char *p = (const unsigned char *)data;
+  size_t i = len;
+
+  seed = hash_seed(seed);
+
+  if (i > HASH_BLOCK_SZ) {
+    uint64_t see1 = seed, see2 = seed;
+    do {
+      hash_block(p, &seed, &see1, &see2);
+      p += HASH_BLOCK_SZ;
+      i -= HASH_BLOCK_SZ;
+    } while (i > HASH_BLOCK_SZ);
+
+    seed ^= see1 ^ see2;
+  }
+
+  return hash_finish(p, i, len, seed);
+}
+
+uint64_t u_hash_str(const char *s) { return u_hash64(s, strlen(s), 0); }
+
+uint64_t u_hash_buffer(buffer_t *buf) {
+  return u_hash64(buffer_state(buf), buffer_size(buf), 0);
+}
+
+void u_hash_init(u_hash_state_t *state, uint64_t seed) {
+  state->seed = state->see1 = state->see2 = hash_seed(seed);
+  state->total = 0;
+  state->pending = 0;
+}
+
+void u_hash_update(u_hash_state_t *state, const char *data, size_t len) {
+  // Pending input lives after a 16-byte window holding whatever preceded it,
+  // which the final step may need to reread
+  unsigned char *pending = state->buf + 16;
+
+  state->total += len;
+
+  while (len > 0) {
+    size_t room = sizeof(state->buf) - 16 - state->pending;
+    size_t n = len < room ? len : room;
+
+    memcpy(pending + state->pending, data, n);
+    state->pending += n;
+    data += n;
+    len -= n;
+
+    // A block is only consumed once more input is known to follow it, as the
+    // last one must go through hash_finish instead
+    if (state->pending > HASH_BLOCK_SZ) {
+      hash_block(pending, &state->seed, &state->see1, &state->see2);
+      state->pending -= HASH_BLOCK_SZ;
+      memmove(state->buf, pending + HASH_BLOCK_SZ - 16, 16 + state->pending);
+    }
+  }
+}
+
+uint64_t u_hash_digest(u_hash_state_t *state) {
+  uint64_t seed = state->seed;
+  if (state->total > HASH_BLOCK_SZ) {
+    seed ^= state->see1 ^ state->see2;
+  }
+
+  return hash_finish(state->buf + 16, state->pending, state->total, seed);
+}
@@ -0,0 +1,383 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libutil.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Slots are probed a group at a time, by comparing the group's 16 control
+// bytes against the 7 bits of the hash kept in each full slot's control byte.
+// Only candidates that survive that filter have their keys compared
+#define HASHMAP_GROUP_SZ 16
+#define HASHMAP_MIN_SLOTS 16
+
+// Full slots hold the low 7 bits of their key's hash, which leaves the top bit
+// to mark the slots a probe can claim
+#define HASHMAP_EMPTY ((int8_t)-128)
+#define HASHMAP_DELETED ((int8_t)-2)
+
+typedef struct {
+  const void *key;
+  void *value;
+} hashmap_slot;
+
+// Tables are doubled only while they're smaller than this, which keeps the
+// size of their slot arrays from overflowing a size_t
+#define HASHMAP_MAX_SLOTS (SIZE_MAX / 2 / sizeof(hashmap_slot))
+
+struct __hashmap {
+  hashmap_key_mode mode;
+  free_fn *free_value;
+  int8_t *ctrl;
+  hashmap_slot *slots;
+  size_t n_slots;
+  size_t size;
+  // How many more slots may be filled before the table must be rehashed.
+  // Tombstones use this up too, since they lengthen probes just as keys do
+  size_t growth_left;
+};
+
+// Bit i of a group mask is set when slot i of the group matches
+typedef uint32_t hashmap_mask;
+
+#ifdef __SSE2__
+
+static hashmap_mask group_match(const int8_t *ctrl, int8_t h2) {
+  __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(h2)));
+}
+
+static hashmap_mask group_match_empty(const int8_t *ctrl) {
+  return group_match(ctrl, HASHMAP_EMPTY);
+}
+
+// Empty and deleted slots are the only ones with the top bit set
+static hashmap_mask group_match_free(const int8_t *ctrl) {
+  return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+}
+
+#else
+
+static hashmap_mask group_match(const int8_t *ctrl, int8_t h2) {
+  hashmap_mask mask = 0;
+  for (size_t i = 0; i < HASHMAP_GROUP_SZ; i++) {
+    mask |= (hashmap_mask)(ctrl[i] == h2) << i;
+  }
+
+  return mask;
+}
+
+static hashmap_mask group_match_empty(const int8_t *ctrl) {
+  return group_match(ctrl, HASHMAP_EMPTY);
+}
+
+static hashmap_mask group_match_free(const int8_t *ctrl) {
+  hashmap_mask mask = 0;
+  for (size_t i = 0; i < HASHMAP_GROUP_SZ; i++) {
+    mask |= (hashmap_mask)(ctrl[i] < 0) << i;
+  }
+
+  return mask;
+}
+
+#endif
+
+// Integer and pointer keys are often sequential or aligned, so their bits are
+// mixed (with MurmurHash3's finalizer) before the low 7 are taken
+static uint64_t hashmap_mix(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+
+  return x;
+}
+
+static uint64_t hashmap_hash(hashmap_t *map, const void *key) {
+  if (map->mode == HASHMAP_KEY_STR) {
+    return u_hash64(key, strlen(key), 0);
+  }
+
+  return hashmap_mix((uintptr_t)key);
+}
+
+static bool hashmap_key_eq(hashmap_t *map, const void *a, const void *b) {
+  return a == b || (map->mode == HASHMAP_KEY_STR && !strcmp(a, b));
+}
+
+static size_t hashmap_capacity(size_t n_slots) {
+  // Keep the load factor at or below 7/8
+  return n_slots - n_slots / 8;
+}
+
+// Returns the index of the slot holding the key, or -1 if there is none
+static ssize_t hashmap_find(hashmap_t *map, const void *key, uint64_t hash) {
+  int8_t h2 = hash & 0x7f;
+  size_t mask = map->n_slots / HASHMAP_GROUP_SZ - 1;
+  size_t group = (hash >> 7) & mask;
+
+  // Groups are probed in triangular order, which visits each of them once
+  // since there's a power of 2 of them
+  for (size_t step = 1; step <= mask + 1; step++) {
+    const int8_t *ctrl = map->ctrl + group * HASHMAP_GROUP_SZ;
+
+    for (hashmap_mask m = group_match(ctrl, h2); m; m &= m - 1) {
+      size_t i = group * HASHMAP_GROUP_SZ + __builtin_ctz(m);
+      if (hashmap_key_eq(map, map->slots[i].key, key)) {
+        return i;
+      }
+    }
+
+    // A key is never placed beyond a group with an empty slot
+    if (group_match_empty(ctrl)) {
+      return -1;
+    }
+
+    group = (group + step) & mask;
+  }
+
+  return -1;
+}
+
+// Returns the index of the first empty or deleted slot on the hash's probe
+// sequence. The table must have one
+static size_t hashmap_find_free(hashmap_t *map, uint64_t hash) {
+  size_t mask = map->n_slots / HASHMAP_GROUP_SZ - 1;
+  size_t group = (hash >> 7) & mask;
+
+  for (size_t step = 1; step <= mask + 1; step++) {
+    hashmap_mask m = group_match_free(map->ctrl + group * HASHMAP_GROUP_SZ);
+    if (m) {
+      return group * HASHMAP_GROUP_SZ + __builtin_ctz(m);
+    }
+
+    group = (group + step) & mask;
+  }
+
+  return 0;
+}
+
+// Moves every key into a fresh table of `n_slots`, dropping tombstones
+static bool hashmap_rehash(hashmap_t *map, size_t n_slots) {
+  if (n_slots > SIZE_MAX / sizeof(hashmap_slot)) {
+    return false;
+  }
+
+  int8_t *ctrl = malloc(n_slots);
+  hashmap_slot *slots = malloc(n_slots * sizeof(hashmap_slot));
+  if (!ctrl || !slots) {
+    free(ctrl);
+    free(slots);
+    return false;
+  }
+  memset(ctrl, HASHMAP_EMPTY, n_slots);
+
+  hashmap_t old = *map;
+  map->ctrl = ctrl;
+  map->slots = slots;
+  map->n_slots = n_slots;
+  map->growth_left = hashmap_capacity(n_slots) - map->size;
+
+  for (size_t i = 0; i < old.n_slots; i++) {
+    if (old.ctrl[i] >= 0) {
+      uint64_t hash = hashmap_hash(map, old.slots[i].key);
+      size_t j = hashmap_find_free(map, hash);
+      map->ctrl[j] = hash & 0x7f;
+      map->slots[j] = old.slots[i];
+    }
+  }
+
+  free(old.ctrl);
+  free(old.slots);
+
+  return true;
+}
+
+hashmap_t *hashmap_init(hashmap_key_mode mode, free_fn *free_value) {
+  hashmap_t *map = malloc(sizeof(hashmap_t));
+  if (!map) {
+    return NULL;
+  }
+
+  map->mode = mode;
+  map->free_value = free_value;
+  map->ctrl = NULL;
+  map->slots = NULL;
+  map->n_slots = 0;
+  map->size = 0;
+  map->growth_left = 0;
+
+  return map;
+}
+
+bool hashmap_reserve(hashmap_t *map, size_t n) {
+  size_t n_slots = map->n_slots ? map->n_slots : HASHMAP_MIN_SLOTS;
+  while (hashmap_capacity(n_slots) < n) {
+    if (n_slots >= HASHMAP_MAX_SLOTS) {
+      return false;
+    }
+    n_slots *= 2;
+  }
+
+  if (n_slots == map->n_slots) {
+    return true;
+  }
+
+  return hashmap_rehash(map, n_slots);
+}
+
+bool hashmap_set(hashmap_t *map, const void *key, void *value) {
+  if (map->mode == HASHMAP_KEY_STR && !key) {
+    return false;
+  }
+
+  uint64_t hash = hashmap_hash(map, key);
+
+  if (map->n_slots > 0) {
+    ssize_t i = hashmap_find(map, key, hash);
+    if (i >= 0) {
+      void *old = map->slots[i].value;
+      map->slots[i].value = value;
+      if (map->free_value && old != value) {
+        map->free_value(old);
+      }
+
+      return true;
+    }
+  }
+
+  size_t i = map->n_slots > 0 ? hashmap_find_free(map, hash) : 0;
+
+  // Reusing a tombstone costs nothing, but filling an empty slot may need a
+  // rehash first: a bigger table if it's mostly keys, otherwise one the same
+  // size to clear out the tombstones
+  if (map->n_slots == 0 ||
+      (map->growth_left == 0 && map->ctrl[i] == HASHMAP_EMPTY)) {
+    size_t n_slots = map->n_slots ? map->n_slots : HASHMAP_MIN_SLOTS;
+    if (map->size + 1 > hashmap_capacity(n_slots) / 2) {
+      if (n_slots >= HASHMAP_MAX_SLOTS) {
+        return false;
+      }
+      n_slots *= 2;
+    }
+
+    if (!hashmap_rehash(map, n_slots)) {
+      return false;
+    }
+    i = hashmap_find_free(map, hash);
+  }
+
+  const void *owned = key;
+  if (map->mode == HASHMAP_KEY_STR && !(owned = s_copy(key))) {
+    return false;
+  }
+
+  if (map->ctrl[i] == HASHMAP_EMPTY) {
+    map->growth_left--;
+  }
+  map->ctrl[i] = hash & 0x7f;
+  map->slots[i].key = owned;
+  map->slots[i].value = value;
+  map->size++;
+
+  return true;
+}
+
+void *hashmap_get(hashmap_t *map, const void *key) {
+  if (map->size == 0 || (map->mode == HASHMAP_KEY_STR && !key)) {
+    return NULL;
+  }
+
+  ssize_t i = hashmap_find(map, key, hashmap_hash(map, key));
+
+  return i >= 0 ? map->slots[i].value : NULL;
+}
+
+bool hashmap_has(hashmap_t *map, const void *key) {
+  if (map->size == 0 || (map->mode == HASHMAP_KEY_STR && !key)) {
+    return false;
+  }
+
+  return hashmap_find(map, key, hashmap_hash(map, key)) >= 0;
+}
+
+bool hashmap_delete(hashmap_t *map, const void *key) {
+  if (map->size == 0 || (map->mode == HASHMAP_KEY_STR && !key)) {
+    return false;
+  }
+
+  ssize_t i = hashmap_find(map, key, hashmap_hash(map, key));
+  if (i < 0) {
+    return false;
+  }
+
+  // Probes stop at the first group with an empty slot, so if this group has
+  // one, no probe can have passed through it to reach a key further on, and
+  // the slot can simply be emptied. Otherwise it must become a tombstone
+  const int8_t *group = map->ctrl + i / HASHMAP_GROUP_SZ * HASHMAP_GROUP_SZ;
+  if (group_match_empty(group)) {
+    map->ctrl[i] = HASHMAP_EMPTY;
+    map->growth_left++;
+  } else {
+    map->ctrl[i] = HASHMAP_DELETED;
+  }
+
+  if (map->mode == HASHMAP_KEY_STR) {
+    free((void *)map->slots[i].key);
+  }
+  if (map->free_value) {
+    map->free_value(map->slots[i].value);
+  }
+  map->size--;
+
+  return true;
+}
+
+size_t hashmap_size(hashmap_t *map) { return map->size; }
+
+bool hashmap_next(hashmap_t *map, size_t *iter, const void **key,
+                  void **value) {
+  for (size_t i = *iter; i < map->n_slots; i++) {
+    if (map->ctrl[i] >= 0) {
+      if (key) {
+        *key = map->slots[i].key;
+      }
+      if (value) {
+        *value = map->slots[i].value;
+      }
+
+      *iter = i + 1;
+      return true;
+    }
+  }
+
+  *iter = map->n_slots;
+  return false;
+}
+
+void hashmap_free(hashmap_t *map) {
+  if (!map) {
+    return;
+  }
+
+  for (size_t i = 0; i < map->n_slots; i++) {
+    if (map->ctrl[i] < 0) {
+      continue;
+    }
+
+    if (map->mode == HASHMAP_KEY_STR) {
+      free((void *)map->slots[i].key);
+    }
+    if (map->free_value) {
+      map->free_value(map->slots[i].value);
+    }
+  }
+
+  free(map->ctrl);
+  free(map->slots);
+  free(map);
+}
@@ -0,0 +1,277 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libutil.h"
+
+#define INTERNER_INITIAL_SLOTS 64
+
+// Strings are copied into chunks that are never moved or freed until the
+// interner is, which is what keeps the canonical pointers stable
+typedef struct __intern_chunk {
+  struct __intern_chunk *next;
+  size_t used;
+  size_t cap;
+  char data[];
+} intern_chunk;
+
+// A slot's string pointer is stored last, with release semantics, so a reader
+// that sees it can trust the hash and length beside it
+typedef struct {
+  uint64_t hash;
+  size_t len;
+  _Atomic(const char *) str;
+} intern_slot;
+
+typedef struct __intern_table {
+  struct __intern_table *retired;
+  size_t n_slots;
+  intern_slot slots[];
+} intern_table;
+
+// Each shard owns a slice of the hash space, so writers interning unrelated
+// strings rarely contend. Readers take no lock at all: slots are only ever
+// filled in, never changed, and a table that's been outgrown is kept around
+// until the interner is freed, since a reader may still be probing it
+typedef struct {
+  pthread_mutex_t lock;
+  _Atomic(intern_table *) table;
+  size_t size;
+  intern_chunk *chunks;
+} intern_shard;
+
+struct __interner {
+  intern_shard shards[LIB_UTIL_INTERNER_SHARDS];
+};
+
+static intern_table *intern_table_init(size_t n_slots) {
+  intern_table *table =
+      calloc(1, sizeof(intern_table) + n_slots * sizeof(intern_slot));
+  if (table) {
+    table->n_slots = n_slots;
+  }
+
+  return table;
+}
+
+interner_t *interner_init(void) {
+  interner_t *in = calloc(1, sizeof(interner_t));
+  if (!in) {
+    return NULL;
+  }
+
+  for (size_t i = 0; i < LIB_UTIL_INTERNER_SHARDS; i++) {
+    intern_shard *shard = &in->shards[i];
+    intern_table *table = intern_table_init(INTERNER_INITIAL_SLOTS);
+    if (!table) {
+      while (i-- > 0) {
+        free(atomic_load(&in->shards[i].table));
+        pthread_mutex_destroy(&in->shards[i].lock);
+      }
+      free(in);
+      return NULL;
+    }
+
+    atomic_init(&shard->table, table);
+    pthread_mutex_init(&shard->lock, NULL);
+  }
+
+  return in;
+}
+
+static intern_shard *intern_shard_for(interner_t *in, uint64_t hash) {
+  // The low bits pick the slot within the table, so shard on the high ones
+  return &in->shards[(hash >> 56) % LIB_UTIL_INTERNER_SHARDS];
+}
+
+// Returns the slot holding the string, or the empty slot where it would go
+static intern_slot *intern_probe(intern_table *table, uint64_t hash,
+                                 const char *s, size_t len) {
+  size_t mask = table->n_slots - 1;
+
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    intern_slot *slot = &table->slots[i];
+    const char *str = atomic_load_explicit(&slot->str, memory_order_acquire);
+    if (!str ||
+        (slot->hash == hash && slot->len == len && !memcmp(str, s, len))) {
+      return slot;
+    }
+  }
+}
+
+// Publishes a table twice the size of the shard's current one. Must be called
+// with the shard's lock held
+static bool intern_grow(intern_shard *shard) {
+  intern_table *old = atomic_load_explicit(&shard->table, memory_order_relaxed);
+  intern_table *table = intern_table_init(old->n_slots * 2);
+  if (!table) {
+    return false;
+  }
+
+  size_t mask = table->n_slots - 1;
+  for (size_t i = 0; i < old->n_slots; i++) {
+    intern_slot *slot = &old->slots[i];
+    const char *str = atomic_load_explicit(&slot->str, memory_order_relaxed);
+    if (!str) {
+      continue;
+    }
+
+    size_t j = slot->hash & mask;
+    while (atomic_load_explicit(&table->slots[j].str, memory_order_relaxed)) {
+      j = (j + 1) & mask;
+    }
+
+    table->slots[j].hash = slot->hash;
+    table->slots[j].len = slot->len;
+    atomic_store_explicit(&table->slots[j].str, str, memory_order_relaxed);
+  }
+
+  table->retired = old;
+  atomic_store_explicit(&shard->table, table, memory_order_release);
+
+  return true;
+}
+
+// Copies the string into the shard's arena, NUL-terminated
+static const char *intern_copy(intern_shard *shard, const char *s,
+                               size_t len) {
+  intern_chunk *chunk = shard->chunks;
+
+  if (!chunk || chunk->cap - chunk->used < len + 1) {
+    // Strings too big for a chunk get one of their own
+    size_t cap = LIB_UTIL_INTERNER_CHUNK_SZ;
+    if (cap < len + 1) {
+      cap = len + 1;
+    }
+
+    chunk = malloc(sizeof(intern_chunk) + cap);
+    if (!chunk) {
+      return NULL;
+    }
+
+    chunk->used = 0;
+    chunk->cap = cap;
+    chunk->next = shard->chunks;
+    shard->chunks = chunk;
+  }
+
+  char *copy = chunk->data + chunk->used;
+  if (len > 0) {
+    memcpy(copy, s, len);
+  }
+  copy[len] = '\0';
+  chunk->used += len + 1;
+
+  return copy;
+}
+
+const char *interner_lookup_n(interner_t *in, const char *s, size_t len) {
+  if (!s) {
+    return NULL;
+  }
+
+  uint64_t hash = u_hash64(s, len, 0);
+  intern_shard *shard = intern_shard_for(in, hash);
+  intern_table *table =
+      atomic_load_explicit(&shard->table, memory_order_acquire);
+
+  return atomic_load_explicit(&intern_probe(table, hash, s, len)->str,
+                              memory_order_acquire);
+}
+
+const char *interner_intern_n(interner_t *in, const char *s, size_t len) {
+  if (!s) {
+    return NULL;
+  }
+
+  uint64_t hash = u_hash64(s, len, 0);
+  intern_shard *shard = intern_shard_for(in, hash);
+
+  // Strings that are already interned, which is nearly all of them once a
+  // vocabulary has been seen, never take the lock
+  intern_table *table =
+      atomic_load_explicit(&shard->table, memory_order_acquire);
+  const char *ret = atomic_load_explicit(
+      &intern_probe(table, hash, s, len)->str, memory_order_acquire);
+  if (ret) {
+    return ret;
+  }
+
+  pthread_mutex_lock(&shard->lock);
+
+  // Another writer may have interned it, or grown the table, in the meantime
+  table = atomic_load_explicit(&shard->table, memory_order_relaxed);
+  intern_slot *slot = intern_probe(table, hash, s, len);
+  ret = atomic_load_explicit(&slot->str, memory_order_relaxed);
+
+  if (!ret) {
+    // Keep the load factor at or below 3/4
+    if ((shard->size + 1) * 4 > table->n_slots * 3) {
+      if (!intern_grow(shard)) {
+        pthread_mutex_unlock(&shard->lock);
+        return NULL;
+      }
+
+      table = atomic_load_explicit(&shard->table, memory_order_relaxed);
+      slot = intern_probe(table, hash, s, len);
+    }
+
+    ret = intern_copy(shard, s, len);
+    if (ret) {
+      slot->hash = hash;
+      slot->len = len;
+      atomic_store_explicit(&slot->str, ret, memory_order_release);
+      shard->size++;
+    }
+  }
+
+  pthread_mutex_unlock(&shard->lock);
+
+  return ret;
+}
+
+const char *interner_intern(interner_t *in, const char *s) {
+  return s ? interner_intern_n(in, s, strlen(s)) : NULL;
+}
+
+size_t interner_size(interner_t *in) {
+  size_t size = 0;
+
+  for (size_t i = 0; i < LIB_UTIL_INTERNER_SHARDS; i++) {
+    pthread_mutex_lock(&in->shards[i].lock);
+    size += in->shards[i].size;
+    pthread_mutex_unlock(&in->shards[i].lock);
+  }
+
+  return size;
+}
+
+void interner_free(interner_t *in) {
+  if (!in) {
+    return;
+  }
+
+  for (size_t i = 0; i < LIB_UTIL_INTERNER_SHARDS; i++) {
+    intern_shard *shard = &in->shards[i];
+    intern_chunk *chunk = shard->chunks;
+
+    while (chunk) {
+      intern_chunk *next = chunk->next;
+      free(chunk);
+      chunk = next;
+    }
+
+    intern_table *table = atomic_load(&shard->table);
+    while (table) {
+      intern_table *retired = table->retired;
+      free(table);
+      table = retired;
+    }
+
+    pthread_mutex_destroy(&shard->lock);
+  }
+
+  free(in);
+}
@@ -1,11 +1,18 @@
 #include <errno.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "libutil.h"
 
+// IOV_MAX is only exposed by limits.h under X/Open; Linux's limit is 1024
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
 io_write_all_result io_write_all(FILE *fd, const char *data,
                                  size_t *n_write_ptr) {
   size_t sz = strlen(data);
@@ -49,6 +56,67 @@ io_write_all_result io_write_all(FILE *fd, const char *data,
   return IO_WRITE_ALL_OK;
 }
 
+io_write_all_result io_writev_all(int fd, struct iovec *iov, int iovcnt,
+                                  size_t *n_write_ptr) {
+  size_t total_written = 0;
+
+  if (fd < 0 || iovcnt < 0 || (iov == NULL && iovcnt > 0)) {
+    return IO_WRITE_ALL_INVALID;
+  }
+
+  while (iovcnt > 0) {
+    // Skip empty vectors so a trailing empty one can't look like a stalled
+    // write
+    if (iov->iov_len == 0) {
+      iov++;
+      iovcnt--;
+      continue;
+    }
+
+    ssize_t n = writev(fd, iov, iovcnt < IOV_MAX ? iovcnt : IOV_MAX);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      if (n_write_ptr) {
+        *n_write_ptr = total_written;
+      }
+      return IO_WRITE_ALL_ERR;
+    }
+
+    if (n == 0) {
+      break;
+    }
+
+    total_written += n;
+
+    // Advance past everything the kernel accepted; a partial write leaves us
+    // pointing into the middle of a vector
+    size_t consumed = n;
+    while (iovcnt > 0 && consumed >= iov->iov_len) {
+      consumed -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+
+    if (consumed > 0) {
+      iov->iov_base = (char *)iov->iov_base + consumed;
+      iov->iov_len -= consumed;
+    }
+  }
+
+  if (n_write_ptr) {
+    *n_write_ptr = total_written;
+  }
+
+  if (iovcnt > 0) {
+    return IO_WRITE_ALL_INCOMPLETE;
+  }
+
+  return IO_WRITE_ALL_OK;
+}
+
 // Adapted from this answer https://stackoverflow.com/a/44894946
 io_read_all_result io_read_all(FILE *fd, char **data_ptr, size_t *n_read_ptr) {
   char *data = NULL;
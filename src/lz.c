@@ -0,0 +1,901 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "libutil.h"
+
+// Constraints from the LZ4 block format: the last 5 bytes of a block are
+// always literals, and the last match must start at least 12 bytes before the
+// end of the block
+#define LZ_MIN_MATCH 4
+#define LZ_LAST_LITERALS 5
+#define LZ_MFLIMIT 12
+#define LZ_MAX_OFFSET 65535
+
+#define LZ_HASH_LOG 12
+// After this many misses in a row (as a power of two), the match finder
+// starts skipping ahead faster through incompressible input
+#define LZ_SKIP_TRIGGER 6
+
+#define LZ_FRAME_MAGIC 0x184d2204
+#define LZ_SKIPPABLE_MAGIC 0x184d2a50
+#define LZ_SKIPPABLE_MASK 0xfffffff0
+#define LZ_FRAME_VERSION 0x40
+#define LZ_FLG_BLOCK_INDEPENDENT 0x20
+#define LZ_FLG_BLOCK_CHECKSUM 0x10
+#define LZ_FLG_CONTENT_SIZE 0x08
+#define LZ_FLG_CONTENT_CHECKSUM 0x04
+#define LZ_FLG_DICT_ID 0x01
+#define LZ_BLOCK_UNCOMPRESSED 0x80000000U
+// Magic, FLG, BD, content size, dictionary ID and header checksum
+#define LZ_FRAME_HEADER_MAX 19
+
+#if LIB_UTIL_LZ_BLOCK_MAX_SZ == 65536
+#define LZ_BLOCK_MAX_ID 4
+#elif LIB_UTIL_LZ_BLOCK_MAX_SZ == 262144
+#define LZ_BLOCK_MAX_ID 5
+#elif LIB_UTIL_LZ_BLOCK_MAX_SZ == 1048576
+#define LZ_BLOCK_MAX_ID 6
+#elif LIB_UTIL_LZ_BLOCK_MAX_SZ == 4194304
+#define LZ_BLOCK_MAX_ID 7
+#else
+#error "LIB_UTIL_LZ_BLOCK_MAX_SZ must be 64KB, 256KB, 1MB or 4MB"
+#endif
+
+#define XXH_PRIME1 2654435761U
+#define XXH_PRIME2 2246822519U
+#define XXH_PRIME3 3266489917U
+#define XXH_PRIME4 668265263U
+#define XXH_PRIME5 374761393U
+
+typedef struct {
+  uint32_t v[4];
+  uint64_t total;
+  unsigned char mem[16];
+  size_t memsize;
+} xxh32_state;
+
+typedef struct {
+  unsigned char flg;
+  size_t block_max;
+  uint64_t content_size;
+} lz_frame_header;
+
+static uint32_t read_le32(const unsigned char *p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+         (uint32_t)p[3] << 24;
+}
+
+static void write_le32(unsigned char *p, uint32_t v) {
+  p[0] = (unsigned char)v;
+  p[1] = (unsigned char)(v >> 8);
+  p[2] = (unsigned char)(v >> 16);
+  p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t read_u32(const unsigned char *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static uint64_t read_u64_le(const unsigned char *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap64(v);
+#endif
+  return v;
+}
+
+static uint32_t rotl32(uint32_t x, int r) { return (x << r) | (x >> (32 - r)); }
+
+static uint32_t xxh32_round(uint32_t acc, uint32_t input) {
+  acc += input * XXH_PRIME2;
+  return rotl32(acc, 13) * XXH_PRIME1;
+}
+
+static void xxh32_init(xxh32_state *state) {
+  state->v[0] = XXH_PRIME1 + XXH_PRIME2;
+  state->v[1] = XXH_PRIME2;
+  state->v[2] = 0;
+  state->v[3] = -XXH_PRIME1;
+  state->total = 0;
+  state->memsize = 0;
+}
+
+static void xxh32_update(xxh32_state *state, const unsigned char *p,
+                         size_t len) {
+  state->total += len;
+
+  if (state->memsize + len < 16) {
+    memcpy(state->mem + state->memsize, p, len);
+    state->memsize += len;
+    return;
+  }
+
+  if (state->memsize > 0) {
+    size_t n = 16 - state->memsize;
+    memcpy(state->mem + state->memsize, p, n);
+    for (int i = 0; i < 4; i++) {
+      state->v[i] = xxh32_round(state->v[i], read_le32(state->mem + i * 4));
+    }
+    p += n;
+    len -= n;
+    state->memsize = 0;
+  }
+
+  for (; len >= 16; p += 16, len -= 16) {
+    for (int i = 0; i < 4; i++) {
+      state->v[i] = xxh32_round(state->v[i], read_le32(p + i * 4));
+    }
+  }
+
+  memcpy(state->mem, p, len);
+  state->memsize = len;
+}
+
+static uint32_t xxh32_digest(xxh32_state *state) {
+  uint32_t h;
+  if (state->total >= 16) {
+    h = rotl32(state->v[0], 1) + rotl32(state->v[1], 7) +
+        rotl32(state->v[2], 12) + rotl32(state->v[3], 18);
+  } else {
+    h = state->v[2] + XXH_PRIME5;
+  }
+
+  h += (uint32_t)state->total;
+
+  const unsigned char *p = state->mem;
+  size_t len = state->memsize;
+  for (; len >= 4; p += 4, len -= 4) {
+    h = rotl32(h + read_le32(p) * XXH_PRIME3, 17) * XXH_PRIME4;
+  }
+  for (; len > 0; p++, len--) {
+    h = rotl32(h + *p * XXH_PRIME5, 11) * XXH_PRIME1;
+  }
+
+  h ^= h >> 15;
+  h *= XXH_PRIME2;
+  h ^= h >> 13;
+  h *= XXH_PRIME3;
+  h ^= h >> 16;
+
+  return h;
+}
+
+static uint32_t xxh32(const unsigned char *p, size_t len) {
+  xxh32_state state;
+  xxh32_init(&state);
+  xxh32_update(&state, p, len);
+  return xxh32_digest(&state);
+}
+
+static uint32_t lz_hash(uint32_t seq) {
+  return (seq * 2654435761U) >> (32 - LZ_HASH_LOG);
+}
+
+static unsigned char *lz_write_length(unsigned char *op, size_t len) {
+  for (; len >= 255; len -= 255) {
+    *op++ = 255;
+  }
+  *op++ = (unsigned char)len;
+
+  return op;
+}
+
+// Writes a sequence's token, literal length and literals. The token's low
+// nibble is left for the match length
+static unsigned char *lz_write_literals(unsigned char *op,
+                                        const unsigned char *literals,
+                                        size_t len) {
+  unsigned char *token = op++;
+  if (len >= 15) {
+    *token = 15 << 4;
+    op = lz_write_length(op, len - 15);
+  } else {
+    *token = (unsigned char)(len << 4);
+  }
+
+  memcpy(op, literals, len);
+
+  return op + len;
+}
+
+// Returns how many bytes at `ip` and `match` agree, stopping at `limit`
+static size_t lz_match_len(const unsigned char *ip, const unsigned char *match,
+                           const unsigned char *limit) {
+  const unsigned char *start = ip;
+
+  while (ip + 8 <= limit) {
+    uint64_t diff = read_u64_le(ip) ^ read_u64_le(match);
+    if (diff) {
+      return ip - start + (__builtin_ctzll(diff) >> 3);
+    }
+    ip += 8;
+    match += 8;
+  }
+
+  while (ip < limit && *ip == *match) {
+    ip++;
+    match++;
+  }
+
+  return ip - start;
+}
+
+size_t lz_compress_bound(size_t len) { return len + len / 255 + 16; }
+
+size_t lz_compress_block(const char *src, size_t len, char *dest) {
+  const unsigned char *base = (const unsigned char *)src;
+  const unsigned char *ip = base;
+  const unsigned char *anchor = base;
+  const unsigned char *iend = base + len;
+  unsigned char *op = (unsigned char *)dest;
+
+  if (len >= LZ_MFLIMIT + 1) {
+    const unsigned char *mflimit = iend - LZ_MFLIMIT;
+    const unsigned char *matchlimit = iend - LZ_LAST_LITERALS;
+    uint32_t table[1 << LZ_HASH_LOG] = {0};
+
+    ip++;
+
+    for (;;) {
+      const unsigned char *match;
+      size_t step = 1;
+      size_t attempts = 1 << LZ_SKIP_TRIGGER;
+
+      for (;;) {
+        if (ip > mflimit) {
+          goto last_literals;
+        }
+
+        uint32_t h = lz_hash(read_u32(ip));
+        match = base + table[h];
+        table[h] = (uint32_t)(ip - base);
+
+        if (ip - match <= LZ_MAX_OFFSET && read_u32(match) == read_u32(ip)) {
+          break;
+        }
+
+        ip += step;
+        step = attempts++ >> LZ_SKIP_TRIGGER;
+      }
+
+      while (ip > anchor && match > base && ip[-1] == match[-1]) {
+        ip--;
+        match--;
+      }
+
+      unsigned char *token = op;
+      op = lz_write_literals(op, anchor, ip - anchor);
+
+      // Emit matches for as long as the next position keeps matching
+      for (;;) {
+        size_t offset = ip - match;
+        *op++ = (unsigned char)offset;
+        *op++ = (unsigned char)(offset >> 8);
+
+        size_t match_len = lz_match_len(ip + LZ_MIN_MATCH, match + LZ_MIN_MATCH,
+                                        matchlimit);
+        ip += LZ_MIN_MATCH + match_len;
+
+        if (match_len >= 15) {
+          *token |= 15;
+          op = lz_write_length(op, match_len - 15);
+        } else {
+          *token |= (unsigned char)match_len;
+        }
+
+        anchor = ip;
+        if (ip > mflimit) {
+          goto last_literals;
+        }
+
+        table[lz_hash(read_u32(ip - 2))] = (uint32_t)(ip - 2 - base);
+
+        uint32_t h = lz_hash(read_u32(ip));
+        match = base + table[h];
+        table[h] = (uint32_t)(ip - base);
+
+        if (ip - match > LZ_MAX_OFFSET || read_u32(match) != read_u32(ip)) {
+          break;
+        }
+
+        token = op++;
+        *token = 0;
+      }
+
+      ip++;
+    }
+  }
+
+last_literals:
+  op = lz_write_literals(op, anchor, iend - anchor);
+
+  return op - (unsigned char *)dest;
+}
+
+// Reads an LZ4 length continuation, adding it to `len`
+static bool lz_read_length(const unsigned char **ip, const unsigned char *iend,
+                           size_t *len) {
+  unsigned char b;
+  do {
+    if (*ip >= iend) {
+      return false;
+    }
+    b = *(*ip)++;
+    if (*len > SIZE_MAX - 255) {
+      return false;
+    }
+    *len += b;
+  } while (b == 255);
+
+  return true;
+}
+
+// Decodes a block into `dest`, whose `prefix` preceding bytes hold earlier
+// output that matches may refer back to
+static lz_result lz_decode(const unsigned char *src, size_t len,
+                           unsigned char *dest, size_t prefix, size_t cap,
+                           size_t *n_out) {
+  const unsigned char *ip = src;
+  const unsigned char *iend = src + len;
+  unsigned char *op = dest;
+  unsigned char *oend = dest + cap;
+  const unsigned char *lowest = dest - prefix;
+
+  for (;;) {
+    if (ip >= iend) {
+      return LZ_ERR_CORRUPT;
+    }
+
+    unsigned char token = *ip++;
+
+    size_t literals = token >> 4;
+    if (literals == 15 && !lz_read_length(&ip, iend, &literals)) {
+      return LZ_ERR_CORRUPT;
+    }
+
+    if (literals > (size_t)(iend - ip) || literals > (size_t)(oend - op)) {
+      return LZ_ERR_CORRUPT;
+    }
+
+    memcpy(op, ip, literals);
+    op += literals;
+    ip += literals;
+
+    // Only the last sequence lacks a match
+    if (ip == iend) {
+      break;
+    }
+
+    if (iend - ip < 2) {
+      return LZ_ERR_CORRUPT;
+    }
+
+    size_t offset = (size_t)ip[0] | (size_t)ip[1] << 8;
+    ip += 2;
+    if (offset == 0 || offset > (size_t)(op - lowest)) {
+      return LZ_ERR_CORRUPT;
+    }
+
+    size_t match_len = token & 15;
+    if (match_len == 15 && !lz_read_length(&ip, iend, &match_len)) {
+      return LZ_ERR_CORRUPT;
+    }
+    match_len += LZ_MIN_MATCH;
+
+    if (match_len > (size_t)(oend - op)) {
+      return LZ_ERR_CORRUPT;
+    }
+
+    const unsigned char *match = op - offset;
+    if (offset >= match_len) {
+      memcpy(op, match, match_len);
+      op += match_len;
+    } else {
+      // Overlapping matches repeat the last `offset` bytes
+      for (size_t i = 0; i < match_len; i++) {
+        *op++ = *match++;
+      }
+    }
+  }
+
+  *n_out = op - dest;
+
+  return LZ_OK;
+}
+
+lz_result lz_decompress_block(const char *src, size_t len, char *dest,
+                              size_t cap, size_t *n_out) {
+  if ((!src && len > 0) || (!dest && cap > 0) || !n_out) {
+    return LZ_ERR_INVALID;
+  }
+
+  return lz_decode((const unsigned char *)src, len, (unsigned char *)dest, 0,
+                   cap, n_out);
+}
+
+static size_t lz_write_frame_header(unsigned char *dest) {
+  write_le32(dest, LZ_FRAME_MAGIC);
+  dest[4] = LZ_FRAME_VERSION | LZ_FLG_BLOCK_INDEPENDENT |
+            LZ_FLG_CONTENT_CHECKSUM;
+  dest[5] = LZ_BLOCK_MAX_ID << 4;
+  dest[6] = (unsigned char)(xxh32(dest + 4, 2) >> 8);
+
+  return 7;
+}
+
+// Compresses one block of at most LIB_UTIL_LZ_BLOCK_MAX_SZ bytes, with its
+// size prefix, into `dest`, which must hold lz_compress_bound(len) + 4 bytes.
+// The block is stored as-is if compressing it would not make it smaller
+static size_t lz_write_block(const char *src, size_t len, unsigned char *dest) {
+  size_t n = lz_compress_block(src, len, (char *)dest + 4);
+  if (n >= len) {
+    memcpy(dest + 4, src, len);
+    write_le32(dest, (uint32_t)len | LZ_BLOCK_UNCOMPRESSED);
+    return len + 4;
+  }
+
+  write_le32(dest, (uint32_t)n);
+  return n + 4;
+}
+
+// Parses a frame header from the start of `src`, returning its length in
+// `n_header`. Returns LZ_ERR_CORRUPT if `src` is too short to tell
+static lz_result lz_read_frame_header(const unsigned char *src, size_t len,
+                                      lz_frame_header *header,
+                                      size_t *n_header) {
+  if (len < 7) {
+    return LZ_ERR_CORRUPT;
+  }
+
+  if (read_le32(src) != LZ_FRAME_MAGIC) {
+    return LZ_ERR_CORRUPT;
+  }
+
+  unsigned char flg = src[4];
+  unsigned char bd = src[5];
+  if ((flg & 0xc0) != LZ_FRAME_VERSION || (flg & 0x02) || (bd & 0x8f)) {
+    return LZ_ERR_CORRUPT;
+  }
+
+  if (flg & LZ_FLG_DICT_ID) {
+    return LZ_ERR_UNSUPPORTED;
+  }
+
+  int block_max_id = bd >> 4;
+  if (block_max_id < 4) {
+    return LZ_ERR_CORRUPT;
+  }
+
+  size_t descriptor = 2;
+  header->content_size = 0;
+  if (flg & LZ_FLG_CONTENT_SIZE) {
+    if (len < 15) {
+      return LZ_ERR_CORRUPT;
+    }
+    header->content_size = read_u64_le(src + 6);
+    descriptor += 8;
+  }
+
+  if (src[4 + descriptor] != (unsigned char)(xxh32(src + 4, descriptor) >> 8)) {
+    return LZ_ERR_CORRUPT;
+  }
+
+  header->flg = flg;
+  header->block_max = (size_t)1 << (8 + 2 * block_max_id);
+  *n_header = 4 + descriptor + 1;
+
+  return LZ_OK;
+}
+
+bool buffer_append_compressed(buffer_t *buf, const char *data, size_t len) {
+  if (!data && len > 0) {
+    return false;
+  }
+
+  size_t before = buffer_size(buf);
+  xxh32_state checksum;
+  xxh32_init(&checksum);
+
+  if (!buffer_reserve(buf, LZ_FRAME_HEADER_MAX)) {
+    return false;
+  }
+
+  __buffer_t *unwrapped = (__buffer_t *)buf;
+  unwrapped->len += lz_write_frame_header(
+      (unsigned char *)unwrapped->state + unwrapped->len);
+
+  for (size_t i = 0; i < len; i += LIB_UTIL_LZ_BLOCK_MAX_SZ) {
+    size_t n = len - i < LIB_UTIL_LZ_BLOCK_MAX_SZ ? len - i
+                                                  : LIB_UTIL_LZ_BLOCK_MAX_SZ;
+
+    if (!buffer_reserve(buf, lz_compress_bound(n) + 4)) {
+      unwrapped->len = before;
+      unwrapped->state[before] = '\0';
+      return false;
+    }
+
+    unwrapped->len += lz_write_block(
+        data + i, n, (unsigned char *)unwrapped->state + unwrapped->len);
+    xxh32_update(&checksum, (const unsigned char *)data + i, n);
+  }
+
+  unsigned char trailer[8];
+  write_le32(trailer, 0);
+  write_le32(trailer + 4, xxh32_digest(&checksum));
+
+  if (!buffer_append_with(buf, (const char *)trailer, sizeof(trailer))) {
+    unwrapped->len = before;
+    unwrapped->state[before] = '\0';
+    return false;
+  }
+
+  return true;
+}
+
+// Decodes the blocks of one frame whose header has been read, appending to
+// `buf` and returning the number of bytes consumed in `n_read`
+static lz_result lz_append_frame_blocks(buffer_t *buf, lz_frame_header *header,
+                                        const unsigned char *src, size_t len,
+                                        size_t *n_read) {
+  __buffer_t *unwrapped = (__buffer_t *)buf;
+  const unsigned char *ip = src;
+  const unsigned char *iend = src + len;
+  size_t frame_start = unwrapped->len;
+
+  xxh32_state checksum;
+  xxh32_init(&checksum);
+
+  for (;;) {
+    if (iend - ip < 4) {
+      return LZ_ERR_CORRUPT;
+    }
+
+    uint32_t block_sz = read_le32(ip);
+    ip += 4;
+
+    if (block_sz == 0) {
+      break;
+    }
+
+    bool uncompressed = block_sz & LZ_BLOCK_UNCOMPRESSED;
+    block_sz &= ~LZ_BLOCK_UNCOMPRESSED;
+
+    size_t trailer = header->flg & LZ_FLG_BLOCK_CHECKSUM ? 4 : 0;
+    if (block_sz > header->block_max ||
+        block_sz + trailer > (size_t)(iend - ip)) {
+      return LZ_ERR_CORRUPT;
+    }
+
+    if (trailer && read_le32(ip + block_sz) != xxh32(ip, block_sz)) {
+      return LZ_ERR_CORRUPT;
+    }
+
+    if (!buffer_reserve(buf, header->block_max)) {
+      return LZ_ERR_NOMEM;
+    }
+
+    unsigned char *dest = (unsigned char *)unwrapped->state + unwrapped->len;
+    size_t n;
+
+    if (uncompressed) {
+      memcpy(dest, ip, block_sz);
+      n = block_sz;
+    } else {
+      size_t prefix = header->flg & LZ_FLG_BLOCK_INDEPENDENT
+                          ? 0
+                          : unwrapped->len - frame_start;
+      lz_result rv =
+          lz_decode(ip, block_sz, dest, prefix, header->block_max, &n);
+      if (rv != LZ_OK) {
+        return rv;
+      }
+    }
+
+    xxh32_update(&checksum, dest, n);
+    unwrapped->len += n;
+    ip += block_sz + trailer;
+  }
+
+  if ((header->flg & LZ_FLG_CONTENT_SIZE) &&
+      header->content_size != unwrapped->len - frame_start) {
+    return LZ_ERR_CORRUPT;
+  }
+
+  if (header->flg & LZ_FLG_CONTENT_CHECKSUM) {
+    if (iend - ip < 4 || read_le32(ip) != xxh32_digest(&checksum)) {
+      return LZ_ERR_CORRUPT;
+    }
+    ip += 4;
+  }
+
+  *n_read = ip - src;
+
+  return LZ_OK;
+}
+
+lz_result buffer_append_decompressed(buffer_t *buf, const char *data,
+                                     size_t len) {
+  if (!data && len > 0) {
+    return LZ_ERR_INVALID;
+  }
+
+  const unsigned char *ip = (const unsigned char *)data;
+  const unsigned char *iend = ip + len;
+  size_t before = buffer_size(buf);
+  lz_result rv = LZ_OK;
+
+  // Input may hold several concatenated frames, possibly interspersed with
+  // skippable ones
+  while (ip < iend && rv == LZ_OK) {
+    size_t n;
+
+    if (iend - ip >= 8 &&
+        (read_le32(ip) & LZ_SKIPPABLE_MASK) == LZ_SKIPPABLE_MAGIC) {
+      n = read_le32(ip + 4);
+      if (n > (size_t)(iend - ip) - 8) {
+        rv = LZ_ERR_CORRUPT;
+        break;
+      }
+      ip += 8 + n;
+      continue;
+    }
+
+    lz_frame_header header;
+    rv = lz_read_frame_header(ip, iend - ip, &header, &n);
+    if (rv != LZ_OK) {
+      break;
+    }
+    ip += n;
+
+    rv = lz_append_frame_blocks(buf, &header, ip, iend - ip, &n);
+    ip += n;
+  }
+
+  __buffer_t *unwrapped = (__buffer_t *)buf;
+  if (rv != LZ_OK) {
+    unwrapped->len = before;
+  }
+
+  if (unwrapped->state) {
+    unwrapped->state[unwrapped->len] = '\0';
+  }
+
+  return rv;
+}
+
+lz_result lz_compress_file(FILE *src, FILE *dest) {
+  if (!src || !dest) {
+    return LZ_ERR_INVALID;
+  }
+
+  char *in = malloc(LIB_UTIL_LZ_BLOCK_MAX_SZ);
+  unsigned char *out = malloc(lz_compress_bound(LIB_UTIL_LZ_BLOCK_MAX_SZ) + 4);
+  lz_result rv = LZ_OK;
+
+  if (!in || !out) {
+    rv = LZ_ERR_NOMEM;
+    goto done;
+  }
+
+  xxh32_state checksum;
+  xxh32_init(&checksum);
+
+  unsigned char header[LZ_FRAME_HEADER_MAX];
+  size_t n = lz_write_frame_header(header);
+  if (fwrite(header, 1, n, dest) != n) {
+    rv = LZ_ERR_IO;
+    goto done;
+  }
+
+  while ((n = fread(in, 1, LIB_UTIL_LZ_BLOCK_MAX_SZ, src)) > 0) {
+    xxh32_update(&checksum, (const unsigned char *)in, n);
+
+    size_t block_sz = lz_write_block(in, n, out);
+    if (fwrite(out, 1, block_sz, dest) != block_sz) {
+      rv = LZ_ERR_IO;
+      goto done;
+    }
+  }
+
+  if (ferror(src)) {
+    rv = LZ_ERR_IO;
+    goto done;
+  }
+
+  write_le32(out, 0);
+  write_le32(out + 4, xxh32_digest(&checksum));
+  if (fwrite(out, 1, 8, dest) != 8 || fflush(dest) != 0) {
+    rv = LZ_ERR_IO;
+  }
+
+done:
+  free(in);
+  free(out);
+
+  return rv;
+}
+
+// Reads exactly `len` bytes, distinguishing a clean end of input (LZ_OK with
+// `*eof` set, only if nothing was read) from truncation
+static lz_result lz_read_exact(FILE *src, unsigned char *dest, size_t len,
+                               bool *eof) {
+  size_t n = fread(dest, 1, len, src);
+  if (n == len) {
+    return LZ_OK;
+  }
+
+  if (ferror(src)) {
+    return LZ_ERR_IO;
+  }
+
+  if (n == 0 && eof) {
+    *eof = true;
+    return LZ_OK;
+  }
+
+  return LZ_ERR_CORRUPT;
+}
+
+static lz_result lz_skip(FILE *src, size_t len) {
+  unsigned char scratch[4096];
+  while (len > 0) {
+    size_t n = len < sizeof(scratch) ? len : sizeof(scratch);
+    lz_result rv = lz_read_exact(src, scratch, n, NULL);
+    if (rv != LZ_OK) {
+      return rv;
+    }
+    len -= n;
+  }
+
+  return LZ_OK;
+}
+
+// Streams one frame whose header has been read from `src` to `dest`. Linked
+// blocks are decoded after a window holding the previous 64KB of output
+static lz_result lz_decompress_frame_file(FILE *src, FILE *dest,
+                                          lz_frame_header *header) {
+  size_t trailer = header->flg & LZ_FLG_BLOCK_CHECKSUM ? 4 : 0;
+  unsigned char *in = malloc(header->block_max + trailer);
+  unsigned char *window = malloc(LZ_MAX_OFFSET + header->block_max);
+  size_t history = 0;
+  uint64_t total = 0;
+  lz_result rv = LZ_OK;
+
+  xxh32_state checksum;
+  xxh32_init(&checksum);
+
+  if (!in || !window) {
+    rv = LZ_ERR_NOMEM;
+    goto done;
+  }
+
+  for (;;) {
+    unsigned char size_bytes[4];
+    if ((rv = lz_read_exact(src, size_bytes, 4, NULL)) != LZ_OK) {
+      goto done;
+    }
+
+    uint32_t block_sz = read_le32(size_bytes);
+    if (block_sz == 0) {
+      break;
+    }
+
+    bool uncompressed = block_sz & LZ_BLOCK_UNCOMPRESSED;
+    block_sz &= ~LZ_BLOCK_UNCOMPRESSED;
+
+    if (block_sz > header->block_max) {
+      rv = LZ_ERR_CORRUPT;
+      goto done;
+    }
+
+    if ((rv = lz_read_exact(src, in, block_sz + trailer, NULL)) != LZ_OK) {
+      goto done;
+    }
+
+    if (trailer && read_le32(in + block_sz) != xxh32(in, block_sz)) {
+      rv = LZ_ERR_CORRUPT;
+      goto done;
+    }
+
+    unsigned char *out = window + history;
+    size_t n;
+
+    if (uncompressed) {
+      memcpy(out, in, block_sz);
+      n = block_sz;
+    } else if ((rv = lz_decode(in, block_sz, out, history, header->block_max,
+                               &n)) != LZ_OK) {
+      goto done;
+    }
+
+    if (fwrite(out, 1, n, dest) != n) {
+      rv = LZ_ERR_IO;
+      goto done;
+    }
+
+    xxh32_update(&checksum, out, n);
+    total += n;
+
+    if (!(header->flg & LZ_FLG_BLOCK_INDEPENDENT)) {
+      history += n;
+      if (history > LZ_MAX_OFFSET) {
+        memmove(window, window + history - LZ_MAX_OFFSET, LZ_MAX_OFFSET);
+        history = LZ_MAX_OFFSET;
+      }
+    }
+  }
+
+  if ((header->flg & LZ_FLG_CONTENT_SIZE) && header->content_size != total) {
+    rv = LZ_ERR_CORRUPT;
+    goto done;
+  }
+
+  if (header->flg & LZ_FLG_CONTENT_CHECKSUM) {
+    unsigned char digest[4];
+    if ((rv = lz_read_exact(src, digest, 4, NULL)) != LZ_OK) {
+      goto done;
+    }
+
+    if (read_le32(digest) != xxh32_digest(&checksum)) {
+      rv = LZ_ERR_CORRUPT;
+    }
+  }
+
+done:
+  free(in);
+  free(window);
+
+  return rv;
+}
+
+lz_result lz_decompress_file(FILE *src, FILE *dest) {
+  if (!src || !dest) {
+    return LZ_ERR_INVALID;
+  }
+
+  for (;;) {
+    unsigned char header_bytes[LZ_FRAME_HEADER_MAX];
+    bool eof = false;
+    lz_result rv = lz_read_exact(src, header_bytes, 4, &eof);
+    if (rv != LZ_OK) {
+      return rv;
+    }
+
+    if (eof) {
+      break;
+    }
+
+    uint32_t magic = read_le32(header_bytes);
+    if ((magic & LZ_SKIPPABLE_MASK) == LZ_SKIPPABLE_MAGIC) {
+      if ((rv = lz_read_exact(src, header_bytes + 4, 4, NULL)) != LZ_OK ||
+          (rv = lz_skip(src, read_le32(header_bytes + 4))) != LZ_OK) {
+        return rv;
+      }
+      continue;
+    }
+
+    // Read FLG first, since it determines the header's length
+    if ((rv = lz_read_exact(src, header_bytes + 4, 1, NULL)) != LZ_OK) {
+      return rv;
+    }
+
+    size_t header_len = header_bytes[4] & LZ_FLG_CONTENT_SIZE ? 15 : 7;
+    if ((rv = lz_read_exact(src, header_bytes + 5, header_len - 5, NULL)) !=
+        LZ_OK) {
+      return rv;
+    }
+
+    lz_frame_header header;
+    size_t n;
+    if ((rv = lz_read_frame_header(header_bytes, header_len, &header, &n)) !=
+            LZ_OK ||
+        (rv = lz_decompress_frame_file(src, dest, &header)) != LZ_OK) {
+      return rv;
+    }
+  }
+
+  return fflush(dest) == 0 ? LZ_OK : LZ_ERR_IO;
+}
@@ -0,0 +1,428 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libutil.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MATCHER_X86 1
+#include <immintrin.h>
+#endif
+
+// Pattern sets up to this size are scanned with Teddy when the CPU supports
+// it. Past that the buckets fill up and false positives outweigh the
+// automaton's single table lookup per byte
+#define MATCHER_TEDDY_MAX_PATTERNS 32
+#define MATCHER_TEDDY_BUCKETS 8
+// Bytes of each pattern's prefix that Teddy fingerprints
+#define MATCHER_TEDDY_MAX_PREFIX 3
+
+#define MATCHER_NO_STATE UINT32_MAX
+
+struct __matcher {
+  // The patterns, back to back, and each one's offset and length
+  char *bytes;
+  size_t *offsets;
+  size_t *lens;
+  size_t n_patterns;
+
+  // Aho-Corasick DFA. Bytes that appear in no pattern all share class 0, so
+  // each state's row only spans the distinct bytes the patterns use
+  uint16_t classes[256];
+  size_t n_classes;
+  uint32_t *delta;
+  size_t n_states;
+  // Each state's own matches are out_patterns[out_starts[s] .. out_starts[s +
+  // 1]), and `dict` links to the next state along its fail chain with matches
+  // of its own, or MATCHER_NO_STATE
+  uint32_t *out_starts;
+  uint32_t *out_patterns;
+  uint32_t *dict;
+  bool *reports;
+
+  // Teddy: for each fingerprinted byte, which buckets' patterns have a given
+  // low or high nibble there, and which patterns are in each bucket
+  bool teddy;
+  size_t prefix_len;
+  uint8_t lo_nibbles[MATCHER_TEDDY_MAX_PREFIX][16];
+  uint8_t hi_nibbles[MATCHER_TEDDY_MAX_PREFIX][16];
+  uint32_t buckets[MATCHER_TEDDY_BUCKETS][MATCHER_TEDDY_MAX_PATTERNS];
+  size_t bucket_sizes[MATCHER_TEDDY_BUCKETS];
+};
+
+static const unsigned char *pattern_bytes(matcher_t *m, size_t i) {
+  return (const unsigned char *)m->bytes + m->offsets[i];
+}
+
+// Builds the trie, then fills in the fail transitions breadth-first so that
+// `delta` becomes a full DFA
+static bool matcher_build_automaton(matcher_t *m) {
+  size_t total = 0;
+  for (size_t i = 0; i < m->n_patterns; i++) {
+    total += m->lens[i];
+  }
+
+  memset(m->classes, 0, sizeof(m->classes));
+  m->n_classes = 1;
+  for (size_t i = 0; i < m->n_patterns; i++) {
+    const unsigned char *p = pattern_bytes(m, i);
+    for (size_t j = 0; j < m->lens[i]; j++) {
+      if (!m->classes[p[j]]) {
+        m->classes[p[j]] = m->n_classes++;
+      }
+    }
+  }
+
+  size_t max_states = total + 1;
+  uint32_t *fail = malloc(max_states * sizeof(uint32_t));
+  uint32_t *queue = malloc(max_states * sizeof(uint32_t));
+  uint32_t *own_counts = calloc(max_states, sizeof(uint32_t));
+  uint32_t *ends = malloc(m->n_patterns * sizeof(uint32_t));
+  m->delta = malloc(max_states * m->n_classes * sizeof(uint32_t));
+  m->out_starts = malloc((max_states + 1) * sizeof(uint32_t));
+  m->out_patterns = malloc(m->n_patterns * sizeof(uint32_t));
+  m->dict = malloc(max_states * sizeof(uint32_t));
+  m->reports = malloc(max_states * sizeof(bool));
+
+  bool ok = fail && queue && own_counts && ends && m->delta && m->out_starts &&
+            m->out_patterns && m->dict && m->reports;
+  if (!ok) {
+    goto done;
+  }
+
+  for (size_t i = 0; i < max_states * m->n_classes; i++) {
+    m->delta[i] = MATCHER_NO_STATE;
+  }
+  m->n_states = 1;
+
+  for (size_t i = 0; i < m->n_patterns; i++) {
+    const unsigned char *p = pattern_bytes(m, i);
+    uint32_t state = 0;
+
+    for (size_t j = 0; j < m->lens[i]; j++) {
+      uint32_t *next = &m->delta[state * m->n_classes + m->classes[p[j]]];
+      if (*next == MATCHER_NO_STATE) {
+        *next = m->n_states++;
+      }
+      state = *next;
+    }
+
+    ends[i] = state;
+    own_counts[state]++;
+  }
+
+  // Group the patterns by the state that matches them
+  m->out_starts[0] = 0;
+  for (size_t s = 0; s < m->n_states; s++) {
+    m->out_starts[s + 1] = m->out_starts[s] + own_counts[s];
+    own_counts[s] = m->out_starts[s];
+  }
+  for (size_t i = 0; i < m->n_patterns; i++) {
+    m->out_patterns[own_counts[ends[i]]++] = i;
+  }
+
+  size_t head = 0, tail = 0;
+  fail[0] = 0;
+  m->dict[0] = MATCHER_NO_STATE;
+
+  for (size_t c = 0; c < m->n_classes; c++) {
+    uint32_t *next = &m->delta[c];
+    if (*next == MATCHER_NO_STATE) {
+      *next = 0;
+    } else {
+      fail[*next] = 0;
+      m->dict[*next] = MATCHER_NO_STATE;
+      queue[tail++] = *next;
+    }
+  }
+
+  while (head < tail) {
+    uint32_t state = queue[head++];
+    uint32_t *row = &m->delta[state * m->n_classes];
+    uint32_t *fail_row = &m->delta[fail[state] * m->n_classes];
+
+    for (size_t c = 0; c < m->n_classes; c++) {
+      if (row[c] == MATCHER_NO_STATE) {
+        row[c] = fail_row[c];
+        continue;
+      }
+
+      uint32_t child = row[c];
+      uint32_t child_fail = fail_row[c];
+      fail[child] = child_fail;
+      m->dict[child] = m->out_starts[child_fail + 1] > m->out_starts[child_fail]
+                           ? child_fail
+                           : m->dict[child_fail];
+      queue[tail++] = child;
+    }
+  }
+
+  for (size_t s = 0; s < m->n_states; s++) {
+    m->reports[s] = m->out_starts[s + 1] > m->out_starts[s] ||
+                    m->dict[s] != MATCHER_NO_STATE;
+  }
+
+done:
+  free(fail);
+  free(queue);
+  free(own_counts);
+  free(ends);
+
+  return ok;
+}
+
+static void matcher_build_teddy(matcher_t *m) {
+  m->teddy = false;
+
+#ifdef MATCHER_X86
+  if (m->n_patterns > MATCHER_TEDDY_MAX_PATTERNS ||
+      !__builtin_cpu_supports("ssse3")) {
+    return;
+  }
+
+  m->prefix_len = MATCHER_TEDDY_MAX_PREFIX;
+  for (size_t i = 0; i < m->n_patterns; i++) {
+    if (m->lens[i] < m->prefix_len) {
+      m->prefix_len = m->lens[i];
+    }
+  }
+
+  memset(m->lo_nibbles, 0, sizeof(m->lo_nibbles));
+  memset(m->hi_nibbles, 0, sizeof(m->hi_nibbles));
+  memset(m->bucket_sizes, 0, sizeof(m->bucket_sizes));
+
+  for (size_t i = 0; i < m->n_patterns; i++) {
+    size_t bucket = i % MATCHER_TEDDY_BUCKETS;
+    const unsigned char *p = pattern_bytes(m, i);
+
+    m->buckets[bucket][m->bucket_sizes[bucket]++] = i;
+    for (size_t k = 0; k < m->prefix_len; k++) {
+      m->lo_nibbles[k][p[k] & 0xf] |= 1 << bucket;
+      m->hi_nibbles[k][p[k] >> 4] |= 1 << bucket;
+    }
+  }
+
+  m->teddy = true;
+#endif
+}
+
+matcher_t *matcher_init(array_t *patterns) {
+  if (!patterns || array_size(patterns) == 0) {
+    return NULL;
+  }
+
+  matcher_t *m = calloc(1, sizeof(matcher_t));
+  if (!m) {
+    return NULL;
+  }
+
+  m->n_patterns = array_size(patterns);
+  m->offsets = malloc(m->n_patterns * sizeof(size_t));
+  m->lens = malloc(m->n_patterns * sizeof(size_t));
+  if (!m->offsets || !m->lens) {
+    matcher_free(m);
+    return NULL;
+  }
+
+  size_t total = 0;
+  for (size_t i = 0; i < m->n_patterns; i++) {
+    const char *p = array_get(patterns, i);
+    if (!p || *p == '\0') {
+      matcher_free(m);
+      return NULL;
+    }
+
+    m->offsets[i] = total;
+    m->lens[i] = strlen(p);
+    total += m->lens[i];
+  }
+
+  m->bytes = malloc(total);
+  if (!m->bytes) {
+    matcher_free(m);
+    return NULL;
+  }
+
+  for (size_t i = 0; i < m->n_patterns; i++) {
+    memcpy(m->bytes + m->offsets[i], array_get(patterns, i), m->lens[i]);
+  }
+
+  if (!matcher_build_automaton(m)) {
+    matcher_free(m);
+    return NULL;
+  }
+  matcher_build_teddy(m);
+
+  return m;
+}
+
+size_t matcher_size(matcher_t *m) { return m->n_patterns; }
+
+// Reports every match ending at the given state and position. Returns false
+// once the callback asks to stop
+static bool matcher_report(matcher_t *m, uint32_t state, size_t end,
+                           matcher_fn *fn, void *ctx, size_t *n_matches) {
+  while (state != MATCHER_NO_STATE) {
+    for (uint32_t i = m->out_starts[state]; i < m->out_starts[state + 1];
+         i++) {
+      uint32_t pattern = m->out_patterns[i];
+      (*n_matches)++;
+      if (fn && !fn(pattern, end - m->lens[pattern], ctx)) {
+        return false;
+      }
+    }
+    state = m->dict[state];
+  }
+
+  return true;
+}
+
+static size_t matcher_scan_automaton(matcher_t *m, const char *s, size_t len,
+                                     matcher_fn *fn, void *ctx) {
+  const unsigned char *p = (const unsigned char *)s;
+  size_t n_matches = 0;
+  uint32_t state = 0;
+
+  for (size_t i = 0; i < len; i++) {
+    state = m->delta[state * m->n_classes + m->classes[p[i]]];
+    if (m->reports[state] &&
+        !matcher_report(m, state, i + 1, fn, ctx, &n_matches)) {
+      break;
+    }
+  }
+
+  return n_matches;
+}
+
+// Checks every pattern in the given buckets against the text at `start`
+static bool matcher_verify(matcher_t *m, const char *s, size_t len,
+                           size_t start, unsigned bucket_mask, matcher_fn *fn,
+                           void *ctx, size_t *n_matches) {
+  while (bucket_mask) {
+    size_t bucket = __builtin_ctz(bucket_mask);
+    bucket_mask &= bucket_mask - 1;
+
+    for (size_t i = 0; i < m->bucket_sizes[bucket]; i++) {
+      uint32_t pattern = m->buckets[bucket][i];
+      size_t plen = m->lens[pattern];
+
+      if (plen <= len - start &&
+          !memcmp(s + start, m->bytes + m->offsets[pattern], plen)) {
+        (*n_matches)++;
+        if (fn && !fn(pattern, start, ctx)) {
+          return false;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+#ifdef MATCHER_X86
+
+// Teddy, from Hyperscan by way of the Rust regex crate: for each of 16
+// candidate starting positions at once, looks up which buckets have a pattern
+// whose prefix agrees with the text nibble by nibble, and only verifies those
+// buckets' patterns
+__attribute__((target("ssse3"))) static size_t matcher_scan_teddy(
+    matcher_t *m, const char *s, size_t len, matcher_fn *fn, void *ctx) {
+  const __m128i low_mask = _mm_set1_epi8(0xf);
+  __m128i lo[MATCHER_TEDDY_MAX_PREFIX];
+  __m128i hi[MATCHER_TEDDY_MAX_PREFIX];
+  size_t n_matches = 0;
+  size_t i = 0;
+
+  for (size_t k = 0; k < m->prefix_len; k++) {
+    lo[k] = _mm_loadu_si128((const __m128i *)m->lo_nibbles[k]);
+    hi[k] = _mm_loadu_si128((const __m128i *)m->hi_nibbles[k]);
+  }
+
+  for (; i + 16 + m->prefix_len - 1 <= len; i += 16) {
+    __m128i candidates = _mm_set1_epi8((char)0xff);
+
+    for (size_t k = 0; k < m->prefix_len; k++) {
+      __m128i block = _mm_loadu_si128((const __m128i *)(s + i + k));
+      __m128i lo_buckets =
+          _mm_shuffle_epi8(lo[k], _mm_and_si128(block, low_mask));
+      __m128i hi_buckets = _mm_shuffle_epi8(
+          hi[k], _mm_and_si128(_mm_srli_epi16(block, 4), low_mask));
+      candidates = _mm_and_si128(candidates,
+                                 _mm_and_si128(lo_buckets, hi_buckets));
+    }
+
+    unsigned mask = ~_mm_movemask_epi8(
+                        _mm_cmpeq_epi8(candidates, _mm_setzero_si128())) &
+                    0xffff;
+    if (!mask) {
+      continue;
+    }
+
+    uint8_t buckets[16];
+    _mm_storeu_si128((__m128i *)buckets, candidates);
+
+    while (mask) {
+      size_t j = __builtin_ctz(mask);
+      mask &= mask - 1;
+
+      if (!matcher_verify(m, s, len, i + j, buckets[j], fn, ctx,
+                          &n_matches)) {
+        return n_matches;
+      }
+    }
+  }
+
+  // Too close to the end for a full block; try every bucket at each position
+  unsigned all_buckets = (1 << MATCHER_TEDDY_BUCKETS) - 1;
+  for (; i < len; i++) {
+    if (!matcher_verify(m, s, len, i, all_buckets, fn, ctx, &n_matches)) {
+      break;
+    }
+  }
+
+  return n_matches;
+}
+
+#endif
+
+size_t matcher_scan(matcher_t *m, const char *s, size_t len, matcher_fn *fn,
+                    void *ctx) {
+  if (!s) {
+    return 0;
+  }
+
+#ifdef MATCHER_X86
+  if (m->teddy) {
+    return matcher_scan_teddy(m, s, len, fn, ctx);
+  }
+#endif
+
+  return matcher_scan_automaton(m, s, len, fn, ctx);
+}
+
+static bool matcher_stop(size_t pattern, size_t start, void *ctx) {
+  (void)pattern;
+  (void)start;
+  (void)ctx;
+  return false;
+}
+
+bool matcher_matches(matcher_t *m, const char *s, size_t len) {
+  return matcher_scan(m, s, len, matcher_stop, NULL) > 0;
+}
+
+void matcher_free(matcher_t *m) {
+  if (!m) {
+    return;
+  }
+
+  free(m->bytes);
+  free(m->offsets);
+  free(m->lens);
+  free(m->delta);
+  free(m->out_starts);
+  free(m->out_patterns);
+  free(m->dict);
+  free(m->reports);
+  free(m);
+}
@@ -0,0 +1,311 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libutil.h"
+
+static const size_t default_class_sizes[] = {
+    256, 1024, 4096, 16384, 65536, 262144, 1048576,
+};
+
+struct __buffer_pool {
+  pthread_mutex_t lock;
+  array_t *free_lists[LIB_UTIL_BUFFER_POOL_MAX_CLASSES];
+  size_t class_sizes[LIB_UTIL_BUFFER_POOL_MAX_CLASSES];
+  size_t num_classes;
+  size_t max_retained;
+  atomic_size_t retained;
+  bool thread_cache;
+  pthread_key_t tcache_key;
+};
+
+typedef struct {
+  buffer_pool_t *pool;
+  size_t n;
+  buffer_t *slots[LIB_UTIL_BUFFER_POOL_TCACHE_SZ];
+} pool_tcache;
+
+static buffer_pool_t *default_pool = NULL;
+static pthread_once_t default_pool_once = PTHREAD_ONCE_INIT;
+
+static size_t pool_buffer_cap(buffer_t *buf) {
+  return ((__buffer_t *)buf)->cap;
+}
+
+// Reserves room for `cap` bytes in the pool's retention budget
+static bool pool_charge(buffer_pool_t *pool, size_t cap) {
+  size_t retained = atomic_load(&pool->retained);
+  do {
+    if (retained + cap > pool->max_retained) {
+      return false;
+    }
+  } while (!atomic_compare_exchange_weak(&pool->retained, &retained,
+                                         retained + cap));
+
+  return true;
+}
+
+static void pool_discharge(buffer_pool_t *pool, size_t cap) {
+  atomic_fetch_sub(&pool->retained, cap);
+}
+
+// Returns the largest class whose size the given capacity satisfies, or -1
+static ssize_t pool_class_for_cap(buffer_pool_t *pool, size_t cap) {
+  ssize_t idx = -1;
+  for (size_t i = 0; i < pool->num_classes && pool->class_sizes[i] <= cap;
+       i++) {
+    idx = i;
+  }
+
+  return idx;
+}
+
+static void pool_put_shared(buffer_pool_t *pool, buffer_t *buf) {
+  ssize_t idx = pool_class_for_cap(pool, pool_buffer_cap(buf));
+
+  pthread_mutex_lock(&pool->lock);
+  bool pushed = array_push(pool->free_lists[idx], buf);
+  pthread_mutex_unlock(&pool->lock);
+
+  if (!pushed) {
+    pool_discharge(pool, pool_buffer_cap(buf));
+    buffer_free(buf);
+  }
+}
+
+static buffer_t *pool_get_shared(buffer_pool_t *pool, size_t needed) {
+  buffer_t *buf = NULL;
+
+  pthread_mutex_lock(&pool->lock);
+  for (size_t i = 0; i < pool->num_classes; i++) {
+    array_t *free_list = pool->free_lists[i];
+    bool largest = i + 1 == pool->num_classes;
+
+    if (!has_elements(free_list) ||
+        (pool->class_sizes[i] < needed && !largest)) {
+      continue;
+    }
+
+    // Every buffer in a class is at least the class size, but the largest
+    // class is open-ended and so has to be checked
+    if (pool_buffer_cap(array_get(free_list, -1)) >= needed) {
+      buf = array_pop(free_list);
+    }
+    break;
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  return buf;
+}
+
+static void pool_tcache_flush(void *ptr) {
+  pool_tcache *tcache = ptr;
+
+  while (tcache->n > 0) {
+    pool_put_shared(tcache->pool, tcache->slots[--tcache->n]);
+  }
+
+  free(tcache);
+}
+
+static pool_tcache *pool_tcache_get(buffer_pool_t *pool) {
+  if (!pool->thread_cache) {
+    return NULL;
+  }
+
+  pool_tcache *tcache = pthread_getspecific(pool->tcache_key);
+  if (tcache) {
+    return tcache;
+  }
+
+  tcache = malloc(sizeof(pool_tcache));
+  if (!tcache) {
+    return NULL;
+  }
+
+  tcache->pool = pool;
+  tcache->n = 0;
+
+  if (pthread_setspecific(pool->tcache_key, tcache) != 0) {
+    free(tcache);
+    return NULL;
+  }
+
+  return tcache;
+}
+
+static void pool_default_init(void) {
+  default_pool = buffer_pool_init(NULL, 0, 0, true);
+}
+
+buffer_pool_t *buffer_pool_init(const size_t *class_sizes, size_t num_classes,
+                                size_t max_retained, bool thread_cache) {
+  if (class_sizes == NULL) {
+    class_sizes = default_class_sizes;
+    num_classes = sizeof(default_class_sizes) / sizeof(size_t);
+  }
+
+  if (num_classes == 0 || num_classes > LIB_UTIL_BUFFER_POOL_MAX_CLASSES) {
+    return NULL;
+  }
+
+  for (size_t i = 1; i < num_classes; i++) {
+    if (class_sizes[i] <= class_sizes[i - 1]) {
+      return NULL;
+    }
+  }
+
+  buffer_pool_t *pool = malloc(sizeof(buffer_pool_t));
+  if (!pool) {
+    return NULL;
+  }
+
+  pool->num_classes = num_classes;
+  pool->max_retained =
+      max_retained ? max_retained : LIB_UTIL_BUFFER_POOL_MAX_RETAINED;
+  pool->thread_cache = thread_cache;
+  atomic_init(&pool->retained, 0);
+
+  for (size_t i = 0; i < num_classes; i++) {
+    pool->class_sizes[i] = class_sizes[i];
+    pool->free_lists[i] = array_init();
+    if (!pool->free_lists[i]) {
+      while (i-- > 0) {
+        array_free(pool->free_lists[i], NULL);
+      }
+      free(pool);
+      return NULL;
+    }
+  }
+
+  pthread_mutex_init(&pool->lock, NULL);
+
+  if (thread_cache &&
+      pthread_key_create(&pool->tcache_key, pool_tcache_flush) != 0) {
+    pool->thread_cache = false;
+  }
+
+  return pool;
+}
+
+buffer_pool_t *buffer_pool_default(void) {
+  pthread_once(&default_pool_once, pool_default_init);
+  return default_pool;
+}
+
+buffer_t *buffer_pool_get(buffer_pool_t *pool, size_t size_hint) {
+  if (!pool && !(pool = buffer_pool_default())) {
+    return NULL;
+  }
+
+  // Capacities include room for the NUL terminator
+  size_t needed = size_hint + 1;
+  buffer_t *buf = NULL;
+
+  pool_tcache *tcache = pool_tcache_get(pool);
+  if (tcache) {
+    for (size_t i = tcache->n; i-- > 0;) {
+      if (pool_buffer_cap(tcache->slots[i]) >= needed) {
+        buf = tcache->slots[i];
+        tcache->slots[i] = tcache->slots[--tcache->n];
+        break;
+      }
+    }
+  }
+
+  if (!buf) {
+    buf = pool_get_shared(pool, needed);
+  }
+
+  if (buf) {
+    pool_discharge(pool, pool_buffer_cap(buf));
+    return buf;
+  }
+
+  buf = buffer_init(NULL);
+  if (!buf) {
+    return NULL;
+  }
+
+  // Allocate at the class size so that the buffer can be pooled on return
+  size_t reserve = size_hint;
+  for (size_t i = 0; i < pool->num_classes; i++) {
+    if (pool->class_sizes[i] >= needed) {
+      reserve = pool->class_sizes[i] - 1;
+      break;
+    }
+  }
+
+  if (!buffer_reserve(buf, reserve)) {
+    buffer_free(buf);
+    return NULL;
+  }
+
+  buffer_clear(buf);
+
+  return buf;
+}
+
+void buffer_pool_put(buffer_pool_t *pool, buffer_t *buf) {
+  if (!buf) {
+    return;
+  }
+
+  if (!pool && !(pool = buffer_pool_default())) {
+    buffer_free(buf);
+    return;
+  }
+
+  size_t cap = pool_buffer_cap(buf);
+  size_t largest = pool->class_sizes[pool->num_classes - 1];
+
+  // Don't hold on to buffers too small to be worth it or so large that they
+  // would crowd everything else out of the retention budget
+  if (pool_class_for_cap(pool, cap) < 0 || cap > largest * 2 ||
+      !pool_charge(pool, cap)) {
+    buffer_free(buf);
+    return;
+  }
+
+  buffer_clear(buf);
+
+  pool_tcache *tcache = pool_tcache_get(pool);
+  if (tcache && tcache->n < LIB_UTIL_BUFFER_POOL_TCACHE_SZ) {
+    tcache->slots[tcache->n++] = buf;
+    return;
+  }
+
+  pool_put_shared(pool, buf);
+}
+
+size_t buffer_pool_retained(buffer_pool_t *pool) {
+  if (!pool && !(pool = buffer_pool_default())) {
+    return 0;
+  }
+
+  return atomic_load(&pool->retained);
+}
+
+void buffer_pool_free(buffer_pool_t *pool) {
+  if (!pool) {
+    return;
+  }
+
+  if (pool->thread_cache) {
+    pool_tcache *tcache = pthread_getspecific(pool->tcache_key);
+    if (tcache) {
+      pthread_setspecific(pool->tcache_key, NULL);
+      pool_tcache_flush(tcache);
+    }
+
+    pthread_key_delete(pool->tcache_key);
+  }
+
+  for (size_t i = 0; i < pool->num_classes; i++) {
+    array_free(pool->free_lists[i], (free_fn *)buffer_free);
+  }
+
+  pthread_mutex_destroy(&pool->lock);
+  free(pool);
+}
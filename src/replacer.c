@@ -0,0 +1,334 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libutil.h"
+
+#define REPLACER_NONE UINT32_MAX
+
+typedef struct {
+  size_t start;
+  size_t pair;
+} replacer_edit;
+
+// Up to this many candidate start positions are tracked on the stack while
+// matches are filtered
+#define REPLACER_STACK_WINDOW 64
+
+typedef struct {
+  s_replacer_t *r;
+  replacer_edit *edits;
+  size_t n;
+  size_t cap;
+  bool nomem;
+
+  // Matches are filtered as matcher_scan reports them. `best[p % window]` is
+  // the lowest pair found so far starting at p, or REPLACER_NONE; every start
+  // below `settled` has already been kept or dropped, and the last kept match
+  // ends at `next`
+  uint32_t *best;
+  size_t window;
+  size_t settled;
+  size_t next;
+} replacer_edits;
+
+struct __s_replacer {
+  char **to;
+  size_t *from_lens;
+  size_t *to_lens;
+  size_t n_pairs;
+  size_t max_from_len;
+
+  // When every pattern is a single byte, as in most escaping tables, bytes
+  // are looked up directly: `bytes[c]` is the pair that replaces c, or
+  // REPLACER_NONE. Otherwise, all the patterns are found with a matcher_t
+  bool byte_mode;
+  uint32_t bytes[256];
+  matcher_t *matcher;
+};
+
+s_replacer_t *s_replacer_init(array_t *pairs) {
+  if (!pairs || array_size(pairs) == 0 || array_size(pairs) % 2 != 0) {
+    return NULL;
+  }
+
+  s_replacer_t *r = calloc(1, sizeof(s_replacer_t));
+  if (!r) {
+    return NULL;
+  }
+
+  r->n_pairs = array_size(pairs) / 2;
+  r->to = calloc(r->n_pairs, sizeof(char *));
+  r->from_lens = malloc(r->n_pairs * sizeof(size_t));
+  r->to_lens = malloc(r->n_pairs * sizeof(size_t));
+  array_t *froms = array_init();
+  if (!r->to || !r->from_lens || !r->to_lens || !froms) {
+    array_free(froms, NULL);
+    s_replacer_free(r);
+    return NULL;
+  }
+
+  r->byte_mode = true;
+  for (size_t i = 0; i < 256; i++) {
+    r->bytes[i] = REPLACER_NONE;
+  }
+
+  for (size_t i = 0; i < r->n_pairs; i++) {
+    char *from = array_get(pairs, i * 2);
+    char *to = array_get(pairs, i * 2 + 1);
+    if (!from || *from == '\0' || !to || !(r->to[i] = s_copy(to)) ||
+        !array_push(froms, from)) {
+      array_free(froms, NULL);
+      s_replacer_free(r);
+      return NULL;
+    }
+
+    r->from_lens[i] = strlen(from);
+    r->to_lens[i] = strlen(to);
+    r->byte_mode = r->byte_mode && r->from_lens[i] == 1;
+    if (r->from_lens[i] > r->max_from_len) {
+      r->max_from_len = r->from_lens[i];
+    }
+
+    // Where a pattern is repeated, the first pair wins
+    unsigned char c = from[0];
+    if (r->from_lens[i] == 1 && r->bytes[c] == REPLACER_NONE) {
+      r->bytes[c] = i;
+    }
+  }
+
+  if (!r->byte_mode && !(r->matcher = matcher_init(froms))) {
+    array_free(froms, NULL);
+    s_replacer_free(r);
+    return NULL;
+  }
+
+  array_free(froms, NULL);
+
+  return r;
+}
+
+static bool replacer_keep(replacer_edits *e, size_t start, size_t pair) {
+  if (e->n == e->cap) {
+    size_t cap = e->cap ? e->cap * 2 : 64;
+    replacer_edit *edits = realloc(e->edits, cap * sizeof(replacer_edit));
+    if (!edits) {
+      e->nomem = true;
+      return false;
+    }
+
+    e->edits = edits;
+    e->cap = cap;
+  }
+
+  e->edits[e->n].start = start;
+  e->edits[e->n].pair = pair;
+  e->n++;
+  e->next = start + e->r->from_lens[pair];
+
+  return true;
+}
+
+// Keeps or drops the best match at each start below `upto`, in order
+static bool replacer_settle(replacer_edits *e, size_t upto) {
+  // Only the `window` starts from `settled` on can hold a candidate
+  size_t stop = e->settled + e->window < upto ? e->settled + e->window : upto;
+
+  for (size_t p = e->settled; p < stop; p++) {
+    uint32_t *best = &e->best[p % e->window];
+    uint32_t pair = *best;
+    *best = REPLACER_NONE;
+
+    if (pair != REPLACER_NONE && p >= e->next && !replacer_keep(e, p, pair)) {
+      return false;
+    }
+  }
+
+  if (upto > e->settled) {
+    e->settled = upto;
+  }
+
+  return true;
+}
+
+// matcher_scan reports no match starting more than the longest pattern's
+// length before the end of one it has already reported, so every start below
+// that can be settled as soon as the match arrives
+static bool replacer_collect(size_t pattern, size_t start, void *ctx) {
+  replacer_edits *e = ctx;
+  size_t end = start + e->r->from_lens[pattern];
+
+  if (end > e->window && !replacer_settle(e, end - e->window)) {
+    return false;
+  }
+
+  uint32_t *best = &e->best[start % e->window];
+  if (start >= e->next && (*best == REPLACER_NONE || pattern < *best)) {
+    *best = pattern;
+  }
+
+  return true;
+}
+
+// Works out which matches to replace and the exact length of the output.
+// Matches are taken leftmost first, without overlapping; of those starting at
+// the same index, the earliest pair wins
+static bool replacer_plan(s_replacer_t *r, const char *s, size_t len,
+                          replacer_edits *e, size_t *out_len) {
+  e->r = r;
+  e->edits = NULL;
+  e->n = 0;
+  e->cap = 0;
+  e->nomem = false;
+
+  if (r->byte_mode) {
+    *out_len = len;
+    for (size_t i = 0; i < len; i++) {
+      uint32_t pair = r->bytes[(unsigned char)s[i]];
+      if (pair != REPLACER_NONE) {
+        *out_len = *out_len - 1 + r->to_lens[pair];
+      }
+    }
+
+    return true;
+  }
+
+  uint32_t stack_best[REPLACER_STACK_WINDOW];
+  e->window = r->max_from_len;
+  e->best = e->window <= REPLACER_STACK_WINDOW
+                ? stack_best
+                : malloc(e->window * sizeof(uint32_t));
+  if (!e->best) {
+    return false;
+  }
+
+  for (size_t i = 0; i < e->window; i++) {
+    e->best[i] = REPLACER_NONE;
+  }
+  e->settled = 0;
+  e->next = 0;
+
+  matcher_scan(r->matcher, s, len, replacer_collect, e);
+  if (!e->nomem) {
+    replacer_settle(e, len);
+  }
+
+  if (e->best != stack_best) {
+    free(e->best);
+  }
+
+  if (e->nomem) {
+    free(e->edits);
+    return false;
+  }
+
+  *out_len = len;
+  for (size_t i = 0; i < e->n; i++) {
+    size_t pair = e->edits[i].pair;
+    *out_len = *out_len - r->from_lens[pair] + r->to_lens[pair];
+  }
+
+  return true;
+}
+
+static void replacer_write(s_replacer_t *r, replacer_edits *e, char *dst,
+                           const char *s, size_t len) {
+  size_t prev = 0;
+
+  if (r->byte_mode) {
+    for (size_t i = 0; i < len; i++) {
+      uint32_t pair = r->bytes[(unsigned char)s[i]];
+      if (pair == REPLACER_NONE) {
+        continue;
+      }
+
+      memcpy(dst, s + prev, i - prev);
+      dst += i - prev;
+      memcpy(dst, r->to[pair], r->to_lens[pair]);
+      dst += r->to_lens[pair];
+      prev = i + 1;
+    }
+  } else {
+    for (size_t i = 0; i < e->n; i++) {
+      replacer_edit edit = e->edits[i];
+
+      memcpy(dst, s + prev, edit.start - prev);
+      dst += edit.start - prev;
+      memcpy(dst, r->to[edit.pair], r->to_lens[edit.pair]);
+      dst += r->to_lens[edit.pair];
+      prev = edit.start + r->from_lens[edit.pair];
+    }
+  }
+
+  memcpy(dst, s + prev, len - prev);
+}
+
+char *s_replacer_replace(s_replacer_t *r, const char *s) {
+  if (s == NULL) {
+    return NULL;
+  }
+
+  size_t len = strlen(s);
+  replacer_edits e;
+  size_t out_len;
+  if (!replacer_plan(r, s, len, &e, &out_len)) {
+    return NULL;
+  }
+
+  char *ret = malloc(out_len + 1);
+  if (ret) {
+    replacer_write(r, &e, ret, s, len);
+    ret[out_len] = '\0';
+  }
+
+  free(e.edits);
+
+  return ret;
+}
+
+bool s_replacer_append(s_replacer_t *r, buffer_t *buf, const char *s,
+                       size_t len) {
+  if (s == NULL && len > 0) {
+    return false;
+  }
+
+  if (len == 0) {
+    return true;
+  }
+
+  replacer_edits e;
+  size_t out_len;
+  if (!replacer_plan(r, s, len, &e, &out_len)) {
+    return false;
+  }
+
+  bool ok = buffer_reserve(buf, out_len);
+  if (ok) {
+    __buffer_t *unwrapped = (__buffer_t *)buf;
+    replacer_write(r, &e, unwrapped->state + unwrapped->len, s, len);
+    unwrapped->len += out_len;
+    unwrapped->state[unwrapped->len] = '\0';
+  }
+
+  free(e.edits);
+
+  return ok;
+}
+
+void s_replacer_free(s_replacer_t *r) {
+  if (!r) {
+    return;
+  }
+
+  if (r->to) {
+    for (size_t i = 0; i < r->n_pairs; i++) {
+      free(r->to[i]);
+    }
+  }
+
+  free(r->to);
+  free(r->from_lens);
+  free(r->to_lens);
+  matcher_free(r->matcher);
+  free(r);
+}
@@ -0,0 +1,270 @@
+#define _GNU_SOURCE  // for memfd_create
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include "libutil.h"
+
+#define RING_CACHE_LINE_SZ 64
+
+// The producer and consumer each own a cache line so that their index updates
+// don't invalidate one another's. Each side also caches the other's last-seen
+// index, which spares it the shared line only while that index already shows
+// the whole ring as free (to the producer) or full (to the consumer): any less,
+// and the other side may have moved on since, so the index is reloaded
+struct __ring {
+  _Alignas(RING_CACHE_LINE_SZ) atomic_size_t head;
+  size_t cached_tail;
+
+  _Alignas(RING_CACHE_LINE_SZ) atomic_size_t tail;
+  size_t cached_head;
+
+  _Alignas(RING_CACHE_LINE_SZ) char *state;
+  size_t cap;
+  size_t mask;
+  bool mirrored;
+};
+
+static size_t ring_round_pow2(size_t n) {
+  size_t ret = 1;
+  while (ret < n) {
+    ret <<= 1;
+  }
+
+  return ret;
+}
+
+#ifdef __linux__
+// Maps a memfd of `cap` bytes twice in a row so that the byte after the end of
+// the ring is its first byte again
+static char *ring_map_mirrored(size_t cap) {
+  int fd = memfd_create("libutil_ring", MFD_CLOEXEC);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  if (ftruncate(fd, cap) != 0) {
+    close(fd);
+    return NULL;
+  }
+
+  char *base =
+      mmap(NULL, cap * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED) {
+    close(fd);
+    return NULL;
+  }
+
+  if (mmap(base, cap, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) ==
+          MAP_FAILED ||
+      mmap(base + cap, cap, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd,
+           0) == MAP_FAILED) {
+    munmap(base, cap * 2);
+    close(fd);
+    return NULL;
+  }
+
+  // The mappings keep the memory alive
+  close(fd);
+
+  return base;
+}
+#endif
+
+ring_t *ring_init(size_t capacity, bool mirrored) {
+  // No larger power of two fits in a size_t
+  if (capacity > SIZE_MAX / 2 + 1) {
+    return NULL;
+  }
+
+  ring_t *ring = aligned_alloc(RING_CACHE_LINE_SZ, sizeof(ring_t));
+  if (!ring) {
+    return NULL;
+  }
+
+  size_t cap = ring_round_pow2(capacity ? capacity : 1);
+
+  ring->state = NULL;
+  ring->mirrored = false;
+
+#ifdef __linux__
+  if (mirrored) {
+    size_t page_sz = sysconf(_SC_PAGESIZE);
+    size_t mirrored_cap = cap < page_sz ? page_sz : cap;
+
+    ring->state = ring_map_mirrored(mirrored_cap);
+    if (ring->state) {
+      cap = mirrored_cap;
+      ring->mirrored = true;
+    }
+  }
+#endif
+
+  if (!ring->state) {
+    ring->state = malloc(cap);
+    if (!ring->state) {
+      free(ring);
+      return NULL;
+    }
+  }
+
+  ring->cap = cap;
+  ring->mask = cap - 1;
+  ring->cached_head = 0;
+  ring->cached_tail = 0;
+  atomic_init(&ring->head, 0);
+  atomic_init(&ring->tail, 0);
+
+  return ring;
+}
+
+size_t ring_capacity(ring_t *ring) { return ring->cap; }
+
+bool ring_is_mirrored(ring_t *ring) { return ring->mirrored; }
+
+size_t ring_size(ring_t *ring) {
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+  return head - tail;
+}
+
+char *ring_reserve(ring_t *ring, size_t *len) {
+  size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  size_t free_sz = ring->cap - (head - ring->cached_tail);
+
+  if (free_sz < ring->cap) {
+    ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    free_sz = ring->cap - (head - ring->cached_tail);
+
+    if (free_sz == 0) {
+      *len = 0;
+      return NULL;
+    }
+  }
+
+  size_t offset = head & ring->mask;
+  if (!ring->mirrored && free_sz > ring->cap - offset) {
+    free_sz = ring->cap - offset;
+  }
+
+  *len = free_sz;
+  return &ring->state[offset];
+}
+
+void ring_commit(ring_t *ring, size_t n) {
+  size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  atomic_store_explicit(&ring->head, head + n, memory_order_release);
+}
+
+size_t ring_write(ring_t *ring, const char *data, size_t len) {
+  size_t written = 0;
+
+  // At most two spans when the ring isn't mirrored
+  while (written < len) {
+    size_t span;
+    char *dest = ring_reserve(ring, &span);
+    if (!dest) {
+      break;
+    }
+
+    size_t n = len - written < span ? len - written : span;
+    memcpy(dest, data + written, n);
+    ring_commit(ring, n);
+    written += n;
+  }
+
+  return written;
+}
+
+ssize_t ring_fill_fd(ring_t *ring, int fd) {
+  size_t span;
+  char *dest = ring_reserve(ring, &span);
+  if (!dest) {
+    errno = ENOBUFS;
+    return -1;
+  }
+
+  ssize_t n;
+  do {
+    n = read(fd, dest, span);
+  } while (n < 0 && errno == EINTR);
+
+  if (n > 0) {
+    ring_commit(ring, n);
+  }
+
+  return n;
+}
+
+const char *ring_peek(ring_t *ring, size_t *len) {
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  size_t avail = ring->cached_head - tail;
+
+  if (avail < ring->cap) {
+    ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    avail = ring->cached_head - tail;
+
+    if (avail == 0) {
+      *len = 0;
+      return NULL;
+    }
+  }
+
+  size_t offset = tail & ring->mask;
+  if (!ring->mirrored && avail > ring->cap - offset) {
+    avail = ring->cap - offset;
+  }
+
+  *len = avail;
+  return &ring->state[offset];
+}
+
+void ring_consume(ring_t *ring, size_t n) {
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  atomic_store_explicit(&ring->tail, tail + n, memory_order_release);
+}
+
+size_t ring_read(ring_t *ring, char *dest, size_t len) {
+  size_t n_read = 0;
+
+  while (n_read < len) {
+    size_t span;
+    const char *src = ring_peek(ring, &span);
+    if (!src) {
+      break;
+    }
+
+    size_t n = len - n_read < span ? len - n_read : span;
+    memcpy(dest + n_read, src, n);
+    ring_consume(ring, n);
+    n_read += n;
+  }
+
+  return n_read;
+}
+
+void ring_free(ring_t *ring) {
+  if (!ring) {
+    return;
+  }
+
+#ifdef __linux__
+  if (ring->mirrored) {
+    munmap(ring->state, ring->cap * 2);
+  } else {
+    free(ring->state);
+  }
+#else
+  free(ring->state);
+#endif
+
+  free(ring);
+}
@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+#include "libutil.h"
+
+// Number of chunks handed to a single io_writev_all call
+#define ROPE_IOV_BATCH 64
+
+static __rope_chunk_t *rope_chunk_init(size_t cap) {
+  __rope_chunk_t *chunk = malloc(sizeof(__rope_chunk_t) + cap);
+  if (!chunk) {
+    return NULL;
+  }
+
+  chunk->next = NULL;
+  chunk->len = 0;
+  chunk->cap = cap;
+
+  return chunk;
+}
+
+rope_t *rope_init(size_t chunk_sz) {
+  __rope_t *rope = malloc(sizeof(__rope_t));
+  if (!rope) {
+    return NULL;
+  }
+
+  rope->head = NULL;
+  rope->tail = NULL;
+  rope->len = 0;
+  rope->num_chunks = 0;
+  rope->chunk_sz = chunk_sz ? chunk_sz : LIB_UTIL_ROPE_CHUNK_SZ;
+
+  return (rope_t *)rope;
+}
+
+size_t rope_size(rope_t *self) { return ((__rope_t *)self)->len; }
+
+size_t rope_num_chunks(rope_t *self) {
+  return ((__rope_t *)self)->num_chunks;
+}
+
+bool rope_append_with(rope_t *self, const char *s, size_t len) {
+  __rope_t *unwrapped = (__rope_t *)self;
+
+  if (!s && len > 0) {
+    return false;
+  }
+
+  while (len > 0) {
+    __rope_chunk_t *tail = unwrapped->tail;
+
+    if (!tail || tail->len == tail->cap) {
+      __rope_chunk_t *next = rope_chunk_init(unwrapped->chunk_sz);
+      if (!next) {
+        return false;
+      }
+
+      if (tail) {
+        tail->next = next;
+      } else {
+        unwrapped->head = next;
+      }
+
+      unwrapped->tail = tail = next;
+      unwrapped->num_chunks++;
+    }
+
+    size_t room = tail->cap - tail->len;
+    size_t n = len < room ? len : room;
+
+    memcpy(&tail->data[tail->len], s, n);
+    tail->len += n;
+    unwrapped->len += n;
+    s += n;
+    len -= n;
+  }
+
+  return true;
+}
+
+bool rope_append(rope_t *self, const char *s) {
+  if (!s) {
+    return false;
+  }
+
+  return rope_append_with(self, s, strlen(s));
+}
+
+bool rope_append_char(rope_t *self, const char c) {
+  return rope_append_with(self, &c, 1);
+}
+
+bool rope_append_buffer(rope_t *self, buffer_t *buf) {
+  return rope_append_with(self, buffer_state(buf), buffer_size(buf));
+}
+
+void rope_foreach_chunk(rope_t *self, rope_chunk_fn *callback, void *ctx) {
+  __rope_t *unwrapped = (__rope_t *)self;
+
+  for (__rope_chunk_t *chunk = unwrapped->head; chunk; chunk = chunk->next) {
+    if (chunk->len && !callback(chunk->data, chunk->len, ctx)) {
+      return;
+    }
+  }
+}
+
+char *rope_flatten(rope_t *self) {
+  __rope_t *unwrapped = (__rope_t *)self;
+
+  char *ret = malloc(unwrapped->len + 1);
+  if (!ret) {
+    return NULL;
+  }
+
+  char *current = ret;
+  for (__rope_chunk_t *chunk = unwrapped->head; chunk; chunk = chunk->next) {
+    memcpy(current, chunk->data, chunk->len);
+    current += chunk->len;
+  }
+
+  *current = '\0';
+
+  return ret;
+}
+
+io_write_all_result rope_write_fd(rope_t *self, int fd, size_t *n_write_ptr) {
+  __rope_t *unwrapped = (__rope_t *)self;
+  struct iovec iov[ROPE_IOV_BATCH];
+  size_t total_written = 0;
+  io_write_all_result ret = IO_WRITE_ALL_OK;
+
+  __rope_chunk_t *chunk = unwrapped->head;
+  while (chunk && ret == IO_WRITE_ALL_OK) {
+    int iovcnt = 0;
+    for (; chunk && iovcnt < ROPE_IOV_BATCH; chunk = chunk->next) {
+      iov[iovcnt].iov_base = chunk->data;
+      iov[iovcnt].iov_len = chunk->len;
+      iovcnt++;
+    }
+
+    size_t n_written = 0;
+    ret = io_writev_all(fd, iov, iovcnt, &n_written);
+    total_written += n_written;
+  }
+
+  if (n_write_ptr) {
+    *n_write_ptr = total_written;
+  }
+
+  return ret;
+}
+
+io_write_all_result rope_write_file(rope_t *self, FILE *fp,
+                                    size_t *n_write_ptr) {
+  if (fp == NULL) {
+    return IO_WRITE_ALL_INVALID;
+  }
+
+  // Anything already sitting in the stdio buffer must land before the rope
+  if (ferror(fp) || fflush(fp) != 0) {
+    return IO_WRITE_ALL_ERR;
+  }
+
+  return rope_write_fd(self, fileno(fp), n_write_ptr);
+}
+
+void rope_free(rope_t *self) {
+  __rope_t *unwrapped = (__rope_t *)self;
+
+  __rope_chunk_t *chunk = unwrapped->head;
+  while (chunk) {
+    __rope_chunk_t *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+
+  free(unwrapped);
+}
@@ -0,0 +1,673 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libutil.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SEARCH_X86 1
+#include <immintrin.h>
+#endif
+
+// Needles at least this long get Two-Way's linear worst case. The
+// first/last-byte filter is much faster on typical text but degrades to a
+// memcmp per position on periodic haystacks, and a long needle gives those
+// memcmps the most to do, so long needles start with the filter and switch to
+// Two-Way once its false positives cost more than the scan itself
+#define SEARCH_TWO_WAY_MIN 32
+
+// False positives the filter may verify for a long needle before the bound
+// above kicks in
+#define SEARCH_FILTER_SLACK 16
+
+#define SEARCH_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+// A byte as compared by a search that may be ignoring ASCII case
+#define SEARCH_FOLD(c, fold) ((fold) ? ascii_lower(c) : (c))
+
+// Searches at most `len` bytes of `s` for `target` (at least 2 bytes),
+// returning the index of a match and setting `found`, or otherwise the number
+// of leading positions it ruled out. If `bounded`, gives up early once more
+// than SEARCH_FILTER_SLACK + i / target_len candidates failed verification,
+// which keeps the total bytes compared linear in those scanned. If `fold`,
+// ignores ASCII case
+typedef size_t search_kernel(const char *s, size_t len, const char *target,
+                             size_t target_len, bool fold, bool bounded,
+                             bool *found);
+
+struct __s_needle {
+  char *ptr;
+  size_t len;
+  bool fold;
+  search_kernel *kernel;
+  // Two-Way state, for long needles only: the critical factorization `ms`,
+  // the period `p`, how much of a periodic needle is known to match after a
+  // shift (`mem0`) and a bad-character shift table over `byteset`
+  size_t ms;
+  size_t p;
+  size_t mem0;
+  size_t byteset[256 / (8 * sizeof(size_t))];
+  size_t shift[256];
+};
+
+static unsigned char ascii_lower(unsigned char c) {
+  return (unsigned char)(c - 'A') < 26 ? c | 0x20 : c;
+}
+
+// The bits to set in a byte before comparing it with `c`: to ignore case, a
+// letter is compared with 0x20 set, which also lets through a few
+// non-letters such as '@' for '`' that verification then rejects
+static char case_bits(char c, bool fold) {
+  return fold && (unsigned char)((c | 0x20) - 'a') < 26 ? 0x20 : 0;
+}
+
+static bool search_verify(const char *s, const char *target, size_t len,
+                          bool fold) {
+  return fold ? s_casecmp_n(s, len, target, len) : !memcmp(s, target, len);
+}
+
+#ifdef SEARCH_X86
+
+// Compares 16 candidate positions at a time against the target's first and
+// last bytes, only running memcmp where both agree. See Wojciech Muła,
+// "SIMD-friendly algorithms for substring searching"
+__attribute__((target("sse2"))) static size_t search_sse2(
+    const char *s, size_t len, const char *target, size_t target_len,
+    bool fold, bool bounded, bool *found) {
+  const __m128i first_bits = _mm_set1_epi8(case_bits(target[0], fold));
+  const __m128i last_bits =
+      _mm_set1_epi8(case_bits(target[target_len - 1], fold));
+  const __m128i first = _mm_or_si128(_mm_set1_epi8(target[0]), first_bits);
+  const __m128i last =
+      _mm_or_si128(_mm_set1_epi8(target[target_len - 1]), last_bits);
+  size_t misses = 0;
+  size_t i = 0;
+
+  for (; i + 16 + target_len - 1 <= len; i += 16) {
+    __m128i block_first = _mm_or_si128(
+        _mm_loadu_si128((const __m128i *)(s + i)), first_bits);
+    __m128i block_last = _mm_or_si128(
+        _mm_loadu_si128((const __m128i *)(s + i + target_len - 1)), last_bits);
+
+    unsigned mask = _mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last)));
+
+    while (mask) {
+      size_t candidate = i + __builtin_ctz(mask);
+      if (search_verify(s + candidate, target, target_len, fold)) {
+        *found = true;
+        return candidate;
+      }
+      if (bounded && ++misses > SEARCH_FILTER_SLACK + i / target_len) {
+        return i;
+      }
+      mask &= mask - 1;
+    }
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2"))) static size_t search_avx2(
+    const char *s, size_t len, const char *target, size_t target_len,
+    bool fold, bool bounded, bool *found) {
+  const __m256i first_bits = _mm256_set1_epi8(case_bits(target[0], fold));
+  const __m256i last_bits =
+      _mm256_set1_epi8(case_bits(target[target_len - 1], fold));
+  const __m256i first =
+      _mm256_or_si256(_mm256_set1_epi8(target[0]), first_bits);
+  const __m256i last =
+      _mm256_or_si256(_mm256_set1_epi8(target[target_len - 1]), last_bits);
+  size_t misses = 0;
+  size_t i = 0;
+
+  for (; i + 32 + target_len - 1 <= len; i += 32) {
+    __m256i block_first = _mm256_or_si256(
+        _mm256_loadu_si256((const __m256i *)(s + i)), first_bits);
+    __m256i block_last = _mm256_or_si256(
+        _mm256_loadu_si256((const __m256i *)(s + i + target_len - 1)),
+        last_bits);
+
+    uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first),
+                         _mm256_cmpeq_epi8(block_last, last)));
+
+    while (mask) {
+      size_t candidate = i + __builtin_ctz(mask);
+      if (search_verify(s + candidate, target, target_len, fold)) {
+        *found = true;
+        return candidate;
+      }
+      if (bounded && ++misses > SEARCH_FILTER_SLACK + i / target_len) {
+        return i;
+      }
+      mask &= mask - 1;
+    }
+  }
+
+  return i;
+}
+
+#endif
+
+static search_kernel *filter_kernel(void) {
+#ifdef SEARCH_X86
+  if (__builtin_cpu_supports("avx2")) {
+    return search_avx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return search_sse2;
+  }
+#endif
+  return NULL;
+}
+
+// Scalar first-byte filter, used for whatever the vector kernel left over
+static ssize_t search_scalar(const char *s, size_t len, const char *target,
+                             size_t target_len, bool fold) {
+  if (fold) {
+    unsigned char first = ascii_lower(*target);
+    for (size_t i = 0; i + target_len <= len; i++) {
+      if (ascii_lower(s[i]) == first &&
+          search_verify(s + i, target, target_len, true)) {
+        return i;
+      }
+    }
+
+    return -1;
+  }
+
+  const char *p = s;
+  const char *last = s + len - target_len;
+
+  while (p <= last) {
+    p = memchr(p, *target, last - p + 1);
+    if (!p) {
+      return -1;
+    }
+
+    if (!memcmp(p + 1, target + 1, target_len - 1)) {
+      return p - s;
+    }
+
+    p++;
+  }
+
+  return -1;
+}
+
+static ssize_t search_filter(struct __s_needle *needle, const char *s,
+                             size_t len) {
+  size_t offset = 0;
+
+  if (needle->kernel) {
+    bool found = false;
+    offset = needle->kernel(s, len, needle->ptr, needle->len, needle->fold,
+                            false, &found);
+    if (found) {
+      return offset;
+    }
+  }
+
+  ssize_t idx = search_scalar(s + offset, len - offset, needle->ptr,
+                              needle->len, needle->fold);
+  return idx < 0 ? -1 : (ssize_t)offset + idx;
+}
+
+#define BYTESET_BITS (8 * sizeof(size_t))
+#define BYTESET_HAS(set, b) \
+  ((set)[(b) / BYTESET_BITS] >> ((b) % BYTESET_BITS) & 1)
+
+// Computes the maximal suffix of `n` under the given byte ordering, returning
+// its start minus one (wrapping to SIZE_MAX for the whole needle) and storing
+// its period in `period`
+static size_t maximal_suffix(const unsigned char *n, size_t len, bool fold,
+                             bool reverse, size_t *period) {
+  size_t ip = (size_t)-1, jp = 0, k = 1, p = 1;
+
+  while (jp + k < len) {
+    unsigned char a = SEARCH_FOLD(n[ip + k], fold);
+    unsigned char b = SEARCH_FOLD(n[jp + k], fold);
+    if (a == b) {
+      if (k == p) {
+        jp += p;
+        k = 1;
+      } else {
+        k++;
+      }
+    } else if (reverse ? a < b : a > b) {
+      jp += k;
+      k = 1;
+      p = jp - ip;
+    } else {
+      ip = jp++;
+      k = p = 1;
+    }
+  }
+
+  *period = p;
+  return ip;
+}
+
+// Two-Way preprocessing. See Crochemore and Perrin, "Two-way string-matching"
+// (1991); this follows musl's memmem. A case-insensitive search runs it over
+// the lowercased needle and haystack
+static void two_way_prepare(struct __s_needle *needle) {
+  const unsigned char *n = (const unsigned char *)needle->ptr;
+  size_t len = needle->len;
+  bool fold = needle->fold;
+
+  memset(needle->byteset, 0, sizeof(needle->byteset));
+  for (size_t i = 0; i < len; i++) {
+    unsigned char c = SEARCH_FOLD(n[i], fold);
+    needle->byteset[c / BYTESET_BITS] |= (size_t)1 << (c % BYTESET_BITS);
+    needle->shift[c] = i + 1;
+  }
+
+  size_t p, p_rev;
+  size_t ms = maximal_suffix(n, len, fold, false, &p);
+  size_t ms_rev = maximal_suffix(n, len, fold, true, &p_rev);
+  if (ms_rev + 1 > ms + 1) {
+    ms = ms_rev;
+    p = p_rev;
+  }
+
+  if (!search_verify((const char *)n, (const char *)n + p, ms + 1, fold)) {
+    needle->mem0 = 0;
+    p = SEARCH_MAX(ms, len - ms - 1) + 1;
+  } else {
+    needle->mem0 = len - p;
+  }
+
+  needle->ms = ms;
+  needle->p = p;
+}
+
+static ssize_t two_way_search(struct __s_needle *needle, const char *s,
+                              size_t len) {
+  const unsigned char *h = (const unsigned char *)s;
+  const unsigned char *z = h + len;
+  const unsigned char *n = (const unsigned char *)needle->ptr;
+  size_t l = needle->len;
+  size_t ms = needle->ms;
+  bool fold = needle->fold;
+  size_t mem = 0;
+  size_t k;
+
+  while ((size_t)(z - h) >= l) {
+    // Check the last byte first, skipping ahead by its shift on a mismatch
+    unsigned char c = SEARCH_FOLD(h[l - 1], fold);
+    if (BYTESET_HAS(needle->byteset, c)) {
+      k = l - needle->shift[c];
+      if (k) {
+        h += k < mem ? mem : k;
+        mem = 0;
+        continue;
+      }
+    } else {
+      h += l;
+      mem = 0;
+      continue;
+    }
+
+    // Compare the right half, then the left
+    for (k = SEARCH_MAX(ms + 1, mem);
+         k < l && SEARCH_FOLD(n[k], fold) == SEARCH_FOLD(h[k], fold); k++) {
+    }
+    if (k < l) {
+      h += k - ms;
+      mem = 0;
+      continue;
+    }
+
+    for (k = ms + 1; k > mem && SEARCH_FOLD(n[k - 1], fold) ==
+                                    SEARCH_FOLD(h[k - 1], fold);
+         k--) {
+    }
+    if (k <= mem) {
+      return h - (const unsigned char *)s;
+    }
+
+    h += needle->p;
+    mem = needle->mem0;
+  }
+
+  return -1;
+}
+
+static void needle_set(struct __s_needle *needle, const char *target,
+                       size_t len, bool fold) {
+  needle->ptr = (char *)target;
+  needle->len = len;
+  needle->fold = fold;
+  needle->kernel = filter_kernel();
+  if (needle->len >= SEARCH_TWO_WAY_MIN) {
+    two_way_prepare(needle);
+  }
+}
+
+static ssize_t needle_search(struct __s_needle *needle, const char *s,
+                             size_t len) {
+  if (needle->len == 0) {
+    return 0;
+  }
+
+  if (needle->len > len) {
+    return -1;
+  }
+
+  // libc's memchr is already vectorized
+  if (needle->len == 1 && !needle->fold) {
+    const char *p = memchr(s, *needle->ptr, len);
+    return p ? p - s : -1;
+  }
+
+  if (needle->len == 1) {
+    return search_scalar(s, len, needle->ptr, 1, true);
+  }
+
+  if (needle->len >= SEARCH_TWO_WAY_MIN) {
+    size_t offset = 0;
+
+    if (needle->kernel) {
+      bool found = false;
+      offset = needle->kernel(s, len, needle->ptr, needle->len, needle->fold,
+                              true, &found);
+      if (found) {
+        return offset;
+      }
+    }
+
+    ssize_t idx = two_way_search(needle, s + offset, len - offset);
+    return idx < 0 ? -1 : (ssize_t)offset + idx;
+  }
+
+  return search_filter(needle, s, len);
+}
+
+ssize_t s_indexof_n(const char *s, size_t len, const char *target,
+                    size_t target_len) {
+  if ((s == NULL && len > 0) || (target == NULL && target_len > 0)) {
+    return -1;
+  }
+
+  // Left uninitialized so short needles don't pay to zero the Two-Way tables
+  struct __s_needle needle;
+  needle_set(&needle, target, target_len, false);
+
+  return needle_search(&needle, s, len);
+}
+
+ssize_t s_indexof_case_n(const char *s, size_t len, const char *target,
+                         size_t target_len) {
+  if ((s == NULL && len > 0) || (target == NULL && target_len > 0)) {
+    return -1;
+  }
+
+  struct __s_needle needle;
+  needle_set(&needle, target, target_len, true);
+
+  return needle_search(&needle, s, len);
+}
+
+ssize_t s_indexof_case(const char *s, const char *target) {
+  if (s == NULL || target == NULL) {
+    return -1;
+  }
+
+  return s_indexof_case_n(s, strlen(s), target, strlen(target));
+}
+
+array_t *s_indexof_all(const char *s, const char *target) {
+  if (s == NULL || target == NULL) {
+    return NULL;
+  }
+
+  array_t *indices = array_init();
+  if (!indices) {
+    return NULL;
+  }
+
+  size_t target_len = strlen(target);
+  if (target_len == 0) {
+    return indices;
+  }
+
+  struct __s_needle needle;
+  needle_set(&needle, target, target_len, false);
+
+  size_t len = strlen(s);
+  size_t offset = 0;
+  ssize_t idx;
+
+  while ((idx = needle_search(&needle, s + offset, len - offset)) >= 0) {
+    if (!array_push(indices, (void *)(uintptr_t)(offset + idx))) {
+      array_free(indices, NULL);
+      return NULL;
+    }
+
+    offset += idx + needle.len;
+  }
+
+  return indices;
+}
+
+size_t s_count(const char *s, const char *target) {
+  if (s == NULL || target == NULL || *target == '\0') {
+    return 0;
+  }
+
+  struct __s_needle needle;
+  needle_set(&needle, target, strlen(target), false);
+
+  size_t len = strlen(s);
+  size_t offset = 0;
+  size_t count = 0;
+  ssize_t idx;
+
+  while ((idx = needle_search(&needle, s + offset, len - offset)) >= 0) {
+    count++;
+    offset += idx + needle.len;
+  }
+
+  return count;
+}
+
+// Offsets of the matches to replace. Most strings have few enough that they
+// fit on the stack, and the rest grow a heap array, so the output is still
+// written with a single allocation of its exact size
+#define REPLACE_STACK_MATCHES 64
+
+typedef struct {
+  size_t *at;
+  size_t n;
+  size_t cap;
+  size_t stack[REPLACE_STACK_MATCHES];
+} replace_matches;
+
+static void replace_matches_free(replace_matches *m) {
+  if (m->at != m->stack) {
+    free(m->at);
+  }
+}
+
+static bool replace_matches_grow(replace_matches *m) {
+  size_t *at = malloc(m->cap * 2 * sizeof(size_t));
+  if (!at) {
+    return false;
+  }
+
+  memcpy(at, m->at, m->n * sizeof(size_t));
+  replace_matches_free(m);
+  m->at = at;
+  m->cap *= 2;
+
+  return true;
+}
+
+// Finds up to `max` non-overlapping occurrences of `from` in one forward scan
+static bool replace_scan(replace_matches *m, const char *s, size_t len,
+                         const char *from, size_t from_len, size_t max) {
+  m->at = m->stack;
+  m->n = 0;
+  m->cap = REPLACE_STACK_MATCHES;
+
+  if (from_len == 0) {
+    return true;
+  }
+
+  struct __s_needle needle;
+  needle_set(&needle, from, from_len, false);
+
+  size_t offset = 0;
+  ssize_t idx;
+
+  while (m->n < max &&
+         (idx = needle_search(&needle, s + offset, len - offset)) >= 0) {
+    if (m->n == m->cap && !replace_matches_grow(m)) {
+      replace_matches_free(m);
+      return false;
+    }
+
+    m->at[m->n++] = offset + idx;
+    offset += idx + from_len;
+  }
+
+  return true;
+}
+
+static size_t replace_len(replace_matches *m, size_t len, size_t from_len,
+                          size_t to_len) {
+  return len - m->n * from_len + m->n * to_len;
+}
+
+// Writes `s` with every match replaced into `dst`, which must have room for
+// replace_len bytes
+static void replace_write(char *dst, replace_matches *m, const char *s,
+                          size_t len, size_t from_len, const char *to,
+                          size_t to_len) {
+  size_t prev = 0;
+
+  for (size_t i = 0; i < m->n; i++) {
+    memcpy(dst, s + prev, m->at[i] - prev);
+    dst += m->at[i] - prev;
+    memcpy(dst, to, to_len);
+    dst += to_len;
+    prev = m->at[i] + from_len;
+  }
+
+  memcpy(dst, s + prev, len - prev);
+}
+
+static char *replace(const char *s, const char *from, const char *to,
+                     size_t max) {
+  if (s == NULL || from == NULL || to == NULL) {
+    return NULL;
+  }
+
+  size_t len = strlen(s);
+  size_t from_len = strlen(from);
+  size_t to_len = strlen(to);
+
+  replace_matches m;
+  if (!replace_scan(&m, s, len, from, from_len, max)) {
+    return NULL;
+  }
+
+  size_t out_len = replace_len(&m, len, from_len, to_len);
+  char *ret = malloc(out_len + 1);
+  if (ret) {
+    replace_write(ret, &m, s, len, from_len, to, to_len);
+    ret[out_len] = '\0';
+  }
+
+  replace_matches_free(&m);
+
+  return ret;
+}
+
+char *s_replace(const char *s, const char *from, const char *to) {
+  return replace(s, from, to, 1);
+}
+
+char *s_replace_all(const char *s, const char *from, const char *to) {
+  return replace(s, from, to, SIZE_MAX);
+}
+
+bool buffer_append_replaced(buffer_t *buf, const char *s, size_t len,
+                            const char *from, const char *to) {
+  if ((s == NULL && len > 0) || from == NULL || to == NULL) {
+    return false;
+  }
+
+  if (len == 0) {
+    return true;
+  }
+
+  size_t from_len = strlen(from);
+  size_t to_len = strlen(to);
+
+  replace_matches m;
+  if (!replace_scan(&m, s, len, from, from_len, SIZE_MAX)) {
+    return false;
+  }
+
+  size_t out_len = replace_len(&m, len, from_len, to_len);
+  bool ok = buffer_reserve(buf, out_len);
+
+  if (ok) {
+    __buffer_t *unwrapped = (__buffer_t *)buf;
+    replace_write(unwrapped->state + unwrapped->len, &m, s, len, from_len, to,
+                  to_len);
+    unwrapped->len += out_len;
+    unwrapped->state[unwrapped->len] = '\0';
+  }
+
+  replace_matches_free(&m);
+
+  return ok;
+}
+
+s_needle_t *s_needle_init(const char *target, size_t len) {
+  if (target == NULL && len > 0) {
+    return NULL;
+  }
+
+  s_needle_t *needle = malloc(sizeof(s_needle_t));
+  if (!needle) {
+    return NULL;
+  }
+
+  // One spare byte so an empty needle still gets a distinct allocation
+  char *copy = malloc(len + 1);
+  if (!copy) {
+    free(needle);
+    return NULL;
+  }
+
+  if (len > 0) {
+    memcpy(copy, target, len);
+  }
+  needle_set(needle, copy, len, false);
+
+  return needle;
+}
+
+ssize_t s_needle_find(s_needle_t *needle, const char *s, size_t len) {
+  if (s == NULL && len > 0) {
+    return -1;
+  }
+
+  return needle_search(needle, s, len);
+}
+
+size_t s_needle_len(s_needle_t *needle) { return needle->len; }
+
+void s_needle_free(s_needle_t *needle) {
+  if (!needle) {
+    return;
+  }
+
+  free(needle->ptr);
+  free(needle);
+}
@@ -0,0 +1,133 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libutil.h"
+
+struct __shared_buffer {
+  atomic_size_t refs;
+  size_t len;
+  size_t cap;
+  char state[];
+};
+
+static shared_buffer_t *shared_buffer_alloc(const char *data, size_t len,
+                                            size_t cap) {
+  shared_buffer_t *sb = malloc(sizeof(shared_buffer_t) + cap + 1);
+  if (!sb) {
+    return NULL;
+  }
+
+  atomic_init(&sb->refs, 1);
+  sb->len = len;
+  sb->cap = cap;
+
+  if (len) {
+    memcpy(sb->state, data, len);
+  }
+  sb->state[len] = '\0';
+
+  return sb;
+}
+
+// Whether the caller's reference is the only one. The acquire pairs with the
+// release in shared_buffer_release so that we observe other holders' final
+// reads as complete before writing
+static bool shared_buffer_is_unique(shared_buffer_t *sb) {
+  return atomic_load_explicit(&sb->refs, memory_order_acquire) == 1;
+}
+
+shared_buffer_t *shared_buffer_init(const char *data, size_t len) {
+  if (!data && len > 0) {
+    return NULL;
+  }
+
+  return shared_buffer_alloc(data, len, len);
+}
+
+shared_buffer_t *shared_buffer_from_buffer(buffer_t *buf) {
+  return shared_buffer_init(buffer_state(buf), buffer_size(buf));
+}
+
+shared_buffer_t *shared_buffer_retain(shared_buffer_t *sb) {
+  // A new reference can only be made from an existing one, so no ordering is
+  // needed on the increment itself
+  atomic_fetch_add_explicit(&sb->refs, 1, memory_order_relaxed);
+  return sb;
+}
+
+void shared_buffer_release(shared_buffer_t *sb) {
+  if (!sb) {
+    return;
+  }
+
+  if (atomic_fetch_sub_explicit(&sb->refs, 1, memory_order_release) == 1) {
+    atomic_thread_fence(memory_order_acquire);
+    free(sb);
+  }
+}
+
+size_t shared_buffer_size(shared_buffer_t *sb) { return sb->len; }
+
+const char *shared_buffer_state(shared_buffer_t *sb) { return sb->state; }
+
+size_t shared_buffer_refcount(shared_buffer_t *sb) {
+  return atomic_load_explicit(&sb->refs, memory_order_relaxed);
+}
+
+char *shared_buffer_mut(shared_buffer_t **sb) {
+  shared_buffer_t *current = *sb;
+
+  if (!shared_buffer_is_unique(current)) {
+    shared_buffer_t *copy =
+        shared_buffer_alloc(current->state, current->len, current->len);
+    if (!copy) {
+      return NULL;
+    }
+
+    shared_buffer_release(current);
+    *sb = current = copy;
+  }
+
+  return current->state;
+}
+
+bool shared_buffer_append(shared_buffer_t **sb, const char *s, size_t len) {
+  shared_buffer_t *current = *sb;
+  size_t needed = current->len + len;
+
+  if (needed < current->len) {
+    return false;
+  }
+
+  if (!shared_buffer_is_unique(current)) {
+    shared_buffer_t *copy =
+        shared_buffer_alloc(current->state, current->len, needed);
+    if (!copy) {
+      return false;
+    }
+
+    shared_buffer_release(current);
+    *sb = current = copy;
+  } else if (needed > current->cap) {
+    size_t next_cap = current->cap * 2;
+    if (next_cap < needed) {
+      next_cap = needed;
+    }
+
+    shared_buffer_t *next =
+        realloc(current, sizeof(shared_buffer_t) + next_cap + 1);
+    if (!next) {
+      return false;
+    }
+
+    next->cap = next_cap;
+    *sb = current = next;
+  }
+
+  memcpy(&current->state[current->len], s, len);
+  current->len = needed;
+  current->state[needed] = '\0';
+
+  return true;
+}
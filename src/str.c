@@ -1,16 +1,10 @@
-#include <ctype.h>  // for toupper
 #include <stdarg.h>
 #include <stdio.h>  // for snprintf
 #include <stdlib.h>
 #include <string.h>
-#include <strings.h>  // for strncasecmp
 
 #include "libutil.h"
 
-static bool is_ascii_space(char b) {
-  return b == ' ' || b == '\t' || b == '\n' || b == '\r';
-}
-
 char *s_truncate(const char *s, ssize_t n) {
   size_t full_len = strlen(s);
   size_t trunclen = abs((int)n);
@@ -37,13 +31,61 @@ char *s_truncate(const char *s, ssize_t n) {
 }
 
 char *s_concat(const char *s1, const char *s2) {
-  size_t size = strlen(s1) + strlen(s1) + 2;
-  char *ret = malloc(size);
+  size_t len1 = strlen(s1);
+  size_t len2 = strlen(s2);
+
+  char *ret = malloc(len1 + len2 + 1);
   if (!ret) {
     return NULL;
   }
 
-  snprintf(ret, size, "%s%s", s1, s2);
+  memcpy(ret, s1, len1);
+  memcpy(ret + len1, s2, len2 + 1);
+
+  return ret;
+}
+
+// Up to this many piece lengths are kept on the stack while joining
+#define JOIN_STACK_LENS 64
+
+// Joins `n` strings, measuring each once to size the output and copying each
+// by the length measured. NULL strings are joined as empty ones
+static char *join(char *const *strs, size_t n, const char *delimiter) {
+  size_t stack_lens[JOIN_STACK_LENS];
+  size_t *lens =
+      n <= JOIN_STACK_LENS ? stack_lens : malloc(n * sizeof(size_t));
+  if (!lens) {
+    return NULL;
+  }
+
+  size_t delimiter_len = delimiter ? strlen(delimiter) : 0;
+  size_t total = n > 0 ? (n - 1) * delimiter_len : 0;
+
+  for (size_t i = 0; i < n; i++) {
+    lens[i] = strs[i] ? strlen(strs[i]) : 0;
+    total += lens[i];
+  }
+
+  char *ret = malloc(total + 1);
+  if (ret) {
+    char *end = ret;
+    for (size_t i = 0; i < n; i++) {
+      if (i > 0 && delimiter_len) {
+        memcpy(end, delimiter, delimiter_len);
+        end += delimiter_len;
+      }
+
+      if (lens[i]) {
+        memcpy(end, strs[i], lens[i]);
+        end += lens[i];
+      }
+    }
+    *end = '\0';
+  }
+
+  if (lens != stack_lens) {
+    free(lens);
+  }
 
   return ret;
 }
@@ -53,33 +95,98 @@ char *s_concat_arr(char **arr, const char *delimiter) {
     return NULL;
   }
 
-  size_t delimiter_len = strlen(delimiter);
-  size_t total_length = 0;
-  size_t num_strings = 0;
+  size_t n = 0;
+  while (arr[n] != NULL) {
+    n++;
+  }
+
+  return join(arr, n, delimiter);
+}
+
+char *s_join(array_t *arr, const char *delimiter) {
+  if (arr == NULL) {
+    return NULL;
+  }
+
+  return join((char *const *)((__array_t *)arr)->state, array_size(arr),
+              delimiter);
+}
+
+char *s_join_views(const sv_t *views, size_t n, const char *delimiter) {
+  if (views == NULL && n > 0) {
+    return NULL;
+  }
+
+  // The views' lengths are already known, so nothing is measured but the
+  // delimiter
+  size_t delimiter_len = delimiter ? strlen(delimiter) : 0;
+  size_t total = n > 0 ? (n - 1) * delimiter_len : 0;
+
+  for (size_t i = 0; i < n; i++) {
+    total += views[i].len;
+  }
+
+  char *ret = malloc(total + 1);
+  if (!ret) {
+    return NULL;
+  }
+
+  char *end = ret;
+  for (size_t i = 0; i < n; i++) {
+    if (i > 0 && delimiter_len) {
+      memcpy(end, delimiter, delimiter_len);
+      end += delimiter_len;
+    }
+
+    if (views[i].len > 0) {
+      memcpy(end, views[i].ptr, views[i].len);
+      end += views[i].len;
+    }
+  }
+  *end = '\0';
+
+  return ret;
+}
 
-  for (char **ptr = arr; *ptr != NULL; ptr++) {
-    total_length += strlen(*ptr);
-    num_strings++;
+char *s_concat_n(size_t n, ...) {
+  size_t stack_lens[JOIN_STACK_LENS];
+  size_t *lens =
+      n <= JOIN_STACK_LENS ? stack_lens : malloc(n * sizeof(size_t));
+  if (!lens) {
+    return NULL;
   }
-  total_length += (num_strings - 1) * delimiter_len;
 
-  char *result = malloc(total_length + 1);
-  char *current = result;
+  va_list args;
+  size_t total = 0;
 
-  for (char **ptr = arr; *ptr != NULL; ptr++) {
-    size_t len = strlen(*ptr);
-    memcpy(current, *ptr, len);
-    current += len;
+  va_start(args, n);
+  for (size_t i = 0; i < n; i++) {
+    const char *s = va_arg(args, const char *);
+    lens[i] = s ? strlen(s) : 0;
+    total += lens[i];
+  }
+  va_end(args);
 
-    if (*(ptr + 1) != NULL) {
-      memcpy(current, delimiter, delimiter_len);
-      current += delimiter_len;
+  char *ret = malloc(total + 1);
+  if (ret) {
+    char *end = ret;
+    va_start(args, n);
+    for (size_t i = 0; i < n; i++) {
+      const char *s = va_arg(args, const char *);
+      if (lens[i]) {
+        memcpy(end, s, lens[i]);
+        end += lens[i];
+      }
     }
+    va_end(args);
+    *end = '\0';
   }
 
-  *current = '\0';
+  if (lens != stack_lens) {
+    free(lens);
+  }
 
-  return result;
+  return ret;
 }
 
 char *s_copy(const char *s) {
@@ -102,12 +209,7 @@ ssize_t s_indexof(const char *s, const char *target) {
     return -1;
   }
 
-  char *needle = strstr(s, target);
-  if (needle == NULL) {
-    return -1;
-  }
-
-  return needle - s;
+  return s_indexof_n(s, strlen(s), target, strlen(target));
 }
 
 char *s_substr(const char *s, size_t start, ssize_t end, bool inclusive) {
@@ -148,33 +250,12 @@ char *s_substr(const char *s, size_t start, ssize_t end, bool inclusive) {
 }
 
 bool s_casecmp(const char *s1, const char *s2) {
-  size_t s1l = strlen(s1);
-  size_t s2l = strlen(s2);
-
-  size_t compare_chars = s1l > s2l ? s1l : s2l;
-  return strncasecmp(s1, s2, compare_chars) == 0;
-}
-
-char *s_upper(const char *s) {
-  size_t l = strlen(s);
-
-  char *ca = malloc(l + 1);
-  if (!ca) {
-    return NULL;
-  }
-
-  strncpy(ca, s, l);
-  ca[l] = '\0';
-
-  for (size_t i = 0; i < l; i++) {
-    ca[i] = toupper(s[i]);
-  }
-
-  return ca;
+  return s_casecmp_n(s1, strlen(s1), s2, strlen(s2));
 }
 
 bool s_equals(const char *s1, const char *s2) {
-  if (!s1 && !s2)
+  // Catches interned strings, and NULL compared with NULL, without a strcmp
+  if (s1 == s2)
     return true;
   else if (!s1)
     return false;
@@ -187,21 +268,23 @@ bool s_equals(const char *s1, const char *s2) {
 bool s_nullish(const char *s) { return s == NULL || s_equals(s, ""); }
 
 char *s_trim(const char *s) {
-  char *scp = s_copy(s);
-
-  while (strlen(scp) > 0 && is_ascii_space(scp[0])) {
-    char *nscp = s_substr(scp, 1, strlen(scp), true);
-    free(scp);
-    scp = nscp;
+  if (!s) {
+    return NULL;
   }
 
-  while (strlen(scp) > 0 && is_ascii_space(scp[strlen(scp) - 1])) {
-    char *nscp = s_substr(scp, 0, strlen(scp) - 1, false);
-    free(scp);
-    scp = nscp;
+  return sv_to_owned(sv_trim(sv_from(s)));
+}
+
+char *s_trim_inplace(char *s) {
+  if (!s) {
+    return NULL;
   }
 
-  return scp;
+  sv_t trimmed = sv_trim(sv_from(s));
+  memmove(s, trimmed.ptr, trimmed.len);
+  s[trimmed.len] = '\0';
+
+  return s;
 }
 
 array_t *s_split(const char *s, const char *delim) {
@@ -209,61 +292,89 @@ array_t *s_split(const char *s, const char *delim) {
     return NULL;
   }
 
-  // see:
-  // https://wiki.sei.cmu.edu/confluence/display/c/STR06-C.+Do+not+assume+that+strtok%28%29+leaves+the+parse+string+unchanged
-  char *input = s_copy(s);
-
   array_t *tokens = array_init();
   if (tokens == NULL) {
-    free(input);
     return NULL;
   }
 
+  sv_t input = sv_from(s);
+  sv_t delim_sv = sv_from(delim);
+
   // If the input doesn't even contain the delimiter, return early and avoid
   // further computation
-  if (!strstr(input, delim)) {
-    free(input);
+  if (delim_sv.len == 0 || sv_indexof(input, delim_sv) < 0) {
     return tokens;
   }
 
-  // If the input *is* the delimiter, just return the empty array
-  if (s_equals(input, delim)) {
-    free(input);
-    return tokens;
+  sv_tokenizer_t tokenizer = sv_tokenizer_init(input, delim_sv, false);
+  sv_t token;
+
+  while (sv_tokenizer_next(&tokenizer, &token)) {
+    char *owned = sv_to_owned(token);
+    if (!owned || !array_push(tokens, owned)) {
+      free(owned);
+      array_free(tokens, free);
+      return NULL;
+    }
   }
 
-  char *token = strtok(input, delim);
-  if (token == NULL) {
-    free(input);
-    return tokens;
+  return tokens;
+}
+
+// Formats into `scratch` if the output fits, and otherwise into a new
+// allocation of its exact size, which is then returned. Stores the output's
+// length in `len`
+static char *fmt_into(char *scratch, size_t cap, size_t *len, const char *fmt,
+                      va_list args) {
+  va_list args_cp;
+  va_copy(args_cp, args);
+
+  int n = vsnprintf(scratch, cap, fmt, args);
+  if (n < 0) {
+    va_end(args_cp);
+    return NULL;
   }
 
-  while (token != NULL) {
-    array_push(tokens, s_copy(token));
-    token = strtok(NULL, delim);
+  *len = n;
+  if ((size_t)n < cap) {
+    va_end(args_cp);
+    return scratch;
   }
 
-  free(input);
+  char *ret = malloc((size_t)n + 1);
+  if (ret) {
+    vsnprintf(ret, (size_t)n + 1, fmt, args_cp);
+  }
+  va_end(args_cp);
 
-  return tokens;
+  return ret;
 }
 
 char *s_fmt(char *fmt, ...) {
-  va_list args, args_cp;
+  char scratch[LIB_UTIL_FMT_SCRATCH_SZ];
+  size_t len;
+  va_list args;
+
   va_start(args, fmt);
-  va_copy(args_cp, args);
+  char *ret = fmt_into(scratch, sizeof(scratch), &len, fmt, args);
+  va_end(args);
 
-  // Pass length of zero first to determine number of bytes needed
-  size_t n = vsnprintf(NULL, 0, fmt, args) + 1;
-  char *buf = malloc(n);
-  if (!buf) {
-    return NULL;
+  // Short outputs were formatted once, into the scratch, and only need
+  // copying out of it
+  if (ret == scratch && (ret = malloc(len + 1))) {
+    memcpy(ret, scratch, len + 1);
   }
 
-  vsnprintf(buf, n, fmt, args_cp);
+  return ret;
+}
 
+char *s_fmt_into(char *buf, size_t cap, const char *fmt, ...) {
+  size_t len;
+  va_list args;
+
+  va_start(args, fmt);
+  char *ret = fmt_into(buf, cap, &len, fmt, args);
   va_end(args);
-  va_end(args_cp);
 
-  return buf;
+  return ret;
 }
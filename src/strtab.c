@@ -0,0 +1,361 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libutil.h"
+
+#define STRTAB_INITIAL_STRINGS 16
+#define STRTAB_INITIAL_BYTES 256
+
+// Strings are stored back to back in `blob`, each followed by a NUL. The
+// extra entry at the end of `offsets` marks where the next string would start,
+// so the length of string i is offsets[i + 1] - offsets[i] - 1
+struct __strtab {
+  char *blob;
+  size_t blob_len;
+  size_t blob_cap;
+  size_t *offsets;
+  size_t size;
+  size_t offsets_cap;
+};
+
+strtab_t *strtab_init(void) {
+  strtab_t *tab = malloc(sizeof(strtab_t));
+  if (!tab) {
+    return NULL;
+  }
+
+  tab->blob = malloc(STRTAB_INITIAL_BYTES);
+  tab->offsets = malloc((STRTAB_INITIAL_STRINGS + 1) * sizeof(size_t));
+  if (!tab->blob || !tab->offsets) {
+    free(tab->blob);
+    free(tab->offsets);
+    free(tab);
+    return NULL;
+  }
+
+  tab->blob_len = 0;
+  tab->blob_cap = STRTAB_INITIAL_BYTES;
+  tab->size = 0;
+  tab->offsets_cap = STRTAB_INITIAL_STRINGS;
+  tab->offsets[0] = 0;
+
+  return tab;
+}
+
+bool strtab_reserve(strtab_t *tab, size_t n_strings, size_t n_bytes) {
+  // Each string also needs room for its NUL
+  size_t bytes_needed = tab->blob_len + n_bytes + n_strings;
+  size_t strings_needed = tab->size + n_strings;
+
+  if (bytes_needed < tab->blob_len || strings_needed < tab->size) {
+    return false;
+  }
+
+  if (bytes_needed > tab->blob_cap) {
+    size_t next_cap = tab->blob_cap * 2;
+    if (next_cap < bytes_needed) {
+      next_cap = bytes_needed;
+    }
+
+    char *next = realloc(tab->blob, next_cap);
+    if (!next) {
+      return false;
+    }
+
+    tab->blob = next;
+    tab->blob_cap = next_cap;
+  }
+
+  if (strings_needed > tab->offsets_cap) {
+    size_t next_cap = tab->offsets_cap * 2;
+    if (next_cap < strings_needed) {
+      next_cap = strings_needed;
+    }
+
+    size_t *next = realloc(tab->offsets, (next_cap + 1) * sizeof(size_t));
+    if (!next) {
+      return false;
+    }
+
+    tab->offsets = next;
+    tab->offsets_cap = next_cap;
+  }
+
+  return true;
+}
+
+bool strtab_push(strtab_t *tab, const char *s, size_t len) {
+  if ((!s && len > 0) || !strtab_reserve(tab, 1, len)) {
+    return false;
+  }
+
+  if (len > 0) {
+    memcpy(tab->blob + tab->blob_len, s, len);
+  }
+  tab->blob_len += len;
+  tab->blob[tab->blob_len++] = '\0';
+  tab->offsets[++tab->size] = tab->blob_len;
+
+  return true;
+}
+
+bool strtab_append(strtab_t *tab, strtab_t *other) {
+  if (!strtab_reserve(tab, other->size, other->blob_len - other->size)) {
+    return false;
+  }
+
+  memcpy(tab->blob + tab->blob_len, other->blob, other->blob_len);
+  for (size_t i = 1; i <= other->size; i++) {
+    tab->offsets[tab->size + i] = tab->blob_len + other->offsets[i];
+  }
+
+  tab->blob_len += other->blob_len;
+  tab->size += other->size;
+
+  return true;
+}
+
+size_t strtab_size(strtab_t *tab) { return tab->size; }
+
+const char *strtab_get(strtab_t *tab, size_t index) {
+  if (index >= tab->size) {
+    return NULL;
+  }
+
+  return tab->blob + tab->offsets[index];
+}
+
+sv_t strtab_get_sv(strtab_t *tab, size_t index) {
+  if (index >= tab->size) {
+    return sv_from_n(NULL, 0);
+  }
+
+  return sv_from_n(tab->blob + tab->offsets[index],
+                   tab->offsets[index + 1] - tab->offsets[index] - 1);
+}
+
+array_t *strtab_to_array(strtab_t *tab) {
+  array_t *array = array_init();
+  if (!array) {
+    return NULL;
+  }
+
+  __array_t *unwrapped = (__array_t *)array;
+  if (tab->size > 0) {
+    void **state = realloc(unwrapped->state, tab->size * sizeof(void *));
+    if (!state) {
+      array_free(array, NULL);
+      return NULL;
+    }
+
+    unwrapped->state = state;
+    unwrapped->capacity = tab->size;
+  }
+
+  for (size_t i = 0; i < tab->size; i++) {
+    unwrapped->state[i] = tab->blob + tab->offsets[i];
+  }
+  unwrapped->size = tab->size;
+
+  return array;
+}
+
+void strtab_free(strtab_t *tab) {
+  if (!tab) {
+    return;
+  }
+
+  free(tab->blob);
+  free(tab->offsets);
+  free(tab);
+}
+
+strtab_t *sv_split_table(sv_t input, sv_t delim, bool keep_empty) {
+  strtab_t *tab = strtab_init();
+  if (!tab) {
+    return NULL;
+  }
+
+  // Every token fits in the input's own length, so one reservation covers
+  // the blob up front
+  if (!strtab_reserve(tab, 0, input.len)) {
+    strtab_free(tab);
+    return NULL;
+  }
+
+  sv_tokenizer_t tokenizer = sv_tokenizer_init(input, delim, keep_empty);
+  sv_t token;
+
+  while (sv_tokenizer_next(&tokenizer, &token)) {
+    if (!strtab_push(tab, token.ptr, token.len)) {
+      strtab_free(tab);
+      return NULL;
+    }
+  }
+
+  return tab;
+}
+
+strtab_t *s_split_table(const char *s, const char *delim) {
+  if (s == NULL || delim == NULL) {
+    return NULL;
+  }
+
+  sv_t input = sv_from(s);
+  sv_t delim_sv = sv_from(delim);
+
+  // Matches s_split: no tokens at all unless the delimiter occurs
+  if (delim_sv.len == 0 || sv_indexof(input, delim_sv) < 0) {
+    return strtab_init();
+  }
+
+  return sv_split_table(input, delim_sv, false);
+}
+
+typedef struct {
+  sv_t input;
+  sv_t delim;
+  bool keep_empty;
+  strtab_t *result;
+} par_split_chunk;
+
+static void *par_split_worker(void *arg) {
+  par_split_chunk *chunk = arg;
+  chunk->result =
+      sv_split_table(chunk->input, chunk->delim, chunk->keep_empty);
+  return NULL;
+}
+
+// Whether some proper prefix of `delim` is also a suffix, as in "aa" or
+// "abab". Occurrences of such a delimiter can overlap, so one found by
+// searching from an arbitrary position might not be one a left-to-right
+// split would use
+static bool delim_self_overlaps(sv_t delim) {
+  for (size_t k = 1; k < delim.len; k++) {
+    if (!memcmp(delim.ptr, delim.ptr + delim.len - k, k)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+strtab_t *sv_par_split(sv_t input, sv_t delim, bool keep_empty,
+                       size_t n_threads) {
+  if (n_threads == 0) {
+    long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    n_threads = n_cpus > 0 ? n_cpus : 1;
+  }
+
+  if (n_threads > input.len / LIB_UTIL_PAR_SPLIT_MIN_CHUNK) {
+    n_threads = input.len / LIB_UTIL_PAR_SPLIT_MIN_CHUNK;
+  }
+
+  if (n_threads <= 1 || delim.len == 0 || delim_self_overlaps(delim)) {
+    return sv_split_table(input, delim, keep_empty);
+  }
+
+  par_split_chunk *chunks = calloc(n_threads, sizeof(par_split_chunk));
+  pthread_t *threads = calloc(n_threads, sizeof(pthread_t));
+  bool *started = calloc(n_threads, sizeof(bool));
+  strtab_t *ret = NULL;
+  size_t n_chunks = 0;
+
+  if (!chunks || !threads || !started) {
+    goto done;
+  }
+
+  // Cut the input just after the first delimiter at or past each even share.
+  // A share with no delimiter in it is merged into its neighbor
+  size_t start = 0;
+  for (size_t i = 1; i <= n_threads && start <= input.len; i++) {
+    size_t end = input.len;
+    size_t next = input.len + 1;
+
+    if (i < n_threads) {
+      size_t target = input.len / n_threads * i;
+      if (target < start) {
+        target = start;
+      }
+
+      ssize_t idx = sv_indexof(sv_substr(input, target, input.len), delim);
+      if (idx < 0) {
+        i = n_threads;
+      } else {
+        end = target + idx;
+        next = end + delim.len;
+      }
+    }
+
+    chunks[n_chunks].input = sv_substr(input, start, end);
+    chunks[n_chunks].delim = delim;
+    chunks[n_chunks].keep_empty = keep_empty;
+    n_chunks++;
+
+    start = next;
+  }
+
+  // The calling thread takes the first chunk itself
+  for (size_t i = 1; i < n_chunks; i++) {
+    started[i] =
+        pthread_create(&threads[i], NULL, par_split_worker, &chunks[i]) == 0;
+  }
+
+  for (size_t i = 0; i < n_chunks; i++) {
+    if (!started[i]) {
+      par_split_worker(&chunks[i]);
+    }
+  }
+
+  for (size_t i = 1; i < n_chunks; i++) {
+    if (started[i]) {
+      pthread_join(threads[i], NULL);
+    }
+  }
+
+  bool ok = true;
+  for (size_t i = 0; i < n_chunks; i++) {
+    ok = ok && chunks[i].result;
+  }
+
+  if (ok) {
+    // The first chunk's table becomes the result, so its bytes aren't copied
+    ret = chunks[0].result;
+    chunks[0].result = NULL;
+
+    for (size_t i = 1; i < n_chunks && ret; i++) {
+      if (!strtab_append(ret, chunks[i].result)) {
+        strtab_free(ret);
+        ret = NULL;
+      }
+    }
+  }
+
+done:
+  for (size_t i = 0; chunks && i < n_chunks; i++) {
+    strtab_free(chunks[i].result);
+  }
+
+  free(chunks);
+  free(threads);
+  free(started);
+
+  return ret;
+}
+
+strtab_t *s_par_split(const char *s, const char *delim, size_t n_threads) {
+  if (s == NULL || delim == NULL) {
+    return NULL;
+  }
+
+  sv_t input = sv_from(s);
+  sv_t delim_sv = sv_from(delim);
+
+  if (delim_sv.len == 0 || sv_indexof(input, delim_sv) < 0) {
+    return strtab_init();
+  }
+
+  return sv_par_split(input, delim_sv, false, n_threads);
+}
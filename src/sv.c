@@ -0,0 +1,118 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "libutil.h"
+
+static bool is_ascii_space(char b) {
+  return b == ' ' || b == '\t' || b == '\n' || b == '\r';
+}
+
+sv_t sv_from(const char *s) {
+  return sv_from_n(s, s ? strlen(s) : 0);
+}
+
+sv_t sv_from_n(const char *s, size_t len) {
+  sv_t sv = {.ptr = s, .len = len};
+  return sv;
+}
+
+sv_t sv_from_buffer(buffer_t *buf) {
+  return sv_from_n(buffer_state(buf), buffer_size(buf));
+}
+
+sv_t sv_trim_left(sv_t sv) {
+  while (sv.len > 0 && is_ascii_space(*sv.ptr)) {
+    sv.ptr++;
+    sv.len--;
+  }
+
+  return sv;
+}
+
+sv_t sv_trim_right(sv_t sv) {
+  while (sv.len > 0 && is_ascii_space(sv.ptr[sv.len - 1])) {
+    sv.len--;
+  }
+
+  return sv;
+}
+
+sv_t sv_trim(sv_t sv) { return sv_trim_right(sv_trim_left(sv)); }
+
+sv_t sv_substr(sv_t sv, size_t start, size_t end) {
+  if (end > sv.len) {
+    end = sv.len;
+  }
+
+  if (start > end) {
+    start = end;
+  }
+
+  return sv_from_n(sv.ptr + start, end - start);
+}
+
+ssize_t sv_indexof(sv_t sv, sv_t target) {
+  return s_indexof_n(sv.ptr, sv.len, target.ptr, target.len);
+}
+
+ssize_t sv_indexof_case(sv_t sv, sv_t target) {
+  return s_indexof_case_n(sv.ptr, sv.len, target.ptr, target.len);
+}
+
+bool sv_split_next(sv_t *input, sv_t delim, sv_t *token) {
+  // A NULL pointer marks an input whose final token was already returned
+  if (!input->ptr) {
+    return false;
+  }
+
+  ssize_t idx = delim.len > 0 ? sv_indexof(*input, delim) : -1;
+  if (idx < 0) {
+    *token = *input;
+    *input = sv_from_n(NULL, 0);
+    return true;
+  }
+
+  *token = sv_from_n(input->ptr, idx);
+  input->ptr += idx + delim.len;
+  input->len -= idx + delim.len;
+
+  return true;
+}
+
+sv_tokenizer_t sv_tokenizer_init(sv_t input, sv_t delim, bool keep_empty) {
+  sv_tokenizer_t tokenizer = {
+      .rest = input, .delim = delim, .keep_empty = keep_empty};
+  return tokenizer;
+}
+
+bool sv_tokenizer_next(sv_tokenizer_t *tokenizer, sv_t *token) {
+  while (sv_split_next(&tokenizer->rest, tokenizer->delim, token)) {
+    if (tokenizer->keep_empty || token->len > 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool sv_equals(sv_t s1, sv_t s2) {
+  return s1.len == s2.len && (s1.len == 0 || !memcmp(s1.ptr, s2.ptr, s1.len));
+}
+
+bool sv_casecmp(sv_t s1, sv_t s2) {
+  return s_casecmp_n(s1.ptr, s1.len, s2.ptr, s2.len);
+}
+
+char *sv_to_owned(sv_t sv) {
+  char *ret = malloc(sv.len + 1);
+  if (!ret) {
+    return NULL;
+  }
+
+  if (sv.len > 0) {
+    memcpy(ret, sv.ptr, sv.len);
+  }
+  ret[sv.len] = '\0';
+
+  return ret;
+}
@@ -0,0 +1,403 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libutil.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define UTF8_X86 1
+#include <immintrin.h>
+#endif
+
+#define UTF8_ONES 0x0101010101010101ULL
+
+static bool utf8_is_continuation(unsigned char c) { return (c & 0xc0) == 0x80; }
+
+// Vector kernels validate as many whole blocks as they can and return the
+// number of bytes they covered, setting `valid` to false on finding any error.
+// A sequence that runs past the last block is left for the scalar code
+typedef size_t utf8_kernel(const unsigned char *s, size_t len, bool *valid);
+
+#ifdef UTF8_X86
+
+// The lookup algorithm of Keiser and Lemire, "Validating UTF-8 In Less Than
+// One Instruction Per Byte" (2021), as used by simdjson. Each byte and its
+// predecessor are classified by three 16-entry table lookups, on the high and
+// low nibbles of the first and the high nibble of the second, whose results
+// are ANDed together: each bit that survives is one kind of error
+#define UTF8_TOO_SHORT (1 << 0)   // Lead byte not followed by a continuation
+#define UTF8_TOO_LONG (1 << 1)    // ASCII followed by a continuation
+#define UTF8_OVERLONG_3 (1 << 2)  // 11100000 100_____
+#define UTF8_TOO_LARGE (1 << 3)   // Above U+10FFFF
+#define UTF8_SURROGATE (1 << 4)   // 11101101 101_____
+#define UTF8_OVERLONG_2 (1 << 5)  // 1100000_ 10______
+#define UTF8_TOO_LARGE_1000 (1 << 6)
+#define UTF8_OVERLONG_4 (1 << 6)  // 11110000 1000____
+#define UTF8_TWO_CONTS (1 << 7)   // Continuation following a continuation
+#define UTF8_CARRY (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+// Indexed by the high nibble of the first byte
+static const uint8_t utf8_byte_1_high[16] = {
+    UTF8_TOO_LONG,
+    UTF8_TOO_LONG,
+    UTF8_TOO_LONG,
+    UTF8_TOO_LONG,
+    UTF8_TOO_LONG,
+    UTF8_TOO_LONG,
+    UTF8_TOO_LONG,
+    UTF8_TOO_LONG,
+    UTF8_TWO_CONTS,
+    UTF8_TWO_CONTS,
+    UTF8_TWO_CONTS,
+    UTF8_TWO_CONTS,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+    UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+};
+
+// Indexed by the low nibble of the first byte
+static const uint8_t utf8_byte_1_low[16] = {
+    UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+    UTF8_CARRY | UTF8_OVERLONG_2,
+    UTF8_CARRY,
+    UTF8_CARRY,
+    UTF8_CARRY | UTF8_TOO_LARGE,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+};
+
+// Indexed by the high nibble of the second byte
+static const uint8_t utf8_byte_2_high[16] = {
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 |
+        UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 |
+        UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE |
+        UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE |
+        UTF8_TOO_LARGE,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+};
+
+// A block ends partway through a sequence if one of its last three bytes is a
+// lead byte too long to have finished: subtracting these with saturation
+// leaves a nonzero byte exactly there
+static const uint8_t utf8_incomplete_max[32] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xef, 0xdf, 0xbf,
+};
+
+// Inlined so the tables it loads are hoisted out of the callers' loops
+__attribute__((target("ssse3"), always_inline)) static inline __m128i
+utf8_check_ssse3(__m128i input, __m128i prev) {
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+  __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+
+  __m128i byte_1_high = _mm_shuffle_epi8(
+      _mm_loadu_si128((const __m128i *)utf8_byte_1_high),
+      _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+  __m128i byte_1_low =
+      _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)utf8_byte_1_low),
+                       _mm_and_si128(prev1, nibble));
+  __m128i byte_2_high = _mm_shuffle_epi8(
+      _mm_loadu_si128((const __m128i *)utf8_byte_2_high),
+      _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+  __m128i special =
+      _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+  // The third and fourth bytes of a sequence must be continuations, which
+  // the lookups can't see: they only pair a byte with its predecessor
+  __m128i third = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 14),
+                                _mm_set1_epi8((char)(0xe0 - 0x80)));
+  __m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 13),
+                                 _mm_set1_epi8((char)(0xf0 - 0x80)));
+  __m128i must_continue =
+      _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8((char)0x80));
+
+  return _mm_xor_si128(must_continue, special);
+}
+
+__attribute__((target("ssse3"))) static size_t utf8_validate_ssse3(
+    const unsigned char *s, size_t len, bool *valid) {
+  const __m128i incomplete_max =
+      _mm_loadu_si128((const __m128i *)(utf8_incomplete_max + 16));
+  __m128i prev = _mm_setzero_si128();
+  __m128i err = _mm_setzero_si128();
+  size_t i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    __m128i input = _mm_loadu_si128((const __m128i *)(s + i));
+
+    // An ASCII block is valid unless the one before it left a sequence open
+    if (!_mm_movemask_epi8(input)) {
+      err = _mm_or_si128(err, _mm_subs_epu8(prev, incomplete_max));
+    } else {
+      err = _mm_or_si128(err, utf8_check_ssse3(input, prev));
+    }
+    prev = input;
+  }
+
+  *valid = _mm_movemask_epi8(_mm_cmpeq_epi8(err, _mm_setzero_si128())) ==
+           0xffff;
+
+  return i;
+}
+
+__attribute__((target("avx2"), always_inline)) static inline __m256i
+utf8_check_avx2(__m256i input, __m256i prev) {
+  const __m256i nibble = _mm256_set1_epi8(0x0f);
+
+  // The bytes before each of input's, which straddle the two blocks' lanes
+  __m256i straddle = _mm256_permute2x128_si256(prev, input, 0x21);
+  __m256i prev1 = _mm256_alignr_epi8(input, straddle, 15);
+
+  __m256i byte_1_high = _mm256_shuffle_epi8(
+      _mm256_broadcastsi128_si256(
+          _mm_loadu_si128((const __m128i *)utf8_byte_1_high)),
+      _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+  __m256i byte_1_low = _mm256_shuffle_epi8(
+      _mm256_broadcastsi128_si256(
+          _mm_loadu_si128((const __m128i *)utf8_byte_1_low)),
+      _mm256_and_si256(prev1, nibble));
+  __m256i byte_2_high = _mm256_shuffle_epi8(
+      _mm256_broadcastsi128_si256(
+          _mm_loadu_si128((const __m128i *)utf8_byte_2_high)),
+      _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+  __m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low),
+                                     byte_2_high);
+
+  __m256i third = _mm256_subs_epu8(_mm256_alignr_epi8(input, straddle, 14),
+                                   _mm256_set1_epi8((char)(0xe0 - 0x80)));
+  __m256i fourth = _mm256_subs_epu8(_mm256_alignr_epi8(input, straddle, 13),
+                                    _mm256_set1_epi8((char)(0xf0 - 0x80)));
+  __m256i must_continue = _mm256_and_si256(_mm256_or_si256(third, fourth),
+                                           _mm256_set1_epi8((char)0x80));
+
+  return _mm256_xor_si256(must_continue, special);
+}
+
+__attribute__((target("avx2"))) static size_t utf8_validate_avx2(
+    const unsigned char *s, size_t len, bool *valid) {
+  const __m256i incomplete_max =
+      _mm256_loadu_si256((const __m256i *)utf8_incomplete_max);
+  __m256i prev = _mm256_setzero_si256();
+  __m256i err = _mm256_setzero_si256();
+  size_t i = 0;
+
+  // Payloads are mostly ASCII, so check two blocks at a time for it
+  for (; i + 64 <= len; i += 64) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(s + i));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(s + i + 32));
+
+    if (!_mm256_movemask_epi8(_mm256_or_si256(a, b))) {
+      err = _mm256_or_si256(err, _mm256_subs_epu8(prev, incomplete_max));
+    } else {
+      err = _mm256_or_si256(err, utf8_check_avx2(a, prev));
+      err = _mm256_or_si256(err, utf8_check_avx2(b, a));
+    }
+    prev = b;
+  }
+
+  for (; i + 32 <= len; i += 32) {
+    __m256i input = _mm256_loadu_si256((const __m256i *)(s + i));
+    err = _mm256_or_si256(err, utf8_check_avx2(input, prev));
+    prev = input;
+  }
+
+  *valid = _mm256_testz_si256(err, err);
+
+  return i;
+}
+
+__attribute__((target("avx2"))) static size_t utf8_count_avx2(
+    const unsigned char *s, size_t len, size_t *count) {
+  // Continuation bytes are the only ones below -64 as signed bytes
+  const __m256i continuation_max = _mm256_set1_epi8(-65);
+  size_t i = 0;
+
+  for (; i + 32 <= len; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+    uint32_t leads =
+        _mm256_movemask_epi8(_mm256_cmpgt_epi8(v, continuation_max));
+    *count += __builtin_popcount(leads);
+  }
+
+  return i;
+}
+
+#endif
+
+static utf8_kernel *utf8_validate_kernel(void) {
+#ifdef UTF8_X86
+  if (__builtin_cpu_supports("avx2")) {
+    return utf8_validate_avx2;
+  }
+  if (__builtin_cpu_supports("ssse3")) {
+    return utf8_validate_ssse3;
+  }
+#endif
+  return NULL;
+}
+
+static bool utf8_validate_scalar(const unsigned char *s, size_t len) {
+  size_t i = 0;
+
+  while (i < len) {
+    if (i + 8 <= len) {
+      uint64_t word;
+      memcpy(&word, s + i, 8);
+      if (!(word & (0x80 * UTF8_ONES))) {
+        i += 8;
+        continue;
+      }
+    }
+
+    unsigned char c = s[i];
+    if (c < 0x80) {
+      i++;
+      continue;
+    }
+
+    // The range of the second byte excludes overlong encodings, surrogates
+    // and code points above U+10FFFF
+    size_t n;
+    unsigned char lo = 0x80, hi = 0xbf;
+
+    if (c >= 0xc2 && c <= 0xdf) {
+      n = 1;
+    } else if (c >= 0xe0 && c <= 0xef) {
+      n = 2;
+      lo = c == 0xe0 ? 0xa0 : lo;
+      hi = c == 0xed ? 0x9f : hi;
+    } else if (c >= 0xf0 && c <= 0xf4) {
+      n = 3;
+      lo = c == 0xf0 ? 0x90 : lo;
+      hi = c == 0xf4 ? 0x8f : hi;
+    } else {
+      return false;
+    }
+
+    if (len - i - 1 < n || s[i + 1] < lo || s[i + 1] > hi) {
+      return false;
+    }
+
+    for (size_t k = 2; k <= n; k++) {
+      if (!utf8_is_continuation(s[i + k])) {
+        return false;
+      }
+    }
+
+    i += n + 1;
+  }
+
+  return true;
+}
+
+bool s_utf8_valid(const char *s, size_t len) {
+  if (s == NULL) {
+    return len == 0;
+  }
+
+  const unsigned char *u = (const unsigned char *)s;
+  size_t i = 0;
+
+  utf8_kernel *kernel = utf8_validate_kernel();
+  if (kernel) {
+    bool valid;
+    i = kernel(u, len, &valid);
+    if (!valid) {
+      return false;
+    }
+
+    // Back up to the start of the sequence the last block ended in, which
+    // may continue past it
+    i = i > 0 ? s_utf8_boundary(s, len, i - 1) : 0;
+  }
+
+  return utf8_validate_scalar(u + i, len - i);
+}
+
+size_t s_utf8_len(const char *s, size_t len) {
+  if (s == NULL) {
+    return 0;
+  }
+
+  const unsigned char *u = (const unsigned char *)s;
+  size_t count = 0;
+  size_t i = 0;
+
+#ifdef UTF8_X86
+  if (__builtin_cpu_supports("avx2")) {
+    i = utf8_count_avx2(u, len, &count);
+  }
+#endif
+
+  // A byte is a continuation if its top two bits are 10, so its top bit is
+  // set where its next one, shifted up into place, isn't
+  for (; i + 8 <= len; i += 8) {
+    uint64_t word;
+    memcpy(&word, u + i, 8);
+    count += 8 - __builtin_popcountll(word & ~(word << 1) & (0x80 * UTF8_ONES));
+  }
+
+  for (; i < len; i++) {
+    count += !utf8_is_continuation(u[i]);
+  }
+
+  return count;
+}
+
+size_t s_utf8_boundary(const char *s, size_t len, size_t n) {
+  if (n >= len) {
+    return len;
+  }
+
+  // No sequence is longer than 4 bytes, so stop looking after 3
+  // continuations, which is where an invalid run of them is cut
+  size_t i = n;
+  while (i > 0 && n - i < 3 && utf8_is_continuation(s[i])) {
+    i--;
+  }
+
+  return utf8_is_continuation(s[i]) ? n : i;
+}
+
+char *s_utf8_truncate(const char *s, size_t n) {
+  if (s == NULL) {
+    return NULL;
+  }
+
+  size_t len = s_utf8_boundary(s, strlen(s), n);
+
+  char *ret = malloc(len + 1);
+  if (!ret) {
+    return NULL;
+  }
+
+  memcpy(ret, s, len);
+  ret[len] = '\0';
+
+  return ret;
+}
@@ -0,0 +1,120 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "tests.h"
+
+static void test_buffer_append_fixed(void) {
+  buffer_t *buf = buffer_init(NULL);
+
+  buffer_append_u8(buf, 0xab);
+  buffer_append_u16le(buf, 0x0102);
+  buffer_append_u32le(buf, 0x03040506);
+  buffer_append_u64le(buf, 0x0708090a0b0c0d0eULL);
+
+  const char expected[] = "\xab\x02\x01\x06\x05\x04\x03"
+                          "\x0e\x0d\x0c\x0b\x0a\x09\x08\x07";
+  eq_num(buffer_size(buf), 15, "fixed-width integers occupy their width");
+  ok(!memcmp(buffer_state(buf), expected, 15),
+     "fixed-width integers are written little-endian");
+
+  buffer_free(buf);
+}
+
+static void test_buffer_append_varint(void) {
+  buffer_t *buf = buffer_init(NULL);
+
+  buffer_append_varint(buf, 1);
+  eq_num(buffer_size(buf), 1, "small varints take a single byte");
+
+  buffer_append_varint(buf, 300);
+  ok(!memcmp(buffer_state(buf) + 1, "\xac\x02", 2),
+     "varints are LEB128-encoded");
+
+  buffer_append_varint(buf, UINT64_MAX);
+  eq_num(buffer_size(buf), 13, "the largest varint takes ten bytes");
+
+  buffer_free(buf);
+}
+
+static void test_buffer_append_zigzag(void) {
+  buffer_t *buf = buffer_init(NULL);
+
+  buffer_append_zigzag(buf, -1);
+  buffer_append_zigzag(buf, 1);
+  buffer_append_zigzag(buf, -64);
+
+  ok(!memcmp(buffer_state(buf), "\x01\x02\x7f", 3),
+     "small negative values zigzag to small varints");
+
+  buffer_free(buf);
+}
+
+static void test_buffer_reader_roundtrip(void) {
+  buffer_t *buf = buffer_init(NULL);
+
+  buffer_append_u8(buf, 7);
+  buffer_append_u16le(buf, 65535);
+  buffer_append_u32le(buf, 123456789);
+  buffer_append_u64le(buf, UINT64_MAX - 1);
+  buffer_append_varint(buf, 1ULL << 63);
+  buffer_append_zigzag(buf, INT64_MIN);
+  buffer_append_prefixed(buf, "payload\0with nul", 16);
+
+  buffer_reader_t reader = buffer_reader_from(buf);
+
+  uint8_t u8;
+  uint16_t u16;
+  uint32_t u32;
+  uint64_t u64, varint;
+  int64_t zigzag;
+  const char *data;
+  size_t len;
+
+  ok(buffer_read_u8(&reader, &u8) && u8 == 7, "reads a u8");
+  ok(buffer_read_u16le(&reader, &u16) && u16 == 65535, "reads a u16");
+  ok(buffer_read_u32le(&reader, &u32) && u32 == 123456789, "reads a u32");
+  ok(buffer_read_u64le(&reader, &u64) && u64 == UINT64_MAX - 1, "reads a u64");
+  ok(buffer_read_varint(&reader, &varint) && varint == 1ULL << 63,
+     "reads a varint");
+  ok(buffer_read_zigzag(&reader, &zigzag) && zigzag == INT64_MIN,
+     "reads a zigzag varint");
+  ok(buffer_read_prefixed(&reader, &data, &len) && len == 16 &&
+         !memcmp(data, "payload\0with nul", 16),
+     "reads a length-prefixed byte string");
+  eq_num(buffer_reader_remaining(&reader), 0, "consumes every byte");
+
+  buffer_free(buf);
+}
+
+static void test_buffer_reader_bounds(void) {
+  buffer_reader_t reader = buffer_reader_init("\x01\x02\x03", 3);
+
+  uint32_t u32;
+  eq_false(buffer_read_u32le(&reader, &u32),
+           "fails to read past the end of the data");
+  eq_num(reader.pos, 0, "a failed read does not advance the cursor");
+
+  reader = buffer_reader_init("\x80\x80", 2);
+  uint64_t varint;
+  eq_false(buffer_read_varint(&reader, &varint),
+           "fails to read a truncated varint");
+
+  reader = buffer_reader_init("\xff\xff\xff\xff\xff\xff\xff\xff\xff\x02", 10);
+  eq_false(buffer_read_varint(&reader, &varint),
+           "fails to read a varint wider than 64 bits");
+
+  reader = buffer_reader_init("\x05" "abc", 4);
+  const char *data;
+  size_t len;
+  eq_false(buffer_read_prefixed(&reader, &data, &len),
+           "fails to read a byte string longer than the remaining data");
+  eq_num(reader.pos, 0, "a failed prefixed read does not advance the cursor");
+}
+
+void run_binary_tests(void) {
+  test_buffer_append_fixed();
+  test_buffer_append_varint();
+  test_buffer_append_zigzag();
+  test_buffer_reader_roundtrip();
+  test_buffer_reader_bounds();
+}
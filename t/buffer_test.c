@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "tests.h"
@@ -35,6 +36,34 @@ static void test_buffer_state(void) {
   buffer_free(buf);
 }
 
+static void test_buffer_sso(void) {
+  buffer_t *buf = buffer_init("short");
+
+  ok(buffer_state(buf) == ((__buffer_t *)buf)->sso,
+     "short contents are stored inline");
+
+  buffer_append(buf, " and then a good deal longer");
+  ok(buffer_state(buf) != ((__buffer_t *)buf)->sso,
+     "contents are promoted to the heap once they outgrow the inline storage");
+  eq_str(buffer_state(buf), "short and then a good deal longer",
+         "promotion preserves the buffer's contents");
+  eq_num(buffer_size(buf), 33, "promotion preserves the buffer's size");
+
+  buffer_free(buf);
+}
+
+static void test_buffer_reserve_overflow(void) {
+  buffer_t *buf = buffer_init("abc");
+
+  eq_false(buffer_reserve(buf, SIZE_MAX),
+           "fails to reserve a size that would overflow");
+  eq_false(buffer_reserve(buf, SIZE_MAX - 3),
+           "fails to reserve a size that leaves no room for the terminator");
+  eq_str(buffer_state(buf), "abc", "a failed reserve leaves the contents");
+
+  buffer_free(buf);
+}
+
 static void test_buffer_init_with_initial(void) {
   char *test_str = "test";
   size_t test_str_len = strlen(test_str);
@@ -86,6 +115,21 @@ static void test_buffer_append_with(void) {
   buffer_free(buf);
 }
 
+static void test_buffer_appendf(void) {
+  buffer_t *buf = buffer_init(NULL);
+
+  ok(buffer_appendf(buf, "%s=%d", "a", 1), "appends a formatted string");
+  eq_true(((__buffer_t *)buf)->state == ((__buffer_t *)buf)->sso,
+          "formats a short string into the inline storage");
+
+  buffer_appendf(buf, ";%s=%08d;", "a_much_longer_key", 12345);
+  eq_str(buffer_state(buf), "a=1;a_much_longer_key=00012345;",
+         "grows to fit a longer formatted string");
+  eq_num(buffer_size(buf), 31, "counts the formatted bytes");
+
+  buffer_free(buf);
+}
+
 static void test_buffer_concat(void) {
   buffer_t *buf_a = buffer_init("test");
   buffer_t *buf_b = buffer_init("string");
@@ -160,9 +204,60 @@ static void test_buffer_slice_null_buffer(void) {
            "retval is false indicating a NULL internal state");
 }
 
+static void test_buffer_write_fd(void) {
+  buffer_t *buf = buffer_init("hello world");
+  FILE *fp = tmpfile();
+
+  eq_num(buffer_write_fd(buf, fileno(fp)), IO_WRITE_ALL_OK,
+         "returns IO_WRITE_ALL_OK on successful write");
+
+  rewind(fp);
+  char *data = NULL;
+  size_t sz = 0;
+  io_read_all(fp, &data, &sz);
+  eq_str(data, "hello world", "writes the buffer's contents");
+
+  eq_num(buffer_write_fd(buf, -1), IO_WRITE_ALL_INVALID,
+         "returns IO_WRITE_ALL_INVALID given a bad file descriptor");
+
+  free(data);
+  fclose(fp);
+  buffer_free(buf);
+}
+
+static void test_buffers_writev(void) {
+  buffer_t *bufs[100];
+  buffer_t *expected = buffer_init(NULL);
+  for (int i = 0; i < 100; i++) {
+    char tmp[8];
+    snprintf(tmp, sizeof(tmp), "%d,", i);
+    bufs[i] = buffer_init(tmp);
+    buffer_append(expected, tmp);
+  }
+
+  FILE *fp = tmpfile();
+  eq_num(buffers_writev(fileno(fp), bufs, 100), IO_WRITE_ALL_OK,
+         "returns IO_WRITE_ALL_OK on successful write");
+
+  rewind(fp);
+  char *data = NULL;
+  size_t sz = 0;
+  io_read_all(fp, &data, &sz);
+  eq_str(data, buffer_state(expected), "writes every buffer in order");
+
+  free(data);
+  fclose(fp);
+  for (int i = 0; i < 100; i++) {
+    buffer_free(bufs[i]);
+  }
+  buffer_free(expected);
+}
+
 void run_buffer_tests(void) {
   test_buffer_init();
   test_buffer_init_with_initial();
+  test_buffer_sso();
+  test_buffer_reserve_overflow();
 
   test_buffer_free();
   test_buffer_free_nonnull();
@@ -173,6 +268,7 @@ void run_buffer_tests(void) {
 
   test_buffer_append();
   test_buffer_append_with();
+  test_buffer_appendf();
 
   test_buffer_concat();
   test_buffer_concat_on_null();
@@ -181,4 +277,7 @@ void run_buffer_tests(void) {
   test_buffer_slice_empty_buffer();
   test_buffer_slice_bad_range();
   test_buffer_slice_null_buffer();
+
+  test_buffer_write_fd();
+  test_buffers_writev();
 }
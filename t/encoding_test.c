@@ -0,0 +1,141 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+
+// Long enough to run several iterations of every vector kernel
+#define ENCODING_TEST_ROUNDTRIP_SZ 1000
+
+static void test_buffer_append_base64(void) {
+  const char *vectors[][2] = {
+      {"", ""},         {"f", "Zg=="},         {"fo", "Zm8="},
+      {"foo", "Zm9v"},  {"foob", "Zm9vYg=="},  {"fooba", "Zm9vYmE="},
+      {"foobar", "Zm9vYmFy"},
+  };
+
+  bool all_ok = true;
+  for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+    buffer_t *buf = buffer_init(NULL);
+    buffer_append_base64(buf, vectors[i][0], strlen(vectors[i][0]));
+    all_ok = all_ok && !strcmp(buffer_state(buf), vectors[i][1]);
+    buffer_free(buf);
+  }
+  ok(all_ok, "encodes the RFC 4648 test vectors");
+
+  buffer_t *buf = buffer_init("data:");
+  buffer_append_base64(buf, "\xff\xfe\x00", 3);
+  eq_str(buffer_state(buf), "data://4A",
+         "appends after existing contents and uses the standard alphabet");
+  buffer_free(buf);
+}
+
+static void test_buffer_append_base64_decoded(void) {
+  buffer_t *buf = buffer_init(NULL);
+
+  ok(buffer_append_base64_decoded(buf, "Zm9vYmFy", 8) &&
+         !strcmp(buffer_state(buf), "foobar"),
+     "decodes base64");
+
+  buffer_clear(buf);
+  ok(buffer_append_base64_decoded(buf, "Zm9vYg==", 8) &&
+         !strcmp(buffer_state(buf), "foob"),
+     "decodes padded base64");
+
+  buffer_clear(buf);
+  ok(buffer_append_base64_decoded(buf, "Zm9vYg", 6) &&
+         !strcmp(buffer_state(buf), "foob"),
+     "decodes unpadded base64");
+
+  buffer_clear(buf);
+  buffer_append(buf, "keep");
+  eq_false(buffer_append_base64_decoded(buf, "Zm9v!mFy", 8),
+           "rejects characters outside the alphabet");
+  eq_false(buffer_append_base64_decoded(buf, "Zm9vY", 5),
+           "rejects input with an impossible length");
+  eq_str(buffer_state(buf), "keep", "a failed decode leaves the buffer as-is");
+
+  char invalid[64];
+  memset(invalid, 'A', sizeof(invalid));
+  invalid[40] = '*';
+  eq_false(buffer_append_base64_decoded(buf, invalid, sizeof(invalid)),
+           "rejects invalid characters deep inside long input");
+  eq_str(buffer_state(buf), "keep",
+         "a failed decode of long input leaves the buffer as-is");
+
+  buffer_free(buf);
+}
+
+static void test_buffer_append_hex(void) {
+  buffer_t *buf = buffer_init(NULL);
+
+  buffer_append_hex(buf, "\x00\x9f\xab\xff", 4);
+  eq_str(buffer_state(buf), "009fabff", "encodes bytes as lowercase hex");
+
+  buffer_clear(buf);
+  ok(buffer_append_hex_decoded(buf, "4869aBcD", 8) &&
+         !memcmp(buffer_state(buf), "Hi\xab\xcd", 4),
+     "decodes hex of either case");
+
+  buffer_clear(buf);
+  eq_false(buffer_append_hex_decoded(buf, "abc", 3),
+           "rejects odd-length hex");
+  eq_false(buffer_append_hex_decoded(buf, "0g", 2),
+           "rejects non-hex characters");
+
+  char invalid[64];
+  memset(invalid, 'f', sizeof(invalid));
+  invalid[50] = 'G';
+  eq_false(buffer_append_hex_decoded(buf, invalid, sizeof(invalid)),
+           "rejects invalid characters deep inside long input");
+  eq_num(buffer_size(buf), 0, "a failed decode leaves the buffer as-is");
+
+  buffer_free(buf);
+}
+
+static void test_encoding_roundtrip(void) {
+  char *data = malloc(ENCODING_TEST_ROUNDTRIP_SZ);
+  srand(42);
+  for (size_t i = 0; i < ENCODING_TEST_ROUNDTRIP_SZ; i++) {
+    data[i] = (char)rand();
+  }
+
+  // Every length exercises a different split between vector and scalar code
+  bool base64_ok = true;
+  bool hex_ok = true;
+  for (size_t len = 0; len <= ENCODING_TEST_ROUNDTRIP_SZ; len += 37) {
+    buffer_t *encoded = buffer_init(NULL);
+    buffer_t *decoded = buffer_init(NULL);
+
+    buffer_append_base64(encoded, data, len);
+    base64_ok = base64_ok && buffer_size(encoded) == (len + 2) / 3 * 4 &&
+                buffer_append_base64_decoded(decoded, buffer_state(encoded),
+                                             buffer_size(encoded)) &&
+                buffer_size(decoded) == len &&
+                !memcmp(buffer_state(decoded), data, len);
+
+    buffer_clear(encoded);
+    buffer_clear(decoded);
+
+    buffer_append_hex(encoded, data, len);
+    hex_ok = hex_ok && buffer_size(encoded) == len * 2 &&
+             buffer_append_hex_decoded(decoded, buffer_state(encoded),
+                                       buffer_size(encoded)) &&
+             buffer_size(decoded) == len &&
+             !memcmp(buffer_state(decoded), data, len);
+
+    buffer_free(encoded);
+    buffer_free(decoded);
+  }
+
+  ok(base64_ok, "base64 roundtrips arbitrary bytes of every length");
+  ok(hex_ok, "hex roundtrips arbitrary bytes of every length");
+
+  free(data);
+}
+
+void run_encoding_tests(void) {
+  test_buffer_append_base64();
+  test_buffer_append_base64_decoded();
+  test_buffer_append_hex();
+  test_encoding_roundtrip();
+}
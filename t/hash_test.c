@@ -0,0 +1,126 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+
+#define HASH_TEST_DATA_SZ 1000
+
+// Bit-at-a-time CRC-32C to check the table-driven and hardware paths against
+static uint32_t crc32c_reference(const char *data, size_t len) {
+  uint32_t crc = 0xffffffff;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (unsigned char)data[i];
+    for (int k = 0; k < 8; k++) {
+      crc = crc & 1 ? (crc >> 1) ^ 0x82f63b78 : crc >> 1;
+    }
+  }
+
+  return ~crc;
+}
+
+static char *hash_test_data(void) {
+  char *data = malloc(HASH_TEST_DATA_SZ);
+  srand(7);
+  for (size_t i = 0; i < HASH_TEST_DATA_SZ; i++) {
+    data[i] = (char)rand();
+  }
+
+  return data;
+}
+
+static void test_crc32c(void) {
+  eq_num(u_crc32c("123456789", 9), 0xe3069283, "matches the check value");
+  eq_num(u_crc32c("", 0), 0, "checksum of no bytes is 0");
+
+  char zeros[32] = {0};
+  char ones[32];
+  memset(ones, 0xff, sizeof(ones));
+  ok(u_crc32c(zeros, 32) == 0x8a9136aa && u_crc32c(ones, 32) == 0x62a8ab43,
+     "matches the RFC 3720 test vectors");
+
+  char *data = hash_test_data();
+  bool all_ok = true;
+  for (size_t len = 0; len <= HASH_TEST_DATA_SZ; len += 13) {
+    all_ok = all_ok && u_crc32c(data, len) == crc32c_reference(data, len);
+  }
+  ok(all_ok, "matches a bitwise implementation at every length");
+
+  uint32_t crc = 0;
+  for (size_t i = 0; i < HASH_TEST_DATA_SZ; i += 77) {
+    size_t n = HASH_TEST_DATA_SZ - i < 77 ? HASH_TEST_DATA_SZ - i : 77;
+    crc = u_crc32c_update(crc, data + i, n);
+  }
+  eq_num(crc, u_crc32c(data, HASH_TEST_DATA_SZ),
+         "incremental checksum matches the one-shot checksum");
+
+  free(data);
+}
+
+static void test_hash64(void) {
+  eq_true(u_hash64("hello", 5, 0) == u_hash64("hello", 5, 0),
+          "hashing is deterministic");
+  eq_true(u_hash64("hello", 5, 0) != u_hash64("hello", 5, 1),
+          "the seed changes the hash");
+  eq_true(u_hash64("hello", 5, 0) != u_hash64("hello", 4, 0),
+          "the length changes the hash");
+  eq_true(u_hash64("", 0, 0) != u_hash64("\0", 1, 0),
+          "a trailing NUL byte changes the hash");
+
+  eq_true(u_hash_str("hello") == u_hash64("hello", 5, 0),
+          "u_hash_str hashes the string's bytes");
+
+  buffer_t *buf = buffer_init("hello");
+  eq_true(u_hash_buffer(buf) == u_hash64("hello", 5, 0),
+          "u_hash_buffer hashes the buffer's contents");
+  buffer_free(buf);
+
+  // Flipping any single bit should change the hash
+  char *data = hash_test_data();
+  uint64_t h = u_hash64(data, 100, 0);
+  bool all_differ = true;
+  for (size_t bit = 0; bit < 100 * 8; bit++) {
+    data[bit / 8] ^= 1 << (bit % 8);
+    all_differ = all_differ && u_hash64(data, 100, 0) != h;
+    data[bit / 8] ^= 1 << (bit % 8);
+  }
+  ok(all_differ, "every input bit affects the hash");
+
+  free(data);
+}
+
+static void test_hash_incremental(void) {
+  char *data = hash_test_data();
+  size_t chunk_sizes[] = {1, 7, 16, 47, 48, 49, 64, 200};
+
+  bool all_ok = true;
+  for (size_t len = 0; len <= 300; len++) {
+    for (size_t c = 0; c < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); c++) {
+      u_hash_state_t state;
+      u_hash_init(&state, 42);
+
+      for (size_t i = 0; i < len; i += chunk_sizes[c]) {
+        size_t n = len - i < chunk_sizes[c] ? len - i : chunk_sizes[c];
+        u_hash_update(&state, data + i, n);
+      }
+
+      all_ok = all_ok && u_hash_digest(&state) == u_hash64(data, len, 42);
+    }
+  }
+  ok(all_ok, "incremental hash matches the one-shot hash");
+
+  u_hash_state_t state;
+  u_hash_init(&state, 0);
+  u_hash_update(&state, "hello ", 6);
+  u_hash_digest(&state);
+  u_hash_update(&state, "world", 5);
+  eq_true(u_hash_digest(&state) == u_hash64("hello world", 11, 0),
+          "the state can be updated after taking a digest");
+
+  free(data);
+}
+
+void run_hash_tests(void) {
+  test_crc32c();
+  test_hash64();
+  test_hash_incremental();
+}
@@ -0,0 +1,143 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+
+static size_t hashmap_test_freed;
+
+static void hashmap_test_free(void *value) {
+  hashmap_test_freed++;
+  free(value);
+}
+
+static void test_hashmap_str(void) {
+  hashmap_t *map = hashmap_init(HASHMAP_KEY_STR, hashmap_test_free);
+  char key[] = "content-type";
+
+  eq_null(hashmap_get(map, "missing"), "an empty map has no keys");
+
+  ok(hashmap_set(map, key, s_copy("text/html")), "sets a key");
+  key[0] = 'C';
+  eq_str(hashmap_get(map, "content-type"), "text/html",
+         "gets a value by a key with equal contents");
+  eq_false(hashmap_has(map, key), "copies its string keys");
+
+  hashmap_test_freed = 0;
+  hashmap_set(map, "content-type", s_copy("application/json"));
+  eq_str(hashmap_get(map, "content-type"), "application/json",
+         "replaces a key's value");
+  eq_num(hashmap_test_freed, 1, "frees the replaced value");
+  eq_num(hashmap_size(map), 1, "does not count a replaced key twice");
+
+  hashmap_set(map, "empty", NULL);
+  ok(hashmap_has(map, "empty") && !hashmap_get(map, "empty"),
+     "tells a NULL value from a missing key");
+  eq_false(hashmap_set(map, NULL, NULL), "rejects a NULL string key");
+
+  eq_true(hashmap_delete(map, "content-type"), "deletes a key");
+  eq_num(hashmap_test_freed, 2, "frees the deleted value");
+  eq_false(hashmap_has(map, "content-type"), "forgets a deleted key");
+  eq_false(hashmap_delete(map, "content-type"), "does not delete twice");
+
+  hashmap_free(map);
+}
+
+static void test_hashmap_int(void) {
+  hashmap_t *map = hashmap_init(HASHMAP_KEY_INT, NULL);
+
+  for (size_t i = 0; i < 1000; i++) {
+    hashmap_set(map, (void *)i, (void *)(i * 2));
+  }
+  eq_num(hashmap_size(map), 1000, "grows to hold every key");
+
+  bool all_ok = hashmap_has(map, (void *)0);
+  for (size_t i = 0; i < 1000 && all_ok; i++) {
+    all_ok = (size_t)hashmap_get(map, (void *)i) == i * 2;
+  }
+  ok(all_ok, "maps integer keys, including 0");
+  eq_false(hashmap_has(map, (void *)1000), "does not find a missing key");
+
+  eq_false(hashmap_reserve(map, SIZE_MAX),
+           "fails to reserve more entries than a table can hold");
+  ok(hashmap_size(map) == 1000 && (size_t)hashmap_get(map, (void *)999) == 1998,
+     "a failed reserve leaves the map intact");
+
+  hashmap_free(map);
+
+  int a, b;
+  map = hashmap_init(HASHMAP_KEY_PTR, NULL);
+  hashmap_set(map, &a, "a");
+  hashmap_set(map, &b, "b");
+  ok(!strcmp(hashmap_get(map, &a), "a") && !strcmp(hashmap_get(map, &b), "b"),
+     "maps pointer keys by address");
+  hashmap_free(map);
+}
+
+static void test_hashmap_churn(void) {
+  // Random sets and deletes over a small key space leave plenty of
+  // tombstones, which must never hide a key or let the table fill up
+  enum { N_KEYS = 512 };
+  bool present[N_KEYS] = {false};
+  size_t expected = 0;
+  hashmap_t *map = hashmap_init(HASHMAP_KEY_INT, NULL);
+
+  srand(3);
+  bool all_ok = true;
+  for (int round = 0; round < 100000 && all_ok; round++) {
+    size_t key = rand() % N_KEYS;
+
+    if (rand() % 2) {
+      hashmap_set(map, (void *)key, (void *)(key + 1));
+      expected += !present[key];
+      present[key] = true;
+    } else {
+      all_ok = hashmap_delete(map, (void *)key) == present[key];
+      expected -= present[key];
+      present[key] = false;
+    }
+
+    all_ok = all_ok && hashmap_size(map) == expected &&
+             hashmap_has(map, (void *)key) == present[key];
+  }
+
+  for (size_t key = 0; key < N_KEYS && all_ok; key++) {
+    size_t value = (size_t)hashmap_get(map, (void *)key);
+    all_ok = value == (present[key] ? key + 1 : 0);
+  }
+  ok(all_ok, "agrees with a reference set after many sets and deletes");
+
+  hashmap_free(map);
+}
+
+static void test_hashmap_next(void) {
+  hashmap_t *map = hashmap_init(HASHMAP_KEY_STR, NULL);
+  ok(hashmap_reserve(map, 100), "reserves space");
+
+  const char *keys[] = {"a", "b", "c", "d", "e"};
+  for (size_t i = 0; i < 5; i++) {
+    hashmap_set(map, keys[i], (void *)(i + 1));
+  }
+  hashmap_delete(map, "c");
+
+  size_t iter = 0;
+  size_t n = 0;
+  size_t sum = 0;
+  const void *key;
+  void *value;
+  while (hashmap_next(map, &iter, &key, &value)) {
+    n++;
+    sum += (size_t)value;
+    ok(hashmap_get(map, key) == value, "visits key %s with its value",
+       (const char *)key);
+  }
+  ok(n == 4 && sum == 1 + 2 + 4 + 5, "visits every entry once");
+
+  hashmap_free(map);
+}
+
+void run_hashmap_tests(void) {
+  test_hashmap_str();
+  test_hashmap_int();
+  test_hashmap_churn();
+  test_hashmap_next();
+}
@@ -0,0 +1,98 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+
+#define INTERN_TEST_THREADS 4
+#define INTERN_TEST_WORDS 2000
+
+typedef struct {
+  interner_t *in;
+  const char **canonical;
+} intern_test_ctx;
+
+static void *intern_test_worker(void *arg) {
+  intern_test_ctx *ctx = arg;
+  char word[32];
+
+  // Every thread interns the same vocabulary, several times over
+  for (int round = 0; round < 3; round++) {
+    for (size_t i = 0; i < INTERN_TEST_WORDS; i++) {
+      snprintf(word, sizeof(word), "key-%zu", i);
+      const char *s = interner_intern(ctx->in, word);
+      if (!s || strcmp(s, word)) {
+        return (void *)1;
+      }
+
+      ctx->canonical[i] = s;
+    }
+  }
+
+  return NULL;
+}
+
+static void test_interner_intern(void) {
+  interner_t *in = interner_init();
+  char *copy = s_copy("content-type");
+
+  const char *a = interner_intern(in, "content-type");
+  const char *b = interner_intern(in, copy);
+  ok(a == b && a != copy, "maps equal strings to one canonical pointer");
+  eq_str(a, "content-type", "copies the string");
+  ok(interner_intern(in, "content-length") != a,
+     "maps different strings to different pointers");
+  eq_num(interner_size(in), 2, "counts distinct strings");
+
+  eq_null(interner_lookup_n(in, "host", 4), "does not find a new string");
+  eq_num(interner_size(in), 2, "lookups do not intern");
+  ok(interner_lookup_n(in, "content-type!", 12) == a,
+     "finds a string by length");
+
+  const char *n = interner_intern_n(in, "a\0b", 3);
+  ok(n != interner_intern(in, "a") && !memcmp(n, "a\0b", 4),
+     "interns strings containing NUL bytes");
+  eq_null(interner_intern(in, NULL), "does not intern NULL");
+
+  free(copy);
+  interner_free(in);
+}
+
+static void test_interner_concurrent(void) {
+  interner_t *in = interner_init();
+  pthread_t threads[INTERN_TEST_THREADS];
+  intern_test_ctx ctxs[INTERN_TEST_THREADS];
+
+  for (size_t t = 0; t < INTERN_TEST_THREADS; t++) {
+    ctxs[t].in = in;
+    ctxs[t].canonical = malloc(INTERN_TEST_WORDS * sizeof(char *));
+    pthread_create(&threads[t], NULL, intern_test_worker, &ctxs[t]);
+  }
+
+  bool all_ok = true;
+  for (size_t t = 0; t < INTERN_TEST_THREADS; t++) {
+    void *ret;
+    pthread_join(threads[t], &ret);
+    all_ok = all_ok && ret == NULL;
+  }
+  ok(all_ok, "interns from several threads at once");
+
+  for (size_t i = 0; i < INTERN_TEST_WORDS && all_ok; i++) {
+    for (size_t t = 1; t < INTERN_TEST_THREADS; t++) {
+      all_ok = all_ok && ctxs[t].canonical[i] == ctxs[0].canonical[i];
+    }
+  }
+  ok(all_ok, "every thread gets the same canonical pointers");
+  eq_num(interner_size(in), INTERN_TEST_WORDS, "interns each string once");
+
+  for (size_t t = 0; t < INTERN_TEST_THREADS; t++) {
+    free(ctxs[t].canonical);
+  }
+  interner_free(in);
+}
+
+void run_intern_tests(void) {
+  test_interner_intern();
+  test_interner_concurrent();
+}
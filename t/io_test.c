@@ -79,7 +79,32 @@ static void test_write_all_full_file(void) {
   unlink("./t/fixtures/write.txt");
 }
 
+static void test_writev_all(void) {
+  FILE *fp = tmpfile();
+
+  struct iovec iov[3] = {
+      {.iov_base = "hello", .iov_len = 5},
+      {.iov_base = "", .iov_len = 0},
+      {.iov_base = " world", .iov_len = 6},
+  };
+
+  size_t n_written = 0;
+  eq_num(IO_WRITE_ALL_OK, io_writev_all(fileno(fp), iov, 3, &n_written),
+         "returns IO_WRITE_ALL_OK on successful write");
+
+  rewind(fp);
+  char *data = NULL;
+  size_t sz = 0;
+  assert(IO_READ_ALL_OK == io_read_all(fp, &data, &sz));
+
+  eq_str(data, "hello world", "writes every vector in order");
+
+  free(data);
+  fclose(fp);
+}
+
 void run_io_tests(void) {
   test_read_all_full_file();
   test_write_all_full_file();
+  test_writev_all();
 }
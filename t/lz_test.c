@@ -0,0 +1,195 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+
+// Spans several frame blocks
+#define LZ_TEST_DATA_SZ (200 * 1024)
+
+// `printf 'hello hello hello hello hello world, hello world!\n' | lz4`
+static const unsigned char lz4_cli_frame[] = {
+    0x04, 0x22, 0x4d, 0x18, 0x64, 0x40, 0xa7, 0x1b, 0x00, 0x00, 0x00, 0x6f,
+    0x68, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x06, 0x00, 0x05, 0x63, 0x77, 0x6f,
+    0x72, 0x6c, 0x64, 0x2c, 0x1f, 0x00, 0x70, 0x77, 0x6f, 0x72, 0x6c, 0x64,
+    0x21, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x2a, 0xf0, 0x89, 0xdc,
+};
+
+static const char lz4_cli_plain[] =
+    "hello hello hello hello hello world, hello world!\n";
+
+// Log-like text, which compresses well
+static char *lz_test_text(void) {
+  char *data = malloc(LZ_TEST_DATA_SZ);
+  size_t len = 0;
+
+  srand(3);
+  while (len < LZ_TEST_DATA_SZ) {
+    char line[128];
+    int n = snprintf(line, sizeof(line),
+                     "level=info request_id=%d path=/api/v1/items/%d ms=%d\n",
+                     rand() % 100000, rand() % 500, rand() % 1000);
+    size_t take = LZ_TEST_DATA_SZ - len < (size_t)n ? LZ_TEST_DATA_SZ - len
+                                                    : (size_t)n;
+    memcpy(data + len, line, take);
+    len += take;
+  }
+
+  return data;
+}
+
+static void test_lz_block_roundtrip(void) {
+  char *data = lz_test_text();
+  char *compressed = malloc(lz_compress_bound(LZ_TEST_DATA_SZ));
+  char *decompressed = malloc(LZ_TEST_DATA_SZ);
+
+  size_t n = lz_compress_block(data, LZ_TEST_DATA_SZ, compressed);
+  ok(n < LZ_TEST_DATA_SZ / 3, "compresses repetitive text at least 3x");
+
+  size_t n_out;
+  ok(lz_decompress_block(compressed, n, decompressed, LZ_TEST_DATA_SZ,
+                         &n_out) == LZ_OK &&
+         n_out == LZ_TEST_DATA_SZ &&
+         !memcmp(decompressed, data, LZ_TEST_DATA_SZ),
+     "block roundtrips");
+
+  eq_num(lz_decompress_block(compressed, n, decompressed, LZ_TEST_DATA_SZ - 1,
+                             &n_out),
+         LZ_ERR_CORRUPT, "refuses to decompress past the output capacity");
+
+  // Incompressible input may grow, but never past the bound
+  for (size_t i = 0; i < LZ_TEST_DATA_SZ; i++) {
+    data[i] = (char)rand();
+  }
+  n = lz_compress_block(data, LZ_TEST_DATA_SZ, compressed);
+  ok(n <= lz_compress_bound(LZ_TEST_DATA_SZ) &&
+         lz_decompress_block(compressed, n, decompressed, LZ_TEST_DATA_SZ,
+                             &n_out) == LZ_OK &&
+         !memcmp(decompressed, data, LZ_TEST_DATA_SZ),
+     "incompressible block roundtrips within the bound");
+
+  bool all_ok = true;
+  for (size_t len = 0; len < 40; len++) {
+    memset(data, 'a', len);
+    n = lz_compress_block(data, len, compressed);
+    all_ok = all_ok &&
+             lz_decompress_block(compressed, n, decompressed, len, &n_out) ==
+                 LZ_OK &&
+             n_out == len && !memcmp(decompressed, data, len);
+  }
+  ok(all_ok, "short blocks roundtrip");
+
+  free(data);
+  free(compressed);
+  free(decompressed);
+}
+
+static void test_lz_block_corrupt(void) {
+  char out[64];
+  size_t n_out;
+
+  // A match whose offset reaches before the start of the output
+  eq_num(lz_decompress_block("\x14" "a" "\x05\x00", 4, out, sizeof(out),
+                             &n_out),
+         LZ_ERR_CORRUPT, "rejects an offset before the start of the output");
+
+  // Literal length claiming more bytes than remain
+  eq_num(lz_decompress_block("\xf0\x10" "abc", 5, out, sizeof(out), &n_out),
+         LZ_ERR_CORRUPT, "rejects literals running past the input");
+
+  eq_num(lz_decompress_block("", 0, out, sizeof(out), &n_out), LZ_ERR_CORRUPT,
+         "rejects an empty block");
+}
+
+static void test_buffer_lz_frame(void) {
+  buffer_t *buf = buffer_init(NULL);
+
+  ok(buffer_append_decompressed(buf, (const char *)lz4_cli_frame,
+                                sizeof(lz4_cli_frame)) == LZ_OK &&
+         !strcmp(buffer_state(buf), lz4_cli_plain),
+     "decompresses a frame written by the lz4 tool");
+
+  char *data = lz_test_text();
+  buffer_t *compressed = buffer_init(NULL);
+  buffer_append_compressed(compressed, data, LZ_TEST_DATA_SZ);
+
+  buffer_clear(buf);
+  ok(buffer_append_decompressed(buf, buffer_state(compressed),
+                                buffer_size(compressed)) == LZ_OK &&
+         buffer_size(buf) == LZ_TEST_DATA_SZ &&
+         !memcmp(buffer_state(buf), data, LZ_TEST_DATA_SZ),
+     "multi-block frame roundtrips");
+
+  // Concatenated frames decode to the concatenated contents
+  buffer_append_compressed(compressed, "tail", 4);
+  buffer_clear(buf);
+  ok(buffer_append_decompressed(buf, buffer_state(compressed),
+                                buffer_size(compressed)) == LZ_OK &&
+         buffer_size(buf) == LZ_TEST_DATA_SZ + 4 &&
+         !memcmp(buffer_state(buf) + LZ_TEST_DATA_SZ, "tail", 4),
+     "concatenated frames roundtrip");
+
+  buffer_clear(buf);
+  buffer_append(buf, "keep");
+
+  // Flip a byte of the content checksum
+  buffer_state(compressed)[buffer_size(compressed) - 1] ^= 1;
+  eq_num(buffer_append_decompressed(buf, buffer_state(compressed),
+                                    buffer_size(compressed)),
+         LZ_ERR_CORRUPT, "detects a content checksum mismatch");
+
+  eq_num(buffer_append_decompressed(buf, buffer_state(compressed), 100),
+         LZ_ERR_CORRUPT, "detects a truncated frame");
+  eq_str(buffer_state(buf), "keep",
+         "a failed decompression leaves the buffer as-is");
+
+  buffer_free(compressed);
+  buffer_free(buf);
+  free(data);
+}
+
+static void test_lz_file(void) {
+  char *data = lz_test_text();
+
+  FILE *plain = tmpfile();
+  FILE *compressed = tmpfile();
+  FILE *restored = tmpfile();
+
+  fwrite(data, 1, LZ_TEST_DATA_SZ, plain);
+  rewind(plain);
+
+  eq_num(lz_compress_file(plain, compressed), LZ_OK, "compresses a file");
+  rewind(compressed);
+  eq_num(lz_decompress_file(compressed, restored), LZ_OK,
+         "decompresses a file");
+  rewind(restored);
+
+  char *contents = NULL;
+  size_t n_read;
+  io_read_all(restored, &contents, &n_read);
+  ok(n_read == LZ_TEST_DATA_SZ && !memcmp(contents, data, LZ_TEST_DATA_SZ),
+     "file roundtrips");
+
+  // Streams and buffers produce interchangeable frames
+  rewind(compressed);
+  char *frame = NULL;
+  io_read_all(compressed, &frame, &n_read);
+  buffer_t *buf = buffer_init(NULL);
+  ok(buffer_append_decompressed(buf, frame, n_read) == LZ_OK &&
+         buffer_size(buf) == LZ_TEST_DATA_SZ,
+     "a compressed file decompresses into a buffer");
+
+  buffer_free(buf);
+  free(frame);
+  free(contents);
+  fclose(plain);
+  fclose(compressed);
+  fclose(restored);
+  free(data);
+}
+
+void run_lz_tests(void) {
+  test_lz_block_roundtrip();
+  test_lz_block_corrupt();
+  test_buffer_lz_frame();
+  test_lz_file();
+}
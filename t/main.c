@@ -2,13 +2,29 @@
 #include "tests.h"
 
 int main() {
-  plan(195);
+  plan(530);
 
   run_array_tests();
   run_buffer_tests();
   run_str_tests();
   run_io_tests();
   run_file_tests();
+  run_rope_tests();
+  run_pool_tests();
+  run_shared_tests();
+  run_ring_tests();
+  run_binary_tests();
+  run_encoding_tests();
+  run_hash_tests();
+  run_lz_tests();
+  run_sv_tests();
+  run_strtab_tests();
+  run_search_tests();
+  run_matcher_tests();
+  run_intern_tests();
+  run_hashmap_tests();
+  run_replacer_tests();
+  run_utf8_tests();
 
   done_testing();
 }
@@ -0,0 +1,144 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+
+#define MATCHER_TEST_MAX_MATCHES 65536
+
+typedef struct {
+  size_t patterns[MATCHER_TEST_MAX_MATCHES];
+  size_t starts[MATCHER_TEST_MAX_MATCHES];
+  size_t n;
+} matcher_test_matches;
+
+static bool matcher_test_collect(size_t pattern, size_t start, void *ctx) {
+  matcher_test_matches *matches = ctx;
+  if (matches->n < MATCHER_TEST_MAX_MATCHES) {
+    matches->patterns[matches->n] = pattern;
+    matches->starts[matches->n] = start;
+  }
+  matches->n++;
+
+  return true;
+}
+
+static bool matcher_test_has(matcher_test_matches *matches, size_t pattern,
+                             size_t start) {
+  for (size_t i = 0; i < matches->n; i++) {
+    if (matches->patterns[i] == pattern && matches->starts[i] == start) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Checks the matches against a naive search for each pattern at each position
+static bool matcher_test_agrees(matcher_t *m, array_t *patterns,
+                                const char *s) {
+  // Too large for the stack with hundreds of short patterns
+  static matcher_test_matches matches;
+  matches.n = 0;
+  matcher_scan(m, s, strlen(s), matcher_test_collect, &matches);
+
+  size_t expected = 0;
+  for (size_t p = 0; p < array_size(patterns); p++) {
+    const char *pattern = array_get(patterns, p);
+    size_t len = strlen(pattern);
+
+    for (size_t i = 0; s[i]; i++) {
+      if (!strncmp(s + i, pattern, len)) {
+        expected++;
+        if (!matcher_test_has(&matches, p, i)) {
+          return false;
+        }
+      }
+    }
+  }
+
+  return matches.n == expected;
+}
+
+static array_t *matcher_test_patterns(size_t n, size_t max_len) {
+  array_t *patterns = array_init();
+
+  for (size_t i = 0; i < n; i++) {
+    size_t len = 1 + rand() % max_len;
+    char *pattern = malloc(len + 1);
+    for (size_t j = 0; j < len; j++) {
+      pattern[j] = 'a' + rand() % 4;
+    }
+    pattern[len] = '\0';
+    array_push(patterns, pattern);
+  }
+
+  return patterns;
+}
+
+static void test_matcher_overlapping(void) {
+  array_t *patterns = array_collect("he", "she", "his", "hers");
+  matcher_t *m = matcher_init(patterns);
+  static matcher_test_matches matches;
+  matches.n = 0;
+
+  eq_num(matcher_size(m), 4, "holds every pattern");
+  eq_num(matcher_scan(m, "ushers", 6, matcher_test_collect, &matches), 3,
+         "reports every match");
+  ok(matcher_test_has(&matches, 1, 1) && matcher_test_has(&matches, 0, 2) &&
+         matcher_test_has(&matches, 3, 2),
+     "reports overlapping matches and their patterns");
+
+  matcher_free(m);
+  array_free(patterns, NULL);
+}
+
+static void test_matcher_random(void) {
+  const size_t set_sizes[] = {3, 20, 300};
+  char text[600];
+
+  srand(5);
+  for (size_t i = 0; i < sizeof(set_sizes) / sizeof(set_sizes[0]); i++) {
+    array_t *patterns = matcher_test_patterns(set_sizes[i], 6);
+    matcher_t *m = matcher_init(patterns);
+
+    bool all_ok = true;
+    for (int round = 0; round < 20 && all_ok; round++) {
+      size_t len = rand() % (sizeof(text) - 1);
+      for (size_t j = 0; j < len; j++) {
+        text[j] = 'a' + rand() % 5;
+      }
+      text[len] = '\0';
+
+      all_ok = matcher_test_agrees(m, patterns, text);
+    }
+    ok(all_ok, "agrees with a naive search for %zu patterns", set_sizes[i]);
+
+    matcher_free(m);
+    array_free(patterns, free);
+  }
+}
+
+static void test_matcher_matches(void) {
+  array_t *patterns =
+      array_collect("ERROR", "FATAL", "panic:", "segfault", "timeout");
+  matcher_t *m = matcher_init(patterns);
+
+  const char *line = "2024-01-01 worker 3: request timeout after 30s";
+  eq_true(matcher_matches(m, line, strlen(line)), "finds a keyword");
+
+  line = "2024-01-01 worker 3: request served in 3ms";
+  eq_false(matcher_matches(m, line, strlen(line)), "finds no keyword");
+
+  matcher_free(m);
+  array_free(patterns, NULL);
+
+  patterns = array_collect("ok", "");
+  eq_null(matcher_init(patterns), "rejects an empty pattern");
+  array_free(patterns, NULL);
+}
+
+void run_matcher_tests(void) {
+  test_matcher_overlapping();
+  test_matcher_random();
+  test_matcher_matches();
+}
@@ -0,0 +1,114 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+
+static void *pool_worker(void *arg) {
+  buffer_pool_t *pool = arg;
+
+  for (int i = 0; i < 1000; i++) {
+    buffer_t *buf = buffer_pool_get(pool, (i % 7) * 300);
+    buffer_append(buf, "response body");
+    buffer_pool_put(pool, buf);
+  }
+
+  return NULL;
+}
+
+static void test_buffer_pool_init_invalid(void) {
+  size_t unordered[] = {1024, 256};
+
+  eq_null(buffer_pool_init(unordered, 2, 0, false),
+          "rejects size classes that are not ascending");
+  eq_null(buffer_pool_init(unordered, 0, 0, false),
+          "rejects an empty set of size classes");
+}
+
+static void test_buffer_pool_get(void) {
+  buffer_pool_t *pool = buffer_pool_init(NULL, 0, 0, false);
+
+  buffer_t *buf = buffer_pool_get(pool, 1000);
+  eq_num(buffer_size(buf), 0, "returns an empty buffer");
+  eq_str(buffer_state(buf), "", "returned buffer's state is an empty string");
+  ok(((__buffer_t *)buf)->cap >= 1001,
+     "returned buffer can hold the requested size without growing");
+
+  buffer_pool_put(pool, buf);
+  buffer_pool_free(pool);
+}
+
+static void test_buffer_pool_reuse(void) {
+  buffer_pool_t *pool = buffer_pool_init(NULL, 0, 0, false);
+
+  buffer_t *buf = buffer_pool_get(pool, 100);
+  buffer_append(buf, "hello");
+  buffer_pool_put(pool, buf);
+
+  ok(buffer_pool_retained(pool) > 0, "retains a returned buffer");
+
+  buffer_t *reused = buffer_pool_get(pool, 100);
+  ok(reused == buf, "hands the returned buffer back out");
+  eq_str(buffer_state(reused), "", "reused buffer has been cleared");
+  eq_num(buffer_pool_retained(pool), 0,
+         "retained bytes drop once the buffer is handed out");
+
+  buffer_pool_put(pool, reused);
+  buffer_pool_free(pool);
+}
+
+static void test_buffer_pool_retention_cap(void) {
+  size_t classes[] = {64, 128};
+  buffer_pool_t *pool = buffer_pool_init(classes, 2, 200, false);
+
+  buffer_t *a = buffer_pool_get(pool, 100);
+  buffer_t *b = buffer_pool_get(pool, 100);
+  buffer_pool_put(pool, a);
+  buffer_pool_put(pool, b);
+
+  eq_num(buffer_pool_retained(pool), 128,
+         "frees returned buffers that would exceed the retention cap");
+
+  buffer_t *small = buffer_init("tiny");
+  buffer_pool_put(pool, small);
+  eq_num(buffer_pool_retained(pool), 128,
+         "frees returned buffers smaller than every size class");
+
+  buffer_pool_free(pool);
+}
+
+static void test_buffer_pool_default(void) {
+  buffer_t *buf = buffer_pool_get(NULL, 10);
+  buffer_append(buf, "default");
+  eq_str(buffer_state(buf), "default", "the default pool hands out buffers");
+  buffer_pool_put(NULL, buf);
+
+  ok(buffer_pool_default() == buffer_pool_default(),
+     "the default pool is a single process-wide pool");
+}
+
+static void test_buffer_pool_threads(void) {
+  buffer_pool_t *pool = buffer_pool_init(NULL, 0, 32768, true);
+  pthread_t threads[4];
+
+  for (int i = 0; i < 4; i++) {
+    pthread_create(&threads[i], NULL, pool_worker, pool);
+  }
+  for (int i = 0; i < 4; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  ok(buffer_pool_retained(pool) <= 32768,
+     "concurrent use stays within the retention cap");
+
+  buffer_pool_free(pool);
+}
+
+void run_pool_tests(void) {
+  test_buffer_pool_init_invalid();
+  test_buffer_pool_get();
+  test_buffer_pool_reuse();
+  test_buffer_pool_retention_cap();
+  test_buffer_pool_default();
+  test_buffer_pool_threads();
+}
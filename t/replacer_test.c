@@ -0,0 +1,163 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+
+static void test_s_replacer_bytes(void) {
+  array_t *pairs = array_collect("&", "&amp;", "<", "&lt;", ">", "&gt;", "\"",
+                                 "&quot;", "'", "&#39;");
+  s_replacer_t *r = s_replacer_init(pairs);
+  array_free(pairs, NULL);
+
+  char *s = s_replacer_replace(r, "<a href=\"x\">Tom & Jerry's</a>");
+  eq_str(s, "&lt;a href=&quot;x&quot;&gt;Tom &amp; Jerry&#39;s&lt;/a&gt;",
+         "escapes an HTML string");
+  free(s);
+
+  s = s_replacer_replace(r, "plain text");
+  eq_str(s, "plain text", "copies a string with nothing to replace");
+  free(s);
+
+  buffer_t *buf = buffer_init("<p>");
+  ok(s_replacer_append(r, buf, "1 < 2 & 3", 5), "appends with replacements");
+  eq_str(buffer_state(buf), "<p>1 &lt; 2", "appends only the given bytes");
+  buffer_free(buf);
+
+  s_replacer_free(r);
+}
+
+static void test_s_replacer_strings(void) {
+  array_t *pairs =
+      array_collect("a", "1", "ab", "2", "abc", "3", "bc", "4", "cat", "dog");
+  s_replacer_t *r = s_replacer_init(pairs);
+  array_free(pairs, NULL);
+
+  char *s = s_replacer_replace(r, "abc bc cat");
+  eq_str(s, "14 4 dog", "prefers the earliest pair at each index");
+  free(s);
+  s_replacer_free(r);
+
+  pairs = array_collect("ab", "ba", "ba", "ab");
+  r = s_replacer_init(pairs);
+  array_free(pairs, NULL);
+
+  s = s_replacer_replace(r, "abab");
+  eq_str(s, "baba", "does not replace its own output");
+  free(s);
+  s_replacer_free(r);
+
+  pairs = array_collect("a", "b", "c");
+  eq_null(s_replacer_init(pairs), "rejects an odd number of strings");
+  array_free(pairs, NULL);
+
+  pairs = array_collect("", "x");
+  eq_null(s_replacer_init(pairs), "rejects an empty pattern");
+  array_free(pairs, NULL);
+}
+
+// Replaces leftmost first, trying the pairs in order at each index
+static char *naive_replace(array_t *pairs, const char *s) {
+  buffer_t *buf = buffer_init(NULL);
+
+  while (*s) {
+    size_t i = 0;
+    for (; i < array_size(pairs); i += 2) {
+      const char *from = array_get(pairs, i);
+      if (!strncmp(s, from, strlen(from))) {
+        break;
+      }
+    }
+
+    if (i < array_size(pairs)) {
+      buffer_append(buf, array_get(pairs, i + 1));
+      s += strlen(array_get(pairs, i));
+    } else {
+      buffer_append_char(buf, *s);
+      s++;
+    }
+  }
+
+  char *ret = s_copy(buffer_state(buf) ? buffer_state(buf) : "");
+  buffer_free(buf);
+
+  return ret;
+}
+
+// Checks the replacer against naive_replace on random strings of a and b
+static bool replacer_matches_naive(array_t *pairs) {
+  s_replacer_t *r = s_replacer_init(pairs);
+  char s[512];
+  bool all_ok = true;
+
+  for (size_t round = 0; round < 200 && all_ok; round++) {
+    size_t len = rand() % (sizeof(s) - 1);
+    for (size_t i = 0; i < len; i++) {
+      // Long runs of one letter make for many overlapping matches
+      s[i] = rand() % 8 ? (i ? s[i - 1] : 'a') : "ab"[rand() % 2];
+    }
+    s[len] = '\0';
+
+    char *got = s_replacer_replace(r, s);
+    char *want = naive_replace(pairs, s);
+    all_ok = !strcmp(got, want);
+    free(got);
+    free(want);
+  }
+
+  s_replacer_free(r);
+
+  return all_ok;
+}
+
+static void test_s_replacer_overlapping(void) {
+  array_t *pairs = array_collect("aaa", "3", "aa", "2", "a", "1");
+  s_replacer_t *r = s_replacer_init(pairs);
+  array_free(pairs, NULL);
+
+  char run[1001];
+  memset(run, 'a', 1000);
+  run[1000] = '\0';
+
+  char *s = s_replacer_replace(r, run);
+  ok(strlen(s) == 334 && strspn(s, "3") == 333 && s[333] == '1',
+     "replaces a run of nested matches leftmost first");
+  free(s);
+  s_replacer_free(r);
+
+  srand(7);
+
+  pairs = array_collect("ab", "x", "b", "y", "aab", "z", "ba", "", "bbb", "w");
+  ok(replacer_matches_naive(pairs), "matches a naive replace (few patterns)");
+  array_free(pairs, NULL);
+
+  // Enough patterns to use the automaton, one longer than the stack window
+  char long_pattern[81];
+  memset(long_pattern, 'a', 80);
+  long_pattern[80] = '\0';
+
+  pairs = array_init();
+  array_push(pairs, long_pattern);
+  array_push(pairs, "L");
+  for (size_t i = 0; i < 40; i++) {
+    char *from = malloc(6);
+    size_t len = 1 + i % 5;
+    for (size_t j = 0; j < len; j++) {
+      from[j] = "ab"[(i >> j) & 1];
+    }
+    from[len] = '\0';
+
+    array_push(pairs, from);
+    array_push(pairs, i % 2 ? "-" : "+");
+  }
+  ok(replacer_matches_naive(pairs), "matches a naive replace (many patterns)");
+  for (size_t i = 2; i < array_size(pairs); i += 2) {
+    free(array_get(pairs, i));
+  }
+  array_free(pairs, NULL);
+}
+
+void run_replacer_tests(void) {
+  test_s_replacer_bytes();
+  test_s_replacer_strings();
+  test_s_replacer_overlapping();
+}
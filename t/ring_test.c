@@ -0,0 +1,223 @@
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "tests.h"
+
+#define RING_TEST_TRANSFER_SZ (1024 * 1024)
+
+static void *ring_producer(void *arg) {
+  ring_t *ring = arg;
+
+  size_t sent = 0;
+  while (sent < RING_TEST_TRANSFER_SZ) {
+    size_t span;
+    char *dest = ring_reserve(ring, &span);
+    if (!dest) {
+      sched_yield();
+      continue;
+    }
+
+    size_t remaining = RING_TEST_TRANSFER_SZ - sent;
+    size_t n = remaining < span ? remaining : span;
+    for (size_t i = 0; i < n; i++) {
+      dest[i] = (char)((sent + i) % 251);
+    }
+
+    ring_commit(ring, n);
+    sent += n;
+  }
+
+  return NULL;
+}
+
+// Streams a known sequence through the ring from another thread and reports
+// whether every byte arrived in order
+static bool ring_transfer(ring_t *ring) {
+  pthread_t producer;
+  pthread_create(&producer, NULL, ring_producer, ring);
+
+  bool in_order = true;
+  size_t received = 0;
+  while (received < RING_TEST_TRANSFER_SZ) {
+    size_t span;
+    const char *src = ring_peek(ring, &span);
+    if (!src) {
+      sched_yield();
+      continue;
+    }
+
+    for (size_t i = 0; i < span; i++) {
+      in_order = in_order && src[i] == (char)((received + i) % 251);
+    }
+
+    ring_consume(ring, span);
+    received += span;
+  }
+
+  pthread_join(producer, NULL);
+
+  return in_order;
+}
+
+static void test_ring_init(void) {
+  ring_t *ring = ring_init(1000, false);
+
+  eq_num(ring_capacity(ring), 1024, "rounds capacity up to a power of two");
+  eq_num(ring_size(ring), 0, "newly initialized ring is empty");
+  eq_false(ring_is_mirrored(ring), "ring is not mirrored unless requested");
+
+  ring_free(ring);
+
+  eq_null(ring_init(SIZE_MAX, false),
+          "rejects a capacity too large to round up to a power of two");
+}
+
+static void test_ring_write_read(void) {
+  ring_t *ring = ring_init(8, false);
+
+  eq_num(ring_write(ring, "hello world", 11), 8,
+         "writes only as much as the ring can hold");
+
+  size_t len;
+  eq_null(ring_reserve(ring, &len),
+          "reserve returns NULL when the ring is full");
+
+  char out[16] = {0};
+  eq_num(ring_read(ring, out, 5), 5, "reads the requested number of bytes");
+  eq_str(out, "hello", "reads bytes in the order they were written");
+
+  // The next write wraps around the end of the ring's storage
+  ring_write(ring, "abcd", 4);
+  memset(out, 0, sizeof(out));
+  eq_num(ring_read(ring, out, sizeof(out)), 7, "reads across the wrap");
+  eq_str(out, " woabcd", "wrapped bytes arrive in order");
+
+  ring_free(ring);
+}
+
+static void test_ring_spans(void) {
+  ring_t *ring = ring_init(8, false);
+
+  size_t len;
+  char *dest = ring_reserve(ring, &len);
+  eq_num(len, 8, "an empty ring reserves its full capacity");
+
+  memcpy(dest, "abcdef", 6);
+  ring_commit(ring, 6);
+  ring_consume(ring, 6);
+
+  ring_reserve(ring, &len);
+  eq_num(len, 2, "a reserved span stops at the end of unmirrored storage");
+
+  ring_free(ring);
+}
+
+static void test_ring_peek_sees_new_bytes(void) {
+  ring_t *ring = ring_init(16, false);
+
+  size_t len;
+  ring_write(ring, "abc", 3);
+  ring_peek(ring, &len);
+  eq_num(len, 3, "peeks the bytes written so far");
+
+  ring_write(ring, "defgh", 5);
+  const char *src = ring_peek(ring, &len);
+  ok(len == 8 && !memcmp(src, "abcdefgh", 8),
+     "a second peek without consuming sees bytes written since the first");
+
+  ring_free(ring);
+
+  ring = ring_init(16, false);
+
+  char out[16];
+  ring_write(ring, "0123456789abcdef", 16);
+  ring_read(ring, out, 8);
+  ring_write(ring, "ghij", 4);
+  ring_read(ring, out, 8);
+
+  ring_reserve(ring, &len);
+  eq_num(len, 12, "a reserve sees space consumed since the last one");
+
+  ring_free(ring);
+}
+
+static void test_ring_mirrored(void) {
+  ring_t *ring = ring_init(4096, true);
+
+  skip_start(!ring_is_mirrored(ring), 2, "mirrored mappings unavailable");
+
+  size_t cap = ring_capacity(ring);
+  char *fill = malloc(cap);
+  memset(fill, 'x', cap);
+
+  ring_write(ring, fill, cap - 2);
+  char *out = malloc(cap);
+  ring_read(ring, out, cap - 2);
+  ring_write(ring, "wraps", 5);
+
+  size_t len;
+  const char *src = ring_peek(ring, &len);
+  ok(len == 5 && !memcmp(src, "wraps", 5),
+     "a peeked span covers data that wraps around the end of the ring");
+
+  ring_reserve(ring, &len);
+  eq_num(len, cap - 5, "a reserved span covers all free space");
+
+  free(fill);
+  free(out);
+
+  skip_end();
+
+  ring_free(ring);
+}
+
+static void test_ring_fill_fd(void) {
+  ring_t *ring = ring_init(4, false);
+
+  int fds[2];
+  pipe(fds);
+  write(fds[1], "abcdef", 6);
+  close(fds[1]);
+
+  eq_num(ring_fill_fd(ring, fds[0]), 4, "reads into the ring's free space");
+
+  errno = 0;
+  ok(ring_fill_fd(ring, fds[0]) == -1 && errno == ENOBUFS,
+     "fails with ENOBUFS when the ring is full");
+
+  char out[8] = {0};
+  ring_read(ring, out, sizeof(out));
+  eq_num(ring_fill_fd(ring, fds[0]), 2, "reads the remainder");
+  ring_read(ring, out + 4, sizeof(out) - 4);
+  eq_str(out, "abcdef", "bytes from the file descriptor arrive in order");
+
+  eq_num(ring_fill_fd(ring, fds[0]), 0, "returns 0 at end of file");
+
+  close(fds[0]);
+  ring_free(ring);
+}
+
+static void test_ring_threads(void) {
+  ring_t *ring = ring_init(4096, false);
+  ok(ring_transfer(ring), "transfers bytes between threads in order");
+  ring_free(ring);
+
+  ring = ring_init(4096, true);
+  ok(ring_transfer(ring),
+     "transfers bytes between threads in order (mirrored)");
+  ring_free(ring);
+}
+
+void run_ring_tests(void) {
+  test_ring_init();
+  test_ring_write_read();
+  test_ring_spans();
+  test_ring_peek_sees_new_bytes();
+  test_ring_mirrored();
+  test_ring_fill_fd();
+  test_ring_threads();
+}
@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+
+static bool collect_chunk(const char *data, size_t len, void *ctx) {
+  buffer_append_with((buffer_t *)ctx, data, len);
+  return true;
+}
+
+static bool stop_after_first(const char *data, size_t len, void *ctx) {
+  (*(int *)ctx)++;
+  return false;
+}
+
+static void test_rope_init(void) {
+  rope_t *rope = rope_init(0);
+
+  eq_num(rope_size(rope), 0, "newly initialized rope's size is 0");
+  eq_num(rope_num_chunks(rope), 0, "newly initialized rope has no chunks");
+  eq_num(((__rope_t *)rope)->chunk_sz, LIB_UTIL_ROPE_CHUNK_SZ,
+         "uses the default chunk size when given 0");
+
+  rope_free(rope);
+}
+
+static void test_rope_append_spans_chunks(void) {
+  rope_t *rope = rope_init(8);
+
+  rope_append(rope, "abcdefghijklmnopqrstuvwxyz");
+  rope_append_char(rope, '!');
+  rope_append_with(rope, "12345678910", 5);
+
+  eq_num(rope_size(rope), 32, "rope's size is the sum of all appends");
+  eq_num(rope_num_chunks(rope), 4, "rope allocated fixed-size chunks");
+
+  char *flat = rope_flatten(rope);
+  eq_str(flat, "abcdefghijklmnopqrstuvwxyz!12345",
+         "rope holds all appended characters in order");
+
+  free(flat);
+  rope_free(rope);
+}
+
+static void test_rope_append_does_not_move(void) {
+  rope_t *rope = rope_init(4);
+
+  rope_append(rope, "abc");
+  char *first = ((__rope_t *)rope)->head->data;
+  rope_append(rope, "defghijklmnop");
+
+  ok(((__rope_t *)rope)->head->data == first && !memcmp(first, "abcd", 4),
+     "existing bytes are never moved by later appends");
+
+  rope_free(rope);
+}
+
+static void test_rope_foreach_chunk(void) {
+  rope_t *rope = rope_init(5);
+  rope_append(rope, "hello world, hello rope");
+
+  buffer_t *buf = buffer_init(NULL);
+  rope_foreach_chunk(rope, collect_chunk, buf);
+  eq_str(buffer_state(buf), "hello world, hello rope",
+         "iterates every chunk in order");
+
+  int calls = 0;
+  rope_foreach_chunk(rope, stop_after_first, &calls);
+  eq_num(calls, 1, "stops iterating when the callback returns false");
+
+  buffer_free(buf);
+  rope_free(rope);
+}
+
+static void test_rope_write_fd(void) {
+  rope_t *rope = rope_init(16);
+  for (int i = 0; i < 1000; i++) {
+    rope_append(rope, "0123456789");
+  }
+
+  FILE *fp = tmpfile();
+
+  size_t n_written = 0;
+  eq_num(rope_write_file(rope, fp, &n_written), IO_WRITE_ALL_OK,
+         "returns IO_WRITE_ALL_OK on successful write");
+  eq_num(n_written, 10000, "writes every byte of the rope");
+
+  rewind(fp);
+  char *data = NULL;
+  size_t sz = 0;
+  io_read_all(fp, &data, &sz);
+
+  char *flat = rope_flatten(rope);
+  ok(sz == 10000 && !memcmp(data, flat, sz),
+     "written bytes match the rope's contents");
+
+  free(flat);
+  free(data);
+  fclose(fp);
+  rope_free(rope);
+}
+
+static void test_rope_write_fd_invalid(void) {
+  rope_t *rope = rope_init(0);
+  rope_append(rope, "test");
+
+  eq_num(rope_write_fd(rope, -1, NULL), IO_WRITE_ALL_INVALID,
+         "returns IO_WRITE_ALL_INVALID given a bad file descriptor");
+
+  rope_free(rope);
+}
+
+void run_rope_tests(void) {
+  test_rope_init();
+  test_rope_append_spans_chunks();
+  test_rope_append_does_not_move();
+  test_rope_foreach_chunk();
+  test_rope_write_fd();
+  test_rope_write_fd_invalid();
+}
@@ -0,0 +1,235 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+
+static ssize_t naive_indexof(const char *s, size_t len, const char *target,
+                             size_t target_len) {
+  for (size_t i = 0; i + target_len <= len; i++) {
+    if (!memcmp(s + i, target, target_len)) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+static ssize_t naive_indexof_case(const char *s, size_t len, const char *target,
+                                  size_t target_len) {
+  for (size_t i = 0; i + target_len <= len; i++) {
+    if (s_casecmp_n(s + i, target_len, target, target_len)) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+static void test_s_indexof_n(void) {
+  const char data[] = "ab\0cd\0ef";
+
+  eq_num(s_indexof_n(data, sizeof(data) - 1, "\0e", 2), 5,
+         "finds a target containing NUL bytes");
+  eq_num(s_indexof_n(data, 4, "cd", 2), -1,
+         "does not look past the given length");
+  eq_num(s_indexof_n(data, sizeof(data) - 1, "", 0), 0,
+         "finds an empty target at 0");
+  eq_num(s_indexof("hello world", "o w"), 4, "s_indexof finds a substring");
+}
+
+static void test_s_indexof_n_random(void) {
+  // A small alphabet makes partial matches common, and the lengths cover
+  // every vector kernel's block loop and tail
+  char haystack[700];
+  char target[80];
+  bool all_ok = true;
+
+  srand(11);
+  for (int round = 0; round < 2000 && all_ok; round++) {
+    size_t len = rand() % sizeof(haystack);
+    size_t target_len = 1 + rand() % 70;
+    for (size_t i = 0; i < len; i++) {
+      haystack[i] = 'a' + rand() % 3;
+    }
+
+    // Usually plant the target somewhere so there is something to find
+    for (size_t i = 0; i < target_len; i++) {
+      target[i] = 'a' + rand() % 3;
+    }
+    if (rand() % 4 && target_len <= len) {
+      memcpy(haystack + rand() % (len - target_len + 1), target, target_len);
+    }
+
+    all_ok = s_indexof_n(haystack, len, target, target_len) ==
+             naive_indexof(haystack, len, target, target_len);
+  }
+  ok(all_ok, "agrees with a naive search for short and long targets");
+
+  // Letters in mixed case, plus '@' and '`', which differ from 'A' and 'a'
+  // only in the case bit
+  const char alphabet[] = "aAbB@`";
+  all_ok = true;
+  for (int round = 0; round < 2000 && all_ok; round++) {
+    size_t len = rand() % sizeof(haystack);
+    size_t target_len = 1 + rand() % 70;
+    for (size_t i = 0; i < len; i++) {
+      haystack[i] = alphabet[rand() % 6];
+    }
+
+    for (size_t i = 0; i < target_len; i++) {
+      target[i] = alphabet[rand() % 6];
+    }
+    if (rand() % 4 && target_len <= len) {
+      memcpy(haystack + rand() % (len - target_len + 1), target, target_len);
+    }
+
+    all_ok = s_indexof_case_n(haystack, len, target, target_len) ==
+             naive_indexof_case(haystack, len, target, target_len);
+  }
+  ok(all_ok, "agrees with a naive case-insensitive search");
+}
+
+static void test_two_way_periodic(void) {
+  // The worst case for the first/last-byte filter: every position matches
+  // the needle's first and last bytes
+  size_t len = 1 << 16;
+  char *haystack = malloc(len);
+  memset(haystack, 'a', len);
+
+  char target[64];
+  memset(target, 'a', sizeof(target));
+  target[sizeof(target) / 2] = 'b';
+
+  eq_num(s_indexof_n(haystack, len, target, sizeof(target)), -1,
+         "rejects a periodic haystack without a match");
+
+  haystack[len - sizeof(target) / 2] = 'b';
+  eq_num(s_indexof_n(haystack, len, target, sizeof(target)),
+         len - sizeof(target), "finds a long target at the very end");
+
+  free(haystack);
+}
+
+static void test_s_indexof_case(void) {
+  eq_num(s_indexof_case("Content-Type: text/HTML", "text/html"), 14,
+         "finds a substring ignoring case");
+  eq_num(s_indexof_case("user@example.com", "`"), -1,
+         "does not treat non-letters as case variants");
+  eq_num(s_indexof_case("X-FORWARDED-FOR", "forwarded-"), 2,
+         "finds a lowercase target in uppercase text");
+
+  sv_t line = sv_from_n("Host: a\r\nHOST: b", 7);
+  eq_num(sv_indexof_case(line, sv_from("host: b")), -1,
+         "does not look past the end of a view");
+  eq_num(sv_indexof_case(sv_from("Keep-Alive"), sv_from("ALIVE")), 5,
+         "finds a target in a view");
+
+  // Long enough for Two-Way, in a haystack that defeats the filter
+  size_t len = 1 << 14;
+  char *haystack = malloc(len);
+  for (size_t i = 0; i < len; i++) {
+    haystack[i] = i % 2 ? 'a' : 'A';
+  }
+  haystack[len - 20] = 'b';
+  eq_num(s_indexof_case_n(haystack, len,
+                          "AAAAAAAAAAAAAAAAAAAABaaaaaaaaaaaaaaaaaaa", 40),
+         len - 40, "finds a long target in a periodic haystack");
+  free(haystack);
+}
+
+static void test_s_indexof_all(void) {
+  array_t *indices = s_indexof_all("aaaa, aa", "aa");
+  ok(array_size(indices) == 3 && (size_t)array_get(indices, 0) == 0 &&
+         (size_t)array_get(indices, 1) == 2 &&
+         (size_t)array_get(indices, 2) == 6,
+     "finds every non-overlapping occurrence");
+  array_free(indices, NULL);
+
+  indices = s_indexof_all("abc", "");
+  eq_num(array_size(indices), 0, "an empty target has no occurrences");
+  array_free(indices, NULL);
+
+  eq_num(s_count("the cat sat on the mat", "at"), 3, "counts occurrences");
+  eq_num(s_count("aaaaa", "aa"), 2, "counts non-overlapping occurrences");
+  eq_num(s_count("abc", "d"), 0, "counts no occurrences");
+}
+
+static void test_s_replace_all(void) {
+  char *s = s_replace_all("a,b,,c", ",", ", ");
+  eq_str(s, "a, b, , c", "replaces every occurrence");
+  free(s);
+
+  s = s_replace_all("aaaaa", "aa", "b");
+  eq_str(s, "bba", "replaces non-overlapping occurrences left to right");
+  free(s);
+
+  s = s_replace_all("/usr/local/lib", "/local", "");
+  eq_str(s, "/usr/lib", "replaces with an empty string");
+  free(s);
+
+  s = s_replace_all("abc", "", "x");
+  eq_str(s, "abc", "an empty target matches nothing");
+  free(s);
+
+  s = s_replace("one two two", "two", "2");
+  eq_str(s, "one 2 two", "s_replace replaces only the first occurrence");
+  free(s);
+
+  eq_null(s_replace_all(NULL, "a", "b"), "rejects a NULL string");
+
+  // More matches than fit on the stack
+  buffer_t *in = buffer_init(NULL);
+  buffer_t *expected = buffer_init(NULL);
+  for (int i = 0; i < 500; i++) {
+    buffer_append(in, "k=v;");
+    buffer_append(expected, "k: v;");
+  }
+  s = s_replace_all(buffer_state(in), "=", ": ");
+  eq_str(s, buffer_state(expected), "replaces many occurrences");
+  free(s);
+
+  buffer_t *buf = buffer_init("> ");
+  ok(buffer_append_replaced(buf, buffer_state(in), 8, "=", ": "),
+     "appends with replacements");
+  eq_str(buffer_state(buf), "> k: v;k: v;", "appends only the given bytes");
+
+  buffer_free(buf);
+  buffer_free(expected);
+  buffer_free(in);
+}
+
+static void test_s_needle(void) {
+  const char *lines = "GET /a\nPOST /b\nGET /c\n";
+  s_needle_t *needle = s_needle_init("GET ", 4);
+
+  size_t offset = 0;
+  size_t n = 0;
+  ssize_t idx;
+  while ((idx = s_needle_find(needle, lines + offset,
+                              strlen(lines) - offset)) >= 0) {
+    offset += idx + s_needle_len(needle);
+    n++;
+  }
+  eq_num(n, 2, "finds a precompiled needle repeatedly");
+  s_needle_free(needle);
+
+  char long_target[] = "a needle long enough to be searched with Two-Way";
+  needle = s_needle_init(long_target, strlen(long_target));
+  long_target[0] = 'A';
+  eq_num(s_needle_find(needle, "xx a needle long enough to be searched "
+                               "with Two-Way",
+                       51),
+         3, "searches for its own copy of the pattern");
+  s_needle_free(needle);
+}
+
+void run_search_tests(void) {
+  test_s_indexof_n();
+  test_s_indexof_n_random();
+  test_two_way_periodic();
+  test_s_indexof_case();
+  test_s_indexof_all();
+  test_s_replace_all();
+  test_s_needle();
+}
@@ -0,0 +1,134 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+
+static void *shared_consumer(void *arg) {
+  shared_buffer_t *sb = arg;
+
+  size_t sum = 0;
+  for (size_t i = 0; i < shared_buffer_size(sb); i++) {
+    sum += shared_buffer_state(sb)[i];
+  }
+
+  shared_buffer_release(sb);
+  return (void *)sum;
+}
+
+static void test_shared_buffer_init(void) {
+  shared_buffer_t *sb = shared_buffer_init("payload", 7);
+
+  eq_str(shared_buffer_state(sb), "payload", "holds a copy of the data");
+  eq_num(shared_buffer_size(sb), 7, "shared buffer's size is the data size");
+  eq_num(shared_buffer_refcount(sb), 1, "starts with a single reference");
+
+  shared_buffer_release(sb);
+}
+
+static void test_shared_buffer_from_buffer(void) {
+  buffer_t *buf = buffer_init("from a buffer");
+  shared_buffer_t *sb = shared_buffer_from_buffer(buf);
+
+  eq_str(shared_buffer_state(sb), "from a buffer",
+         "holds a copy of the buffer's contents");
+
+  buffer_free(buf);
+  shared_buffer_release(sb);
+}
+
+static void test_shared_buffer_retain(void) {
+  shared_buffer_t *sb = shared_buffer_init("payload", 7);
+  shared_buffer_t *other = shared_buffer_retain(sb);
+
+  ok(other == sb, "retaining shares the same buffer");
+  eq_num(shared_buffer_refcount(sb), 2, "retaining increments the refcount");
+
+  shared_buffer_release(other);
+  eq_num(shared_buffer_refcount(sb), 1, "releasing decrements the refcount");
+
+  shared_buffer_release(sb);
+}
+
+static void test_shared_buffer_mut_unique(void) {
+  shared_buffer_t *sb = shared_buffer_init("payload", 7);
+  shared_buffer_t *before = sb;
+
+  char *state = shared_buffer_mut(&sb);
+  state[0] = 'P';
+
+  ok(sb == before, "a unique reference is mutated in place");
+  eq_str(shared_buffer_state(sb), "Payload", "the mutation is visible");
+
+  shared_buffer_release(sb);
+}
+
+static void test_shared_buffer_mut_shared(void) {
+  shared_buffer_t *original = shared_buffer_init("payload", 7);
+  shared_buffer_t *mine = shared_buffer_retain(original);
+
+  char *state = shared_buffer_mut(&mine);
+  state[0] = 'P';
+
+  ok(mine != original, "a shared reference is copied before mutation");
+  eq_str(shared_buffer_state(original), "payload",
+         "other holders don't observe the mutation");
+  eq_str(shared_buffer_state(mine), "Payload", "the copy holds the mutation");
+  eq_num(shared_buffer_refcount(original), 1,
+         "the original loses the copier's reference");
+
+  shared_buffer_release(mine);
+  shared_buffer_release(original);
+}
+
+static void test_shared_buffer_append(void) {
+  shared_buffer_t *original = shared_buffer_init("hello", 5);
+  shared_buffer_t *mine = shared_buffer_retain(original);
+
+  eq_true(shared_buffer_append(&mine, " world", 6), "appends to a shared copy");
+  eq_str(shared_buffer_state(mine), "hello world", "the copy holds the append");
+  eq_str(shared_buffer_state(original), "hello", "the original is unchanged");
+
+  shared_buffer_append(&mine, "!", 1);
+  eq_str(shared_buffer_state(mine), "hello world!",
+         "appends to a unique buffer in place");
+
+  shared_buffer_release(mine);
+  shared_buffer_release(original);
+}
+
+static void test_shared_buffer_threads(void) {
+  char payload[4096];
+  memset(payload, 'x', sizeof(payload));
+
+  shared_buffer_t *sb = shared_buffer_init(payload, sizeof(payload));
+  pthread_t threads[8];
+
+  for (int i = 0; i < 8; i++) {
+    pthread_create(&threads[i], NULL, shared_consumer,
+                   shared_buffer_retain(sb));
+  }
+
+  bool all_read = true;
+  for (int i = 0; i < 8; i++) {
+    void *sum;
+    pthread_join(threads[i], &sum);
+    all_read = all_read && (size_t)sum == 'x' * sizeof(payload);
+  }
+
+  ok(all_read, "every consumer thread reads the full payload");
+  eq_num(shared_buffer_refcount(sb), 1,
+         "consumer threads release their references");
+
+  shared_buffer_release(sb);
+}
+
+void run_shared_tests(void) {
+  test_shared_buffer_init();
+  test_shared_buffer_from_buffer();
+  test_shared_buffer_retain();
+  test_shared_buffer_mut_unique();
+  test_shared_buffer_mut_shared();
+  test_shared_buffer_append();
+  test_shared_buffer_threads();
+}
@@ -62,6 +62,64 @@ static void test_s_concat(void) {
   char *ret = s_concat("hello", " world");
   eq_str(ret, "hello world", "concatenates the provided strings");
   free(ret);
+
+  ret = s_concat("a", "much longer second string");
+  eq_str(ret, "amuch longer second string",
+         "concatenates a second string longer than the first");
+  free(ret);
+}
+
+static void test_s_concat_n(void) {
+  char *ret = s_concat_n(4, "/usr", "/", "local", "/bin");
+  eq_str(ret, "/usr/local/bin", "concatenates every string");
+  free(ret);
+
+  ret = s_concat_n(3, "a", NULL, "b");
+  eq_str(ret, "ab", "skips NULL strings");
+  free(ret);
+
+  ret = s_concat_n(0);
+  eq_str(ret, "", "concatenates no strings");
+  free(ret);
+}
+
+static void test_s_join(void) {
+  array_t *arr = array_collect("GET", "/index.html", "HTTP/1.1");
+  char *ret = s_join(arr, " ");
+  eq_str(ret, "GET /index.html HTTP/1.1", "joins an array with a delimiter");
+  free(ret);
+
+  ret = s_join(arr, NULL);
+  eq_str(ret, "GET/index.htmlHTTP/1.1", "joins without a delimiter");
+  free(ret);
+  array_free(arr, NULL);
+
+  arr = array_init();
+  ret = s_join(arr, ", ");
+  eq_str(ret, "", "joins an empty array into an empty string");
+  free(ret);
+  array_free(arr, NULL);
+
+  sv_t views[] = {sv_from_n("key=value", 3), sv_from(""), sv_from("b")};
+  ret = s_join_views(views, 3, ", ");
+  eq_str(ret, "key, , b", "joins views by their lengths");
+  free(ret);
+
+  ret = s_join_views(views, 3, NULL);
+  eq_str(ret, "keyb", "joins views without a delimiter");
+  free(ret);
+
+  // More pieces than there's room to measure on the stack
+  arr = array_init();
+  for (size_t i = 0; i < 100; i++) {
+    array_push(arr, "ab");
+  }
+  ret = s_join(arr, "-");
+  ok(strlen(ret) == 299 && !strncmp(ret, "ab-ab-", 6) &&
+         !strcmp(ret + 294, "ab-ab"),
+     "joins more pieces than are measured on the stack");
+  free(ret);
+  array_free(arr, NULL);
 }
 
 static void test_s_concat_arr(void) {
@@ -183,6 +241,62 @@ static void test_s_upper(void) {
   free(ret);
 }
 
+static void test_s_lower(void) {
+  char *ret = s_lower("Content-TYPE: 42");
+  eq_str(ret, "content-type: 42", "lower-cases the string");
+  free(ret);
+
+  char s[] = "X-Request-ID";
+  eq_str(s_upper_inplace(s), "X-REQUEST-ID", "upper-cases in place");
+  eq_str(s_lower_inplace(s), "x-request-id", "lower-cases in place");
+
+  char out[8] = "........";
+  s_upper_into(out, "accept", 6);
+  ok(!memcmp(out, "ACCEPT..", 8), "upper-cases into a caller's array");
+}
+
+static void test_s_case_all_bytes(void) {
+  // Every byte value at every offset within and after a vector block,
+  // including the ones just outside each letter range
+  char src[300], upper[300], lower[300];
+  for (size_t i = 0; i < sizeof(src); i++) {
+    src[i] = (char)(i * 7 + 3);
+  }
+
+  s_upper_into(upper, src, sizeof(src));
+  s_lower_into(lower, src, sizeof(src));
+
+  bool all_ok = true;
+  for (size_t i = 0; i < sizeof(src); i++) {
+    unsigned char c = src[i];
+    bool is_upper = c >= 'A' && c <= 'Z';
+    bool is_lower = c >= 'a' && c <= 'z';
+
+    all_ok = all_ok && (unsigned char)upper[i] == (is_lower ? c - 32 : c) &&
+             (unsigned char)lower[i] == (is_upper ? c + 32 : c);
+  }
+  ok(all_ok, "converts only ASCII letters");
+
+  eq_true(s_casecmp_n(upper, sizeof(upper), lower, sizeof(lower)),
+          "compares long strings ignoring case");
+
+  lower[250] ^= 1;
+  eq_false(s_casecmp_n(upper, sizeof(upper), lower, sizeof(lower)),
+           "finds a difference past the first vector block");
+  eq_true(s_casecompare_n(upper, sizeof(upper), lower, sizeof(lower)) != 0,
+          "orders strings that differ past the first vector block");
+}
+
+static void test_s_casecompare_n(void) {
+  eq_num(s_casecompare_n("Accept", 6, "accept", 6), 0, "ignores case");
+  ok(s_casecompare_n("Accept", 6, "Accept-Encoding", 15) < 0,
+     "orders a prefix first");
+  ok(s_casecompare_n("HOST", 4, "accept", 6) > 0,
+     "orders by the first differing letter");
+  eq_false(s_casecmp_n("Host", 4, "Host\0", 5),
+           "strings of different lengths are not equal");
+}
+
 static void test_s_equals(void) {
   const char *s1 = "hello";
   const char *s2 = "hello";
@@ -271,6 +385,15 @@ static void test_s_copy(void) {
   free(cp);
 }
 
+static void test_s_trim_inplace(void) {
+  char s[] = " \t cookie \n";
+  ok(s_trim_inplace(s) == s && !strcmp(s, "cookie"),
+     "trims a string in place");
+
+  char blank[] = "   ";
+  eq_str(s_trim_inplace(blank), "", "trims an all-whitespace string to empty");
+}
+
 static void test_s_split_ok(void) {
   char *test_str = "aa:b:c:d";
   array_t *paths = s_split(test_str, ":");
@@ -313,6 +436,16 @@ static void test_s_split_end_match(void) {
   array_free(paths, free);
 }
 
+static void test_s_split_multichar(void) {
+  array_t *parts = s_split("a, b,, c", ", ");
+
+  eq_num(array_size(parts), 3, "splits on the whole delimiter string");
+  eq_str(array_get(parts, 1), "b,", "characters of the delimiter alone do "
+                                    "not split");
+
+  array_free(parts, free);
+}
+
 static void test_s_fmt(void) {
   char *formatted = s_fmt("%s %d %s", "test", 11, "string");
   eq_str(formatted, "test 11 string", "formats each part into a single string");
@@ -320,6 +453,35 @@ static void test_s_fmt(void) {
   free(formatted);
 }
 
+static void test_s_fmt_long(void) {
+  char long_arg[1000];
+  memset(long_arg, 'x', sizeof(long_arg) - 1);
+  long_arg[sizeof(long_arg) - 1] = '\0';
+
+  char *formatted = s_fmt("[%s]", long_arg);
+  ok(strlen(formatted) == 1001 && formatted[0] == '[' &&
+         formatted[1000] == ']',
+     "formats a string longer than the scratch buffer");
+  free(formatted);
+}
+
+static void test_s_fmt_into(void) {
+  char key[16];
+
+  char *s = s_fmt_into(key, sizeof(key), "user:%d", 42);
+  ok(s == key, "formats into the given buffer when the output fits");
+  eq_str(s, "user:42", "formats the output");
+
+  s = s_fmt_into(key, sizeof(key), "user:%d:%s", 42, "preferences");
+  ok(s != key, "allocates when the output does not fit");
+  eq_str(s, "user:42:preferences", "formats the whole output");
+  free(s);
+
+  s = s_fmt_into(NULL, 0, "%s", "x");
+  eq_str(s, "x", "allocates when given no buffer");
+  free(s);
+}
+
 void run_str_tests(void) {
   test_s_copy();
 
@@ -332,6 +494,8 @@ void run_str_tests(void) {
 
   test_s_concat();
   test_s_concat_arr();
+  test_s_concat_n();
+  test_s_join();
 
   test_s_indexof_ok();
   test_s_indexof_no_match();
@@ -344,6 +508,9 @@ void run_str_tests(void) {
   test_s_casecmp();
 
   test_s_upper();
+  test_s_lower();
+  test_s_case_all_bytes();
+  test_s_casecompare_n();
 
   test_s_equals();
   test_s_equals_diff_case();
@@ -351,11 +518,15 @@ void run_str_tests(void) {
   test_s_equals_one_null();
 
   test_s_trim();
+  test_s_trim_inplace();
 
   test_s_split_ok();
   test_s_split_no_match();
   test_s_split_empty_input();
   test_s_split_end_match();
+  test_s_split_multichar();
 
   test_s_fmt();
+  test_s_fmt_long();
+  test_s_fmt_into();
 }
@@ -0,0 +1,146 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+
+static void test_strtab_push_get(void) {
+  strtab_t *tab = strtab_init();
+
+  eq_num(strtab_size(tab), 0, "newly initialized table is empty");
+
+  strtab_push(tab, "hello", 5);
+  strtab_push(tab, "", 0);
+  strtab_push(tab, "wor\0ld", 6);
+
+  eq_num(strtab_size(tab), 3, "counts pushed strings");
+  eq_str(strtab_get(tab, 0), "hello", "stores NUL-terminated copies");
+  eq_str(strtab_get(tab, 1), "", "stores empty strings");
+
+  sv_t sv = strtab_get_sv(tab, 2);
+  ok(sv.len == 6 && !memcmp(sv.ptr, "wor\0ld", 6),
+     "keeps embedded NULs in views");
+  eq_null(strtab_get(tab, 3), "returns NULL for an out-of-bounds index");
+
+  strtab_free(tab);
+}
+
+static void test_strtab_growth(void) {
+  strtab_t *tab = strtab_init();
+
+  char s[16];
+  for (int i = 0; i < 1000; i++) {
+    snprintf(s, sizeof(s), "token%d", i);
+    strtab_push(tab, s, strlen(s));
+  }
+
+  ok(strtab_size(tab) == 1000 && !strcmp(strtab_get(tab, 0), "token0") &&
+         !strcmp(strtab_get(tab, 999), "token999"),
+     "grows to hold many strings");
+
+  strtab_free(tab);
+}
+
+static void test_strtab_to_array(void) {
+  strtab_t *tab = s_split_table("a,bb,,ccc", ",");
+  array_t *array = strtab_to_array(tab);
+
+  eq_num(array_size(array), 3, "array holds every string");
+  eq_str(array_get(array, 2), "ccc", "array elements are the strings");
+  ok(array_get(array, 1) == strtab_get(tab, 1),
+     "array elements point into the table");
+
+  array_free(array, NULL);
+  strtab_free(tab);
+}
+
+static void test_split_table(void) {
+  strtab_t *tab = s_split_table("a/b", ":");
+  eq_num(strtab_size(tab), 0, "is empty if the delimiter does not occur");
+  strtab_free(tab);
+
+  tab = sv_split_table(sv_from("x||y||"), sv_from("||"), true);
+  ok(strtab_size(tab) == 3 && !strcmp(strtab_get(tab, 1), "y") &&
+         !strcmp(strtab_get(tab, 2), ""),
+     "keeps empty tokens when asked to");
+  strtab_free(tab);
+}
+
+static void test_strtab_append(void) {
+  strtab_t *tab = s_split_table("a,b", ",");
+  strtab_t *other = s_split_table("c,,dd", ",");
+
+  ok(strtab_append(tab, other) && strtab_size(tab) == 4 &&
+         !strcmp(strtab_get(tab, 2), "c") && strtab_get_sv(tab, 3).len == 2,
+     "appends another table's strings in order");
+  eq_num(strtab_size(other), 2, "leaves the appended table as-is");
+
+  strtab_free(other);
+  strtab_free(tab);
+}
+
+static bool strtab_test_equal(strtab_t *a, strtab_t *b) {
+  if (!a || !b || strtab_size(a) != strtab_size(b)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < strtab_size(a); i++) {
+    if (!sv_equals(strtab_get_sv(a, i), strtab_get_sv(b, i))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static void test_par_split(void) {
+  // Large enough for several chunks, with runs of delimiters (and so empty
+  // tokens) likely to straddle the cut points
+  buffer_t *buf = buffer_init(NULL);
+  srand(7);
+  while (buffer_size(buf) < 4 * LIB_UTIL_PAR_SPLIT_MIN_CHUNK + 123) {
+    buffer_append(buf, rand() % 4 ? "field" : "");
+    buffer_append(buf, rand() % 2 ? "\r\n" : "\r\n\r\n");
+  }
+  sv_t input = sv_from_buffer(buf);
+
+  strtab_t *expected = sv_split_table(input, sv_from("\r\n"), true);
+  strtab_t *tab = sv_par_split(input, sv_from("\r\n"), true, 4);
+  ok(strtab_test_equal(tab, expected),
+     "matches a sequential split, keeping empty tokens");
+  strtab_free(tab);
+  strtab_free(expected);
+
+  expected = s_split_table(buffer_state(buf), "\r\n");
+  tab = s_par_split(buffer_state(buf), "\r\n", 0);
+  ok(strtab_test_equal(tab, expected),
+     "matches a sequential split, skipping empty tokens");
+  strtab_free(tab);
+  strtab_free(expected);
+
+  // Only the first chunk has a delimiter, so the others are merged into it
+  buffer_state(buf)[0] = ';';
+  expected = sv_split_table(input, sv_from(";"), true);
+  tab = sv_par_split(input, sv_from(";"), true, 4);
+  ok(strtab_test_equal(tab, expected) && strtab_size(tab) == 2,
+     "handles chunks with no delimiter");
+  strtab_free(tab);
+  strtab_free(expected);
+
+  expected = sv_split_table(input, sv_from("\n\r\n"), true);
+  tab = sv_par_split(input, sv_from("\n\r\n"), true, 4);
+  ok(strtab_test_equal(tab, expected),
+     "matches a sequential split on a self-overlapping delimiter");
+  strtab_free(tab);
+  strtab_free(expected);
+
+  buffer_free(buf);
+}
+
+void run_strtab_tests(void) {
+  test_strtab_push_get();
+  test_strtab_growth();
+  test_strtab_to_array();
+  test_split_table();
+  test_strtab_append();
+  test_par_split();
+}
@@ -0,0 +1,169 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+
+static void test_sv_from(void) {
+  sv_t sv = sv_from("hello");
+  ok(sv.len == 5 && !memcmp(sv.ptr, "hello", 5), "views a string");
+
+  sv = sv_from(NULL);
+  ok(sv.ptr == NULL && sv.len == 0, "views NULL as empty");
+
+  buffer_t *buf = buffer_init("buffered");
+  eq_true(sv_equals(sv_from_buffer(buf), sv_from("buffered")),
+          "views a buffer's contents");
+  buffer_free(buf);
+}
+
+static void test_sv_trim(void) {
+  const char *s = " \t hello world \r\n";
+  sv_t trimmed = sv_trim(sv_from(s));
+
+  ok(trimmed.ptr == s + 3 && trimmed.len == 11,
+     "trims whitespace without copying");
+  eq_true(sv_equals(sv_trim_left(sv_from("  a ")), sv_from("a ")),
+          "trims leading whitespace only");
+  eq_true(sv_equals(sv_trim_right(sv_from("  a ")), sv_from("  a")),
+          "trims trailing whitespace only");
+  eq_num(sv_trim(sv_from(" \n\t ")).len, 0, "trims all-whitespace to empty");
+}
+
+static void test_sv_substr(void) {
+  sv_t sv = sv_from("hello world");
+
+  eq_true(sv_equals(sv_substr(sv, 6, 11), sv_from("world")),
+          "returns the view between two indices");
+  eq_true(sv_equals(sv_substr(sv, 6, 100), sv_from("world")),
+          "clamps the end index");
+  eq_num(sv_substr(sv, 8, 3).len, 0, "returns an empty view for a bad range");
+}
+
+static void test_sv_indexof(void) {
+  sv_t sv = sv_from("the cat sat on the mat");
+
+  eq_num(sv_indexof(sv, sv_from("sat")), 8, "finds a substring");
+  eq_num(sv_indexof(sv, sv_from("dog")), -1, "returns -1 if not found");
+  eq_num(sv_indexof(sv_substr(sv, 0, 9), sv_from("sat")), -1,
+         "does not look past the end of the view");
+  eq_num(sv_indexof(sv, sv_from("")), 0, "finds an empty target at 0");
+}
+
+static void test_sv_split_next(void) {
+  sv_t input = sv_from("a,,bc,");
+  sv_t delim = sv_from(",");
+  sv_t token;
+  const char *expected[] = {"a", "", "bc", ""};
+
+  bool all_ok = true;
+  size_t n = 0;
+  while (sv_split_next(&input, delim, &token)) {
+    all_ok = all_ok && n < 4 && sv_equals(token, sv_from(expected[n]));
+    n++;
+  }
+  ok(all_ok && n == 4, "splits into every field, keeping empty ones");
+
+  input = sv_from("key => value => more");
+  sv_split_next(&input, sv_from(" => "), &token);
+  ok(sv_equals(token, sv_from("key")) &&
+         sv_equals(input, sv_from("value => more")),
+     "splits on a multi-character delimiter");
+
+  input = sv_from("no delimiter");
+  ok(sv_split_next(&input, delim, &token) &&
+         sv_equals(token, sv_from("no delimiter")) &&
+         !sv_split_next(&input, delim, &token),
+     "yields the whole input when there is no delimiter");
+}
+
+// Collects up to 8 tokens into `out`, returning how many there were
+static size_t sv_test_tokens(sv_tokenizer_t *tokenizer, sv_t *out) {
+  size_t n = 0;
+  sv_t token;
+  while (sv_tokenizer_next(tokenizer, &token)) {
+    if (n < 8) {
+      out[n] = token;
+    }
+    n++;
+  }
+
+  return n;
+}
+
+static void test_sv_tokenizer(void) {
+  sv_t tokens[8];
+
+  sv_tokenizer_t tokenizer =
+      sv_tokenizer_init(sv_from("::a::::bc::"), sv_from("::"), false);
+  ok(sv_test_tokens(&tokenizer, tokens) == 2 &&
+         sv_equals(tokens[0], sv_from("a")) &&
+         sv_equals(tokens[1], sv_from("bc")),
+     "skips empty tokens between multi-character delimiters");
+
+  tokenizer = sv_tokenizer_init(sv_from("::a::::bc::"), sv_from("::"), true);
+  ok(sv_test_tokens(&tokenizer, tokens) == 5 && tokens[0].len == 0 &&
+         sv_equals(tokens[1], sv_from("a")) && tokens[2].len == 0 &&
+         sv_equals(tokens[3], sv_from("bc")) && tokens[4].len == 0,
+     "keeps empty tokens when asked to");
+
+  // Two tokenizers interleaved, as strtok could not do
+  sv_tokenizer_t outer =
+      sv_tokenizer_init(sv_from("a=1;b=2"), sv_from(";"), false);
+  sv_t pair, key;
+  size_t n = 0;
+  bool all_ok = true;
+  while (sv_tokenizer_next(&outer, &pair)) {
+    sv_tokenizer_t inner = sv_tokenizer_init(pair, sv_from("="), false);
+    all_ok = all_ok && sv_tokenizer_next(&inner, &key) && key.len == 1;
+    n++;
+  }
+  ok(all_ok && n == 2, "tokenizers are independent of one another");
+}
+
+static void test_sv_indexof_long(void) {
+  // Near-misses sharing the needle's first and last bytes span several
+  // 16-byte blocks before the real match
+  buffer_t *buf = buffer_init(NULL);
+  for (int i = 0; i < 20; i++) {
+    buffer_append(buf, "<delimitex>");
+  }
+  buffer_append(buf, "<delimiter>");
+  buffer_append(buf, "tail");
+
+  eq_num(sv_indexof(sv_from_buffer(buf), sv_from("<delimiter>")), 220,
+         "finds a needle after many partial matches");
+  eq_num(sv_indexof(sv_from_buffer(buf), sv_from("tail")), 231,
+         "finds a needle at the very end");
+  eq_num(sv_indexof(sv_from_buffer(buf), sv_from("<delimitez>")), -1,
+         "does not report partial matches");
+
+  buffer_free(buf);
+}
+
+static void test_sv_equals(void) {
+  eq_true(sv_equals(sv_from_n("abcdef", 3), sv_from("abc")),
+          "compares only the viewed bytes");
+  eq_false(sv_equals(sv_from("abc"), sv_from("abd")), "detects differences");
+  eq_true(sv_casecmp(sv_from("Hello"), sv_from("hELLO")),
+          "compares ignoring case");
+  eq_false(sv_casecmp(sv_from("Hello"), sv_from("Hell")),
+           "views of different lengths are not equal");
+}
+
+static void test_sv_to_owned(void) {
+  char *owned = sv_to_owned(sv_from_n("hello world", 5));
+  eq_str(owned, "hello", "copies the viewed bytes into a new string");
+  free(owned);
+}
+
+void run_sv_tests(void) {
+  test_sv_from();
+  test_sv_trim();
+  test_sv_substr();
+  test_sv_indexof();
+  test_sv_split_next();
+  test_sv_tokenizer();
+  test_sv_indexof_long();
+  test_sv_equals();
+  test_sv_to_owned();
+}
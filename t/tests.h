@@ -9,5 +9,21 @@ void run_buffer_tests(void);
 void run_str_tests(void);
 void run_io_tests(void);
 void run_file_tests(void);
+void run_rope_tests(void);
+void run_pool_tests(void);
+void run_shared_tests(void);
+void run_ring_tests(void);
+void run_binary_tests(void);
+void run_encoding_tests(void);
+void run_hash_tests(void);
+void run_lz_tests(void);
+void run_sv_tests(void);
+void run_strtab_tests(void);
+void run_search_tests(void);
+void run_matcher_tests(void);
+void run_intern_tests(void);
+void run_hashmap_tests(void);
+void run_replacer_tests(void);
+void run_utf8_tests(void);
 
 #endif /* TESTS_H */
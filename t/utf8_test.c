@@ -0,0 +1,168 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests.h"
+
+// Decodes one code point at a time, by the definition of UTF-8 in RFC 3629
+static bool naive_utf8_valid(const unsigned char *s, size_t len) {
+  size_t i = 0;
+
+  while (i < len) {
+    size_t n;
+    unsigned long cp;
+
+    if (s[i] < 0x80) {
+      i++;
+      continue;
+    } else if ((s[i] & 0xe0) == 0xc0) {
+      n = 2;
+      cp = s[i] & 0x1f;
+    } else if ((s[i] & 0xf0) == 0xe0) {
+      n = 3;
+      cp = s[i] & 0x0f;
+    } else if ((s[i] & 0xf8) == 0xf0) {
+      n = 4;
+      cp = s[i] & 0x07;
+    } else {
+      return false;
+    }
+
+    if (len - i < n) {
+      return false;
+    }
+
+    for (size_t k = 1; k < n; k++) {
+      if ((s[i + k] & 0xc0) != 0x80) {
+        return false;
+      }
+      cp = cp << 6 | (s[i + k] & 0x3f);
+    }
+
+    const unsigned long min[] = {0, 0, 0x80, 0x800, 0x10000};
+    if (cp < min[n] || cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff)) {
+      return false;
+    }
+
+    i += n;
+  }
+
+  return true;
+}
+
+static size_t utf8_test_encode(unsigned long cp, unsigned char *out) {
+  if (cp < 0x80) {
+    out[0] = cp;
+    return 1;
+  } else if (cp < 0x800) {
+    out[0] = 0xc0 | cp >> 6;
+    out[1] = 0x80 | (cp & 0x3f);
+    return 2;
+  } else if (cp < 0x10000) {
+    out[0] = 0xe0 | cp >> 12;
+    out[1] = 0x80 | (cp >> 6 & 0x3f);
+    out[2] = 0x80 | (cp & 0x3f);
+    return 3;
+  }
+
+  out[0] = 0xf0 | cp >> 18;
+  out[1] = 0x80 | (cp >> 12 & 0x3f);
+  out[2] = 0x80 | (cp >> 6 & 0x3f);
+  out[3] = 0x80 | (cp & 0x3f);
+  return 4;
+}
+
+static void test_s_utf8_valid(void) {
+  const char *valid[] = {
+      "", "plain ASCII", "caf\xc3\xa9", "\xe2\x82\xac 10",
+      "\xf0\x9f\x98\x80", "\xef\xbf\xbf", "\xf4\x8f\xbf\xbf",
+  };
+  bool all_ok = true;
+  for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+    all_ok = all_ok && s_utf8_valid(valid[i], strlen(valid[i]));
+  }
+  ok(all_ok, "accepts well-formed strings");
+
+  const char *invalid[] = {
+      "\x80",             // Lone continuation
+      "caf\xc3",          // Truncated sequence
+      "\xc3\x28",         // Lead byte followed by ASCII
+      "\xc0\xaf",         // Overlong '/'
+      "\xe0\x80\xaf",     // Overlong 3-byte
+      "\xf0\x80\x80\xaf", // Overlong 4-byte
+      "\xed\xa0\x80",     // Surrogate
+      "\xf4\x90\x80\x80", // Above U+10FFFF
+      "\xf8\x88\x80\x80", // 5-byte sequence
+      "\xff",
+  };
+  all_ok = true;
+  for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    all_ok = all_ok && !s_utf8_valid(invalid[i], strlen(invalid[i]));
+  }
+  ok(all_ok, "rejects malformed strings");
+
+  eq_true(s_utf8_valid("a\0b", 3), "accepts NUL bytes");
+}
+
+static void test_s_utf8_valid_random(void) {
+  // Valid text of every sequence length, at every alignment against the
+  // vector blocks, with a random byte sometimes corrupted
+  const unsigned long code_points[] = {'a', 0xe9, 0x20ac, 0xfffd, 0x1f600,
+                                       0x10ffff, 0x7ff, 0x800, 0xd7ff};
+  unsigned char s[400];
+  bool all_ok = true;
+
+  srand(7);
+  for (int round = 0; round < 20000 && all_ok; round++) {
+    size_t len = 0;
+    size_t target = rand() % (sizeof(s) - 4);
+    bool ascii = rand() % 4 == 0;
+
+    while (len < target) {
+      unsigned long cp = ascii && rand() % 8 ? 'x' : code_points[rand() % 9];
+      len += utf8_test_encode(cp, s + len);
+    }
+
+    if (len > 0 && rand() % 2) {
+      s[rand() % len] = rand() % 256;
+    }
+
+    all_ok = s_utf8_valid((const char *)s, len) == naive_utf8_valid(s, len);
+  }
+  ok(all_ok, "agrees with a naive decoder");
+}
+
+static void test_s_utf8_len(void) {
+  const char *s = "na\xc3\xafve \xe2\x82\xac \xf0\x9f\x98\x80";
+  eq_num(s_utf8_len(s, strlen(s)), 9, "counts code points");
+
+  unsigned char long_s[300];
+  size_t len = 0;
+  for (int i = 0; i < 99; i++) {
+    len += utf8_test_encode(i % 3 ? 0xe9 : 0x20ac, long_s + len);
+  }
+  eq_num(s_utf8_len((const char *)long_s, len), 99,
+         "counts code points in a long string");
+}
+
+static void test_s_utf8_truncate(void) {
+  const char *s = "ab\xe2\x82\xac";
+
+  eq_num(s_utf8_boundary(s, 5, 3), 2, "moves back to the start of a sequence");
+  eq_num(s_utf8_boundary(s, 5, 2), 2, "keeps a boundary");
+  eq_num(s_utf8_boundary(s, 5, 9), 5, "clamps to the length");
+
+  char *ret = s_utf8_truncate(s, 4);
+  eq_str(ret, "ab", "does not split a multibyte sequence");
+  free(ret);
+
+  ret = s_utf8_truncate(s, 5);
+  eq_str(ret, s, "keeps a whole string");
+  free(ret);
+}
+
+void run_utf8_tests(void) {
+  test_s_utf8_valid();
+  test_s_utf8_valid_random();
+  test_s_utf8_len();
+  test_s_utf8_truncate();
+}